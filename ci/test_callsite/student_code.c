@@ -0,0 +1,29 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+#include "student_code.h"
+
+int save(int fd, const char *data, int len)
+{
+	if (write(fd, &len, sizeof(int)) != sizeof(int))
+		return -1;
+	if (write(fd, data, len) != len)
+		return -1;
+	return 0;
+}
+
+void log_error(int fd, const char *msg)
+{
+	write(fd, msg, strlen(msg));
+}
+
+int save_and_log(int fd, const char *data, int len)
+{
+	if (save(fd, data, len) < 0) {
+		log_error(fd, "save failed");
+		return -1;
+	}
+	return 0;
+}
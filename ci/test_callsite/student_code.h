@@ -0,0 +1,4 @@
+
+int save(int fd, const char *data, int len);
+void log_error(int fd, const char *msg);
+int save_and_log(int fd, const char *data, int len);
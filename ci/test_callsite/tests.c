@@ -0,0 +1,51 @@
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+void test_save() {
+	set_test_metadata("save", _("save writes the length then the data"), 1);
+	int fd = open("/dev/null", O_WRONLY);
+	int ret = 0;
+
+	monitored.write = true;
+	SANDBOX_BEGIN;
+	ret = save_and_log(fd, "hello", 5);
+	SANDBOX_END;
+	close(fd);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	struct callsite_stats_t s = callsite_stats("write", "save");
+	CU_ASSERT_EQUAL(s.sites, 2);
+	CU_ASSERT_EQUAL(s.called, 2);
+	CU_ASSERT_EQUAL(s.bytes, sizeof(int) + 5);
+	CU_ASSERT_EQUAL(callsite_stats("write", "log_error").called, 0);
+}
+
+void test_save_fail() {
+	set_test_metadata("save", _("save reports the failures of write"), 1);
+	int fd = open("/dev/null", O_WRONLY);
+	int ret = 0;
+
+	monitored.write = true;
+	failures.write = FAIL_SECOND;
+	failures.write_ret = -1;
+	failures.write_errno = EIO;
+	SANDBOX_BEGIN;
+	ret = save_and_log(fd, "hello", 5);
+	SANDBOX_END;
+	close(fd);
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.write.called, 3);
+	CU_ASSERT_EQUAL(callsite_stats("write", "save").failed, 1);
+	CU_ASSERT_EQUAL(callsite_stats("write", "log_error").called, 1);
+	CU_ASSERT_EQUAL(callsite_stats("write", NULL).called, 3);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_save, test_save_fail);
+}
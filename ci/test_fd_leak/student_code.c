@@ -0,0 +1,35 @@
+#include<fcntl.h>
+#include<unistd.h>
+
+#include "student_code.h"
+
+int first_byte(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	unsigned char c;
+	if (read(fd, &c, 1) != 1) {
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	return c;
+}
+
+int first_byte_leaky(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	unsigned char c;
+	if (read(fd, &c, 1) != 1)
+		return -1;
+	close(fd);
+	return c;
+}
+
+int open_log(const char *path)
+{
+	return open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+}
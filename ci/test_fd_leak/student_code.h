@@ -0,0 +1,4 @@
+
+int first_byte(const char *path);
+int first_byte_leaky(const char *path);
+int open_log(const char *path);
@@ -0,0 +1,59 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+void test_closed() {
+	set_test_metadata("first_byte", _("first_byte closes the file"), 1);
+	int ret = 0;
+
+	set_fd_leak_check(true);
+	SANDBOX_BEGIN;
+	ret = first_byte("empty.dat");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.fd.opened, 1);
+	CU_ASSERT_EQUAL(stats.fd.leaked, 0);
+}
+
+void test_leaked() {
+	set_test_metadata("first_byte", _("first_byte closes the file on errors"), 1);
+	int ret = 0;
+
+	set_fd_leak_check(true);
+	SANDBOX_BEGIN;
+	ret = first_byte_leaky("empty.dat");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.fd.leaked, 1);
+}
+
+void test_returned() {
+	set_test_metadata("open_log", _("open_log returns an open descriptor"), 1);
+	int fd = -1;
+
+	set_fd_leak_check(false);
+	SANDBOX_BEGIN;
+	fd = open_log("log.txt");
+	SANDBOX_END;
+
+	CU_ASSERT_TRUE(fd >= 0);
+	CU_ASSERT_EQUAL(stats.fd.leaked, 1);
+	struct fd_entry_t *e = fd_entry(fd);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(e);
+	CU_ASSERT_EQUAL(e->type, FD_TYPE_VFS);
+	CU_ASSERT_STRING_EQUAL(e->creator, "open");
+	close(fd);
+	CU_ASSERT_EQUAL(e->type, FD_TYPE_NONE);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	set_vfs(true);
+	vfs_create("empty.dat", NULL, 0, 0644);
+	vfs_snapshot();
+	RUN(test_closed, test_leaked, test_returned);
+}
@@ -0,0 +1,27 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+#include "student_code.h"
+
+int copy_bytewise(int in, int out)
+{
+	char c;
+	ssize_t r;
+	while ((r = read(in, &c, 1)) > 0) {
+		if (write(out, &c, 1) != 1)
+			return -1;
+	}
+	return r < 0 ? -1 : 0;
+}
+
+int copy_buffered(int in, int out)
+{
+	char buf[4096];
+	ssize_t r;
+	while ((r = read(in, buf, sizeof(buf))) > 0) {
+		if (write(out, buf, r) != r)
+			return -1;
+	}
+	return r < 0 ? -1 : 0;
+}
@@ -0,0 +1,3 @@
+
+int copy_bytewise(int in, int out);
+int copy_buffered(int in, int out);
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define DATA_LEN 3000
+
+static int make_input()
+{
+	char data[DATA_LEN];
+	char name[] = "/tmp/ctester_io_XXXXXX";
+	int fd = mkstemp(name);
+	if (fd < 0)
+		return -1;
+	unlink(name);
+	memset(data, 'a', sizeof(data));
+	if (write(fd, data, sizeof(data)) != sizeof(data)) {
+		close(fd);
+		return -1;
+	}
+	lseek(fd, 0, SEEK_SET);
+	return fd;
+}
+
+void test_bytewise() {
+	set_test_metadata("copy", _("Copying one byte per call is graded as inefficient"), 1);
+	int in = make_input();
+	int out = open("/dev/null", O_WRONLY);
+	int ret = 0;
+	CU_ASSERT_TRUE_FATAL(in >= 0 && out >= 0);
+
+	monitored.read = true;
+	monitored.write = true;
+	SANDBOX_BEGIN;
+	ret = copy_bytewise(in, out);
+	SANDBOX_END;
+	close(in);
+	close(out);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.read.io.bytes, DATA_LEN);
+	CU_ASSERT_EQUAL(stats.write.io.bytes, DATA_LEN);
+	// Only the final read, at the end of file, is short
+	CU_ASSERT_EQUAL(stats.read.io.short_calls, 1);
+	CU_ASSERT_EQUAL(stats.write.io.short_calls, 0);
+	CU_ASSERT_EQUAL(histogram_count(&stats.read.io.sizes, 1, 1), DATA_LEN);
+	CU_ASSERT(io_calls_per_kib(&stats.write.io) > 1000);
+}
+
+void test_buffered() {
+	set_test_metadata("copy", _("Copying with a buffer makes few calls"), 1);
+	int in = make_input();
+	int out = open("/dev/null", O_WRONLY);
+	int ret = 0;
+	CU_ASSERT_TRUE_FATAL(in >= 0 && out >= 0);
+
+	monitored.read = true;
+	monitored.write = true;
+	SANDBOX_BEGIN;
+	ret = copy_buffered(in, out);
+	SANDBOX_END;
+	close(in);
+	close(out);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.read.io.bytes, DATA_LEN);
+	CU_ASSERT_EQUAL(stats.write.io.bytes, DATA_LEN);
+	CU_ASSERT_EQUAL(stats.write.called, 1);
+	CU_ASSERT(io_calls_per_kib(&stats.write.io) < 1);
+	if (io_calls_per_kib(&stats.read.io) > 8) {
+		push_info_msg(_("Your code makes too many read calls"));
+		CU_FAIL();
+	}
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_bytewise, test_buffered);
+}
@@ -0,0 +1,68 @@
+#include<string.h>
+#include<unistd.h>
+#include<poll.h>
+#include<sys/socket.h>
+#include<netinet/in.h>
+
+#include "student_code.h"
+
+#define MAX_CLIENTS 32
+
+int open_server(int port)
+{
+	int sfd = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int one = 1;
+	setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (sfd < 0 || bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sfd, MAX_CLIENTS) < 0) {
+		close(sfd);
+		return -1;
+	}
+	return sfd;
+}
+
+/*
+ * Echoes the first line of nclients clients, served together.
+ */
+int serve(int sfd, int nclients)
+{
+	struct pollfd fds[MAX_CLIENTS + 1];
+	char bufs[MAX_CLIENTS + 1][64];
+	size_t lens[MAX_CLIENTS + 1];
+	int nfds = 1, accepted = 0, served = 0;
+	fds[0].fd = sfd;
+	fds[0].events = POLLIN;
+	while (served < nclients) {
+		if (poll(fds, nfds, 2000) <= 0)
+			return -1;
+		if ((fds[0].revents & POLLIN) && accepted < nclients) {
+			int cfd = accept(sfd, NULL, NULL);
+			if (cfd < 0)
+				return -1;
+			fds[nfds].fd = cfd;
+			fds[nfds].events = POLLIN;
+			lens[nfds] = 0;
+			nfds++;
+			accepted++;
+		}
+		for (int i = 1; i < nfds; i++) {
+			if (fds[i].fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP)))
+				continue;
+			ssize_t n = read(fds[i].fd, bufs[i] + lens[i], sizeof(bufs[i]) - lens[i]);
+			if (n > 0)
+				lens[i] += n;
+			if (n <= 0 || memchr(bufs[i], '\n', lens[i]) != NULL) {
+				if (n > 0)
+					write(fds[i].fd, bufs[i], lens[i]);
+				close(fds[i].fd);
+				fds[i].fd = -1;
+				served++;
+			}
+		}
+	}
+	return served;
+}
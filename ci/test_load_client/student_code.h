@@ -0,0 +1,3 @@
+
+int open_server(int port);
+int serve(int sfd, int nclients);
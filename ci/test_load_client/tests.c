@@ -0,0 +1,52 @@
+#include <stdlib.h>
+#include <sys/wait.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/util_sockets.h"
+
+void test_load() {
+	set_test_metadata("serve", _("The server serves concurrent clients"), 1);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "hello ", .data_length = 6, .type = SEND_CHUNK },
+		{ .data = "world\n", .data_length = 6, .type = SEND_CHUNK },
+		{ .data = "hello world\n", .data_length = 12, .type = RECV_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 3 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	int sfd = -1, ret = -1;
+
+	SANDBOX_BEGIN;
+	sfd = open_server(38417);
+	SANDBOX_END;
+
+	CU_ASSERT_TRUE(sfd >= 0);
+	if (sfd < 0)
+		return;
+	int client_in, client_out, cpid;
+	CU_ASSERT_EQUAL(launch_test_load_client(&all, "127.0.0.1", "38417", AF_INET, SOCK_STREAM, 8, &client_in, &client_out, &cpid), 0);
+
+	monitored.accept = true;
+	SANDBOX_BEGIN;
+	ret = serve(sfd, 8);
+	SANDBOX_END;
+
+	struct load_report_t report;
+	CU_ASSERT_EQUAL(read_load_report(client_out, &report), 0);
+	waitpid(cpid, NULL, 0);
+	close(client_in);
+	close(client_out);
+	close(sfd);
+	CU_ASSERT_EQUAL(ret, 8);
+	CU_ASSERT_EQUAL(stats.accept.called, 8);
+	CU_ASSERT_EQUAL(report.connections, 8);
+	CU_ASSERT_EQUAL(report.completed, 8);
+	CU_ASSERT_EQUAL(report.errors, 0);
+	CU_ASSERT_TRUE(report.latency_p50 <= report.latency_p99);
+	CU_ASSERT_TRUE(report.fairness > 0 && report.fairness <= 1);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_load);
+}
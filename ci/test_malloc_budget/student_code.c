@@ -0,0 +1,35 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include "student_code.h"
+
+int *copy_array(const int *tab, int n)
+{
+	int *copy = malloc(n * sizeof(int));
+	if (copy == NULL)
+		return NULL;
+	memcpy(copy, tab, n * sizeof(int));
+	return copy;
+}
+
+int *copy_array_tmp(const int *tab, int n)
+{
+	int *tmp = malloc(n * sizeof(int));
+	if (tmp == NULL)
+		return NULL;
+	memcpy(tmp, tab, n * sizeof(int));
+	int *copy = malloc(n * sizeof(int));
+	if (copy != NULL)
+		memcpy(copy, tmp, n * sizeof(int));
+	free(tmp);
+	return copy;
+}
+
+int fill_heap()
+{
+	while (1) {
+		if (malloc(1024) == NULL)
+			return -1;
+	}
+}
@@ -0,0 +1,4 @@
+
+int *copy_array(const int *tab, int n);
+int *copy_array_tmp(const int *tab, int n);
+int fill_heap();
@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define N 256
+
+int tab[N];
+
+void test_copy_array() {
+	set_test_metadata("copy_array", _("copy_array allocates only the copy"), 1);
+	int *copy = NULL;
+
+	SANDBOX_BEGIN;
+	copy = copy_array(tab, N);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(stats.memory.used, N * sizeof(int));
+	CU_ASSERT_EQUAL(stats.memory.peak, N * sizeof(int));
+	free(copy);
+}
+
+void test_copy_array_tmp() {
+	set_test_metadata("copy_array", _("copy_array allocates only the copy"), 1);
+	int *copy = NULL;
+
+	SANDBOX_BEGIN;
+	copy = copy_array_tmp(tab, N);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(stats.memory.used, N * sizeof(int));
+	if (stats.memory.peak > N * sizeof(int)) {
+		push_info_msg(_("Your code uses more heap memory than needed."));
+		CU_FAIL("Too much memory used");
+	}
+	free(copy);
+}
+
+void test_fill_heap() {
+	set_test_metadata("fill_heap", _("fill_heap stops when malloc fails"), 1);
+	int ret = 0;
+
+	set_malloc_budget(64 * 1024);
+	SANDBOX_BEGIN;
+	ret = fill_heap();
+	SANDBOX_END;
+	set_malloc_budget(0);
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.memory.used, 64 * 1024);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_copy_array, test_copy_array_tmp, test_fill_heap);
+}
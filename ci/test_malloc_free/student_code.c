@@ -0,0 +1,136 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<pthread.h>
+
+#include "student_code.h"
+
+void release(void *ptr)
+{
+	free(ptr);
+}
+
+void free_list(struct node *head)
+{
+	while (head != NULL) {
+		struct node *next = head->next;
+		free(head);
+		head = next;
+	}
+}
+
+void free_list_twice(struct node *head)
+{
+	struct node *first = head;
+	while (head != NULL) {
+		struct node *next = head->next;
+		release(head);
+		head = next;
+	}
+	release(first);
+}
+
+void free_array(int *tab)
+{
+	free(tab);
+}
+
+void free_from(int *tab, int i)
+{
+	free(tab + i);
+}
+
+int count_words(const char *str)
+{
+	char *copy = strdup(str);
+	if (copy == NULL)
+		return -1;
+	int n = 0;
+	for (char *word = strtok(copy, " "); word != NULL; word = strtok(NULL, " "))
+		n++;
+	free(copy);
+	return n;
+}
+
+void grow_and_free(char **copies)
+{
+	char *bigger = realloc(copies[0], 400000);
+	free(copies[1]);
+	free(bigger);
+}
+
+void free_big_twice(char **copies)
+{
+	free(copies[0]);
+	free(copies[1]);
+}
+
+static void *churn_thread(void *arg)
+{
+	int n = *(int *)arg;
+	for (int i = 0; i < n; i++) {
+		char *p = malloc(16 + i % 64);
+		if (p == NULL)
+			return (void *)1;
+		p[0] = 'x';
+		free(p);
+	}
+	return NULL;
+}
+
+int churn(int nthreads, int n)
+{
+	pthread_t threads[16];
+	int failed = 0;
+	for (int i = 0; i < nthreads; i++)
+		pthread_create(&threads[i], NULL, churn_thread, &n);
+	for (int i = 0; i < nthreads; i++) {
+		void *ret;
+		pthread_join(threads[i], &ret);
+		failed += (ret != NULL);
+	}
+	return failed;
+}
+
+int grow_then_dup(const char *str)
+{
+	char *buf = malloc(16);
+	if (buf == NULL)
+		return -1;
+	char *bigger = realloc(buf, 400000);
+	if (bigger == NULL) {
+		free(buf);
+		return -1;
+	}
+	// The C library may reuse the address of the old block
+	char *copy = strdup(str);
+	if (copy == NULL) {
+		free(bigger);
+		return -1;
+	}
+	int n = strlen(copy);
+	free(copy);
+	free(bigger);
+	return n;
+}
+
+int free_then_dup(char *big, const char *str)
+{
+	free(big);
+	char *copy = strdup(str);
+	if (copy == NULL)
+		return -1;
+	int n = strlen(copy);
+	free(copy);
+	return n;
+}
+
+char *volatile spin_block;
+
+void spin_alloc()
+{
+	for (;;) {
+		spin_block = malloc(8);
+		free(spin_block);
+	}
+}
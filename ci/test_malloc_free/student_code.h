@@ -0,0 +1,17 @@
+
+struct node {
+	int value;
+	struct node *next;
+};
+
+void free_list(struct node *head);
+void free_list_twice(struct node *head);
+void free_array(int *tab);
+void free_from(int *tab, int i);
+int count_words(const char *str);
+void grow_and_free(char **copies);
+void free_big_twice(char **copies);
+int churn(int nthreads, int n);
+int grow_then_dup(const char *str);
+int free_then_dup(char *big, const char *str);
+void spin_alloc();
@@ -0,0 +1,145 @@
+#include <stdlib.h>
+#include <string.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+struct node *make_list(int n)
+{
+	struct node *head = NULL;
+	for (int i = 0; i < n; i++) {
+		struct node *node = malloc(sizeof(struct node));
+		node->value = i;
+		node->next = head;
+		head = node;
+	}
+	return head;
+}
+
+void test_free_list() {
+	set_test_metadata("free_list", _("free_list frees each node once"), 1);
+	struct node *head = make_list(3);
+
+	SANDBOX_BEGIN;
+	free_list(head);
+	SANDBOX_END;
+}
+
+void test_free_list_twice() {
+	set_test_metadata("free_list", _("free_list frees each node once"), 1);
+	struct node *head = make_list(3);
+
+	SANDBOX_BEGIN;
+	free_list_twice(head);
+	SANDBOX_END;
+}
+
+void test_free_array() {
+	set_test_metadata("free_array", _("free_array only frees allocated memory"), 1);
+	int tab[4] = {1, 2, 3, 4};
+
+	SANDBOX_BEGIN;
+	free_array(tab);
+	SANDBOX_END;
+}
+
+void test_free_from() {
+	set_test_metadata("free_from", _("free_from only frees whole blocks"), 1);
+	int *tab = malloc(4 * sizeof(int));
+
+	SANDBOX_BEGIN;
+	free_from(tab, 2);
+	SANDBOX_END;
+
+	free(tab);
+}
+
+void test_count_words() {
+	set_test_metadata("count_words", _("count_words frees its copy"), 1);
+	int ret = 0;
+
+	SANDBOX_BEGIN;
+	ret = count_words("one two three");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 3);
+}
+
+void test_grow_and_free() {
+	set_test_metadata("grow_and_free", _("grow_and_free doesn't free the old block"), 1);
+	char *buf = malloc(16);
+	char *copies[2] = {buf, buf};
+
+	SANDBOX_BEGIN;
+	grow_and_free(copies);
+	SANDBOX_END;
+}
+
+void test_free_big_twice() {
+	set_test_metadata("free_big_twice", _("free_big_twice frees the block once"), 1);
+	// Too big for the quarantine
+	char *big = malloc(2 * 1024 * 1024);
+	char *copies[2] = {big, big};
+
+	SANDBOX_BEGIN;
+	free_big_twice(copies);
+	SANDBOX_END;
+}
+
+void test_churn() {
+	set_test_metadata("churn", _("Threads allocate and free concurrently"), 1);
+	int ret = -1;
+
+	SANDBOX_BEGIN;
+	ret = churn(4, 200000);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+}
+
+void test_grow_then_dup() {
+	set_test_metadata("grow_then_dup", _("Blocks moved by realloc are not confused with new ones"), 1);
+	int ret = -1;
+
+	SANDBOX_BEGIN;
+	ret = grow_then_dup("hello");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 5);
+}
+
+void test_free_then_dup() {
+	set_test_metadata("free_then_dup", _("Big freed blocks are not confused with new ones"), 1);
+	int ret = -1;
+	// Too big for the quarantine, as is its copy
+	size_t len = 2 * 1024 * 1024;
+	char *big = malloc(len);
+	char *str = malloc(len);
+	memset(str, 'a', len - 1);
+	str[len - 1] = '\0';
+
+	SANDBOX_BEGIN;
+	ret = free_then_dup(big, str);
+	SANDBOX_END;
+	free(str);
+
+	CU_ASSERT_EQUAL(ret, (int) len - 1);
+}
+
+void test_spin_alloc() {
+	set_test_metadata("spin_alloc", _("A timeout in the allocator is reported"), 1);
+
+	SANDBOX_BEGIN;
+	spin_alloc();
+	SANDBOX_END;
+
+	// The heap must still be usable
+	char *p = malloc(16);
+	CU_ASSERT_PTR_NOT_NULL(p);
+	free(p);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_free_list, test_free_list_twice, test_free_array, test_free_from, test_count_words, test_grow_and_free, test_free_big_twice, test_churn, test_grow_then_dup, test_free_then_dup, test_spin_alloc);
+}
@@ -0,0 +1,29 @@
+#include<stdio.h>
+#include<stdlib.h>
+
+#include "student_code.h"
+
+int push_one_by_one(struct vector *v, int value)
+{
+	int *data = realloc(v->data, (v->size + 1) * sizeof(int));
+	if (data == NULL)
+		return -1;
+	v->data = data;
+	v->capacity = v->size + 1;
+	v->data[v->size++] = value;
+	return 0;
+}
+
+int push_doubling(struct vector *v, int value)
+{
+	if (v->size == v->capacity) {
+		int capacity = (v->capacity == 0 ? 4 : v->capacity * 2);
+		int *data = realloc(v->data, capacity * sizeof(int));
+		if (data == NULL)
+			return -1;
+		v->data = data;
+		v->capacity = capacity;
+	}
+	v->data[v->size++] = value;
+	return 0;
+}
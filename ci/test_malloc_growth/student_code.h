@@ -0,0 +1,9 @@
+
+struct vector {
+	int *data;
+	int size;
+	int capacity;
+};
+
+int push_one_by_one(struct vector *v, int value);
+int push_doubling(struct vector *v, int value);
@@ -0,0 +1,38 @@
+#include <stdlib.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define N 1000
+
+void check_growth(int (*push)(struct vector *, int)) {
+	struct vector v = {NULL, 0, 0};
+
+	SANDBOX_BEGIN;
+	for (int i = 0; i < N; i++)
+		push(&v, i);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(v.size, N);
+	CU_ASSERT(stats.memory.realloc_grown > 0);
+	if (stats.memory.realloc_growth != GROWTH_GEOMETRIC) {
+		push_info_msg(_("Your code enlarges the array by a constant amount: pushing n elements takes a time in O(n^2)."));
+		CU_FAIL("Additive growth");
+	}
+	free(v.data);
+}
+
+void test_push_one_by_one() {
+	set_test_metadata("push", _("push enlarges the array geometrically"), 1);
+	check_growth(push_one_by_one);
+}
+
+void test_push_doubling() {
+	set_test_metadata("push", _("push enlarges the array geometrically"), 1);
+	check_growth(push_doubling);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_push_one_by_one, test_push_doubling);
+}
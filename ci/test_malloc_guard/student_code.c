@@ -0,0 +1,50 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include "student_code.h"
+
+char *dup_string(const char *s)
+{
+	char *d = malloc(strlen(s) + 1);
+	if (d == NULL)
+		return NULL;
+	strcpy(d, s);
+	return d;
+}
+
+char *dup_string_off_by_one(const char *s)
+{
+	char *d = malloc(strlen(s));
+	if (d == NULL)
+		return NULL;
+	strcpy(d, s);
+	return d;
+}
+
+int *grow_array(int n)
+{
+	int *tab = calloc(1, sizeof(int));
+	if (tab == NULL)
+		return NULL;
+	for (int i = 1; i < n; i++) {
+		int *tmp = realloc(tab, (i + 1) * sizeof(int));
+		if (tmp == NULL) {
+			free(tab);
+			return NULL;
+		}
+		tab = tmp;
+		tab[i] = i;
+	}
+	return tab;
+}
+
+int *make_array(int n)
+{
+	int *tab = malloc(n * sizeof(int));
+	if (tab == NULL && n > 0)
+		return NULL;
+	for (int i = 0; i < n; i++)
+		tab[i] = i;
+	return tab;
+}
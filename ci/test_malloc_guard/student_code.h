@@ -0,0 +1,5 @@
+
+char *dup_string(const char *s);
+char *dup_string_off_by_one(const char *s);
+int *grow_array(int n);
+int *make_array(int n);
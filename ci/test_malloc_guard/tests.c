@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include <string.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+void test_dup_string() {
+	set_test_metadata("dup_string", _("dup_string copies the string"), 1);
+	char *ret = NULL;
+
+	set_malloc_guard(true, TRAP_RIGHT, 1);
+	SANDBOX_BEGIN;
+	ret = dup_string("Hello");
+	SANDBOX_END;
+	set_malloc_guard(false, TRAP_RIGHT, 1);
+
+	CU_ASSERT_TRUE(ret != NULL && strcmp(ret, "Hello") == 0);
+	free(ret);
+}
+
+void test_dup_string_overflow() {
+	set_test_metadata("dup_string", _("dup_string doesn't overflow the allocated block"), 1);
+	char *ret = NULL;
+
+	set_malloc_guard(true, TRAP_RIGHT, 1);
+	SANDBOX_BEGIN;
+	ret = dup_string_off_by_one("Hello");
+	SANDBOX_END;
+	set_malloc_guard(false, TRAP_RIGHT, 1);
+
+	CU_ASSERT_EQUAL(ret, NULL);
+}
+
+void test_grow_array() {
+	set_test_metadata("grow_array", _("grow_array keeps the content when growing"), 1);
+	int *ret = NULL;
+
+	monitored.malloc = monitored.calloc = monitored.realloc = monitored.free = true;
+	set_malloc_guard(true, TRAP_RIGHT, sizeof(int));
+	for (int k = 0; k < 3; k++) {
+		SANDBOX_BEGIN;
+		ret = grow_array(2000);
+		SANDBOX_END;
+		CU_ASSERT_TRUE_FATAL(ret != NULL);
+		for (int i = 0; i < 2000; i++)
+			CU_ASSERT_EQUAL(ret[i], i);
+		free(ret);
+	}
+	set_malloc_guard(false, TRAP_RIGHT, 1);
+	CU_ASSERT_EQUAL(stats.realloc.called, 3 * 1999);
+}
+
+void test_empty_array() {
+	set_test_metadata("make_array", _("Empty blocks are given back to the arena"), 1);
+	int *first = NULL, *second = NULL;
+
+	set_malloc_guard(true, TRAP_RIGHT, 1);
+	SANDBOX_BEGIN;
+	first = make_array(0);
+	SANDBOX_END;
+	CU_ASSERT_PTR_NOT_NULL_FATAL(first);
+	free(first);
+	// The freed slot is the first one reused
+	SANDBOX_BEGIN;
+	second = make_array(0);
+	SANDBOX_END;
+	set_malloc_guard(false, TRAP_RIGHT, 1);
+
+	CU_ASSERT_PTR_EQUAL(second, first);
+	free(second);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_dup_string, test_dup_string_overflow, test_grow_array, test_empty_array);
+}
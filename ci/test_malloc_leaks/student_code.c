@@ -0,0 +1,32 @@
+#include<stdio.h>
+#include<stdlib.h>
+
+#include "student_code.h"
+
+struct node *make_node(int value, struct node *next)
+{
+	struct node *n = malloc(sizeof(struct node));
+	if (n == NULL)
+		return NULL;
+	n->value = value;
+	n->next = next;
+	return n;
+}
+
+struct node *build_list(int n)
+{
+	struct node *head = NULL;
+	for (int i = 0; i < n; i++)
+		head = make_node(i, head);
+	return head;
+}
+
+void free_list(struct node *head)
+{
+	// Forgets the last node
+	while (head != NULL && head->next != NULL) {
+		struct node *next = head->next;
+		free(head);
+		head = next;
+	}
+}
@@ -0,0 +1,8 @@
+
+struct node {
+	int value;
+	struct node *next;
+};
+
+struct node *build_list(int n);
+void free_list(struct node *head);
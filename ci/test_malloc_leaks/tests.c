@@ -0,0 +1,25 @@
+#include <stdlib.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+void test_no_leak() {
+	set_test_metadata("free_list", _("free_list frees the whole list"), 1);
+
+	monitored.malloc = true;
+	monitored.free = true;
+	set_malloc_backtrace(true);
+	SANDBOX_BEGIN;
+	struct node *head = build_list(3);
+	free_list(head);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(stats.malloc.called, 3);
+	CU_ASSERT_EQUAL(stats.free.called, 2);
+	CU_ASSERT_EQUAL(report_malloc_leaks(), 0);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_no_leak);
+}
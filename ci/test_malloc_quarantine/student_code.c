@@ -0,0 +1,36 @@
+#include<stdio.h>
+#include<stdlib.h>
+
+#include "student_code.h"
+
+void release(struct node *n)
+{
+	free(n);
+}
+
+int pop_correct(struct node **head)
+{
+	struct node *first = *head;
+	int value = first->value;
+	*head = first->next;
+	free(first);
+	return value;
+}
+
+int pop_write_after_free(struct node **head)
+{
+	struct node *first = *head;
+	int value = first->value;
+	*head = first->next;
+	release(first);
+	first->next = NULL;
+	return value;
+}
+
+int pop_read_after_free(struct node **head)
+{
+	struct node *first = *head;
+	*head = first->next;
+	release(first);
+	return first->value;
+}
@@ -0,0 +1,9 @@
+
+struct node {
+	int value;
+	struct node *next;
+};
+
+int pop_correct(struct node **head);
+int pop_write_after_free(struct node **head);
+int pop_read_after_free(struct node **head);
@@ -0,0 +1,68 @@
+#include <stdlib.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+struct node *make_list()
+{
+	struct node *second = malloc(sizeof(struct node));
+	struct node *first = malloc(sizeof(struct node));
+	second->value = 2;
+	second->next = NULL;
+	first->value = 1;
+	first->next = second;
+	return first;
+}
+
+void test_pop_correct() {
+	set_test_metadata("pop", _("pop frees the first node"), 1);
+	struct node *head = make_list();
+	int ret = 0;
+
+	set_malloc_quarantine(true, 0);
+	SANDBOX_BEGIN;
+	ret = pop_correct(&head);
+	SANDBOX_END;
+	set_malloc_quarantine(false, 0);
+
+	CU_ASSERT_EQUAL(ret, 1);
+	free(head);
+}
+
+void test_pop_write_after_free() {
+	set_test_metadata("pop", _("pop doesn't modify the node after freeing it"), 1);
+	struct node *head = make_list();
+	int ret = 0;
+
+	set_malloc_quarantine(true, 0);
+	SANDBOX_BEGIN;
+	ret = pop_write_after_free(&head);
+	SANDBOX_END;
+	set_malloc_quarantine(false, 0);
+
+	CU_ASSERT_EQUAL(ret, 1);
+	free(head);
+}
+
+void test_pop_read_after_free() {
+	set_test_metadata("pop", _("pop doesn't read the node after freeing it"), 1);
+	struct node *head = NULL;
+	int ret = 0;
+
+	set_malloc_guard(true, TRAP_RIGHT, sizeof(void *));
+	set_malloc_quarantine(true, 0);
+	SANDBOX_BEGIN;
+	head = make_list();
+	ret = pop_read_after_free(&head);
+	SANDBOX_END;
+	set_malloc_quarantine(false, 0);
+	set_malloc_guard(false, TRAP_RIGHT, 1);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	free(head);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_pop_correct, test_pop_write_after_free, test_pop_read_after_free);
+}
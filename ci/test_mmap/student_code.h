@@ -0,0 +1,2 @@
+
+long sum_file(const char *path, int unmap);
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define NPAGES 16
+
+static const char *path = "data.bin";
+static size_t file_size;
+
+// Each test gets a copy of data.bin in its scratch directory
+static int make_file()
+{
+	file_size = NPAGES * sysconf(_SC_PAGESIZE);
+	char *data = malloc(file_size);
+	if (data == NULL || set_scratch_dir(true) < 0)
+		return -1;
+	memset(data, 1, file_size);
+	int ret = scratch_fixture(path, data, file_size, 0644);
+	free(data);
+	return ret;
+}
+
+void test_sum() {
+	set_test_metadata("sum_file", _("sum_file maps the file and unmaps it"), 1);
+	long sum = 0;
+
+	monitored.mmap = true;
+	monitored.munmap = true;
+	SANDBOX_BEGIN;
+	sum = sum_file(path, 1);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(sum, (long)file_size);
+	CU_ASSERT_EQUAL(stats.mmap.called, 1);
+	CU_ASSERT_EQUAL(stats.mmap.bytes, file_size);
+	CU_ASSERT_EQUAL(stats.munmap.called, 1);
+	CU_ASSERT_EQUAL(stats.mapping.live, 0);
+	CU_ASSERT_EQUAL(stats.mapping.leaked, 0);
+	CU_ASSERT_EQUAL(stats.mapping.touched_pages, NPAGES);
+}
+
+void test_leak() {
+	set_test_metadata("sum_file", _("A mapping left at the end is a leak"), 1);
+	long sum = 0;
+
+	monitored.mmap = true;
+	SANDBOX_BEGIN;
+	sum = sum_file(path, 0);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(sum, (long)file_size);
+	CU_ASSERT_EQUAL(stats.mapping.leaked, 1);
+	CU_ASSERT_EQUAL(stats.mapping.leaked_bytes, file_size);
+	CU_ASSERT_EQUAL(stats.mapping.touched_pages, NPAGES);
+	munmap(stats.mmap.last_return, file_size);
+	CU_ASSERT_EQUAL(stats.mapping.live, 0);
+}
+
+void test_fail() {
+	set_test_metadata("sum_file", _("sum_file reports the failures of mmap"), 1);
+	long sum = 0;
+
+	monitored.mmap = true;
+	failures.mmap = FAIL_FIRST;
+	failures.mmap_ret = MAP_FAILED;
+	failures.mmap_errno = ENOMEM;
+	SANDBOX_BEGIN;
+	sum = sum_file(path, 1);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(sum, -1);
+	CU_ASSERT_EQUAL(callsite_stats("mmap", "sum_file").failed, 1);
+	CU_ASSERT_EQUAL(stats.mapping.leaked, 0);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	if (make_file() < 0)
+		return 1;
+	RUN(test_sum, test_leak, test_fail);
+}
@@ -0,0 +1,23 @@
+#include<string.h>
+#include<sys/socket.h>
+#include<sys/uio.h>
+
+#include "student_code.h"
+
+ssize_t recv_datagram(int fd, char *buf, size_t len, struct sockaddr_in *from)
+{
+	socklen_t fromlen = sizeof(*from);
+	return recvfrom(fd, buf, len, 0, (struct sockaddr *)from, &fromlen);
+}
+
+ssize_t recv_message(int fd, char *buf, size_t len, int *truncated)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = len };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	ssize_t n = recvmsg(fd, &msg, MSG_TRUNC);
+	*truncated = (msg.msg_flags & MSG_TRUNC) != 0;
+	return n;
+}
@@ -0,0 +1,7 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+
+ssize_t recv_datagram(int fd, char *buf, size_t len, struct sockaddr_in *from);
+ssize_t recv_message(int fd, char *buf, size_t len, int *truncated);
@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FD 42
+
+static struct sockaddr_in peers[3];
+
+static void make_datagrams(struct read_buffer_t *rbuf, struct read_bufchunk_t *chunks)
+{
+	static const char *data[3] = {"one", "three", "fifteen"};
+	for (int i = 0; i < 3; i++) {
+		memset(&peers[i], 0, sizeof(peers[i]));
+		peers[i].sin_family = AF_INET;
+		peers[i].sin_port = htons(5000 + i);
+		peers[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		chunks[i] = (struct read_bufchunk_t) {
+			.interval = 1,
+			.buf = data[i],
+			.buflen = strlen(data[i]),
+			.addr = (struct sockaddr *)&peers[i],
+			.addrlen = sizeof(peers[i])
+		};
+	}
+	rbuf->mode = READ_WRITE_BEFORE_INTERVAL | READ_WRITE_DATAGRAM;
+	rbuf->nchunks = 3;
+	rbuf->chunks = chunks;
+}
+
+void test_boundaries() {
+	set_test_metadata("recv_datagram", _("Each recvfrom returns one datagram and its sender"), 1);
+	struct read_bufchunk_t chunks[3];
+	struct read_buffer_t rbuf;
+	make_datagrams(&rbuf, chunks);
+	CU_ASSERT_EQUAL(set_read_buffer(FD, &rbuf), 0);
+	char buf[3][16];
+	struct sockaddr_in from[3];
+	ssize_t ret[4];
+	int err = 0;
+
+	monitored.recvfrom = true;
+	SANDBOX_BEGIN;
+	for (int i = 0; i < 3; i++)
+		ret[i] = recv_datagram(FD, buf[i], sizeof(buf[i]), &from[i]);
+	ret[3] = recv_datagram(FD, buf[0], sizeof(buf[0]), &from[0]);
+	err = errno;
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret[0], 3);
+	CU_ASSERT_EQUAL(ret[1], 5);
+	CU_ASSERT_EQUAL(ret[2], 7);
+	CU_ASSERT_EQUAL(ret[3], -1);
+	CU_ASSERT_EQUAL(err, EAGAIN);
+	CU_ASSERT_EQUAL(memcmp(buf[1], "three", 5), 0);
+	CU_ASSERT_EQUAL(ntohs(from[1].sin_port), 5001);
+	CU_ASSERT_EQUAL(ntohs(from[2].sin_port), 5002);
+	CU_ASSERT_EQUAL(ntohs(from[0].sin_port), 5000);
+	set_read_buffer(FD, NULL);
+}
+
+void test_truncation() {
+	set_test_metadata("recv_message", _("A datagram larger than the buffer is truncated"), 1);
+	struct read_bufchunk_t chunks[3];
+	struct read_buffer_t rbuf;
+	make_datagrams(&rbuf, chunks);
+	set_read_buffer(FD, &rbuf);
+	char buf[4];
+	ssize_t first = 0, second = 0;
+	int trunc1 = 0, trunc2 = 0;
+
+	monitored.recvmsg = true;
+	SANDBOX_BEGIN;
+	first = recv_message(FD, buf, sizeof(buf), &trunc1);
+	second = recv_message(FD, buf, sizeof(buf), &trunc2);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(first, 3);
+	CU_ASSERT_FALSE(trunc1);
+	// The real length of the datagram, of which 4 bytes were received
+	CU_ASSERT_EQUAL(second, 5);
+	CU_ASSERT_TRUE(trunc2);
+	CU_ASSERT_EQUAL(memcmp(buf, "thre", 4), 0);
+	// The rest of the datagram is discarded
+	CU_ASSERT_EQUAL(get_bytes_read(FD), 3 + 5);
+	set_read_buffer(FD, NULL);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_boundaries, test_truncation);
+}
@@ -0,0 +1,6 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+
+long count_lines(int fd);
+ssize_t peek_then_recv(int fd, char *buf, size_t len);
@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FD 42
+
+struct lines_t {
+	size_t count; // Number of lines of the stream
+	size_t calls; // Number of calls of the generator
+	char line[32]; // Memory reused by all the chunks
+};
+
+static int generate_line(void *arg, size_t chunk_id, struct read_bufchunk_t *chunk)
+{
+	struct lines_t *lines = arg;
+	lines->calls++;
+	if (chunk_id >= lines->count)
+		return 0;
+	int n = snprintf(lines->line, sizeof(lines->line), "line %zu\n", chunk_id);
+	chunk->buf = lines->line;
+	chunk->buflen = n;
+	return 1;
+}
+
+void test_stream() {
+	set_test_metadata("count_lines", _("A long generated stream is read until its end"), 1);
+	struct lines_t lines = { .count = 200000, .calls = 0 };
+	struct read_buffer_t *rbuf = create_generated_read_buffer(generate_line, &lines, READ_WRITE_BEFORE_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	CU_ASSERT_EQUAL(set_read_buffer(FD, rbuf), 0);
+	// No chunk is generated before it is needed
+	CU_ASSERT_EQUAL(lines.calls, 0);
+	long ret = 0;
+
+	monitored.read = true;
+	SANDBOX_BEGIN;
+	ret = count_lines(FD);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 200000);
+	// One call per line, and the one signaling the end
+	CU_ASSERT_EQUAL(lines.calls, 200000 + 1);
+	size_t total = 0;
+	for (size_t i = 0; i < 200000; i++)
+		total += snprintf(NULL, 0, "line %zu\n", i);
+	CU_ASSERT_EQUAL(get_bytes_read(FD), (ssize_t)total);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+}
+
+void test_peek() {
+	set_test_metadata("peek_then_recv", _("A peek doesn't generate the following chunks"), 1);
+	struct lines_t lines = { .count = 3, .calls = 0 };
+	struct read_buffer_t *rbuf = create_generated_read_buffer(generate_line, &lines, READ_WRITE_BEFORE_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	set_read_buffer(FD, rbuf);
+	char buf[64];
+	ssize_t ret = 0;
+
+	monitored.recv = true;
+	SANDBOX_BEGIN;
+	ret = peek_then_recv(FD, buf, sizeof(buf));
+	SANDBOX_END;
+
+	// Both calls stop at the end of the first chunk
+	CU_ASSERT_EQUAL(ret, 7);
+	CU_ASSERT_EQUAL(memcmp(buf, "line 0\n", 7), 0);
+	CU_ASSERT_EQUAL(lines.calls, 1);
+	CU_ASSERT_EQUAL(get_bytes_read(FD), 7);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_stream, test_peek);
+}
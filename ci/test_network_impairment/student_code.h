@@ -0,0 +1,5 @@
+
+#include <stddef.h>
+
+int open_receiver(int port);
+int receive_all(int fd, char *out, int n);
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/util_sockets.h"
+
+void test_impaired() {
+	set_test_metadata("receive_all", _("The receiver copes with duplicated and reordered datagrams"), 1);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "0:a", .data_length = 3, .type = SEND_CHUNK },
+		{ .data = "1:b", .data_length = 3, .type = SEND_CHUNK },
+		{ .data = "2:c", .data_length = 3, .type = SEND_CHUNK },
+		{ .data = "3:d", .data_length = 3, .type = SEND_CHUNK },
+		{ .data = "4:e", .data_length = 3, .type = SEND_CHUNK },
+		{ .data = "5:f", .data_length = 3, .type = SEND_CHUNK }
+	};
+	struct cs_network_impairment impairment = {
+		.seed = 7,
+		.delay_min = 0,
+		.delay_max = 50,
+		.duplicate = 500,
+		.reorder = 500,
+		.virtual_clock = true
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 6, .impairment = &impairment };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	int fd = -1, ret = -1;
+	char out[7] = {0};
+
+	SANDBOX_BEGIN;
+	fd = open_receiver(38418);
+	SANDBOX_END;
+
+	CU_ASSERT_TRUE(fd >= 0);
+	if (fd < 0)
+		return;
+	int client_in, client_out, cpid;
+	CU_ASSERT_EQUAL(launch_test_udp_client(&all, "127.0.0.1", "38418", AF_INET, &client_in, &client_out, &cpid), 0);
+
+	monitored.recv = true;
+	SANDBOX_BEGIN;
+	ret = receive_all(fd, out, 6);
+	SANDBOX_END;
+
+	uint8_t status = 0xff;
+	CU_ASSERT_EQUAL(read(client_out, &status, sizeof(status)), 1);
+	waitpid(cpid, NULL, 0);
+	close(client_in);
+	close(client_out);
+	close(fd);
+	CU_ASSERT_EQUAL(status, OK);
+	CU_ASSERT_STRING_EQUAL(out, "abcdef");
+	// Some datagrams were duplicated
+	CU_ASSERT_TRUE(ret > 6);
+	CU_ASSERT_EQUAL(stats.recv.called, ret);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_impaired);
+}
@@ -0,0 +1,17 @@
+#include<sys/socket.h>
+
+#include "student_code.h"
+
+ssize_t recv_all(int fd, char *buf, size_t len)
+{
+	size_t done = 0;
+	while (done < len) {
+		ssize_t n = recv(fd, buf + done, len - done, 0);
+		if (n < 0)
+			return -1;
+		if (n == 0)
+			break;
+		done += n;
+	}
+	return done;
+}
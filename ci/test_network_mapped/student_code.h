@@ -0,0 +1,5 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+
+ssize_t recv_all(int fd, char *buf, size_t len);
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FD 42
+#define LEN 10000
+
+static char data[LEN];
+
+static void write_file(const char *path, const void *buf, size_t len)
+{
+	FILE *f = fopen(path, "w");
+	CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+	CU_ASSERT_EQUAL(fwrite(buf, 1, len, f), len);
+	fclose(f);
+}
+
+/*
+ * Reads the whole mapped file of data through recv_all, and returns the
+ * number of calls to recv, including the last one returning 0.
+ */
+static int recv_file(const struct read_split_t *split)
+{
+	for (int i = 0; i < LEN; i++)
+		data[i] = 'a' + (i * 7) % 26;
+	write_file("mapped_data", data, LEN);
+	struct read_buffer_t *rbuf = create_mapped_read_buffer("mapped_data", split, READ_WRITE_BEFORE_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	CU_ASSERT_EQUAL(set_read_buffer(FD, rbuf), 0);
+	char *buf = malloc(LEN + 1);
+	ssize_t ret = 0;
+	int calls = stats.recv.called;
+
+	monitored.recv = true;
+	SANDBOX_BEGIN;
+	ret = recv_all(FD, buf, LEN + 1);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, LEN);
+	CU_ASSERT_EQUAL(memcmp(buf, data, LEN), 0);
+	CU_ASSERT_EQUAL(get_bytes_read(FD), LEN);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+	free(buf);
+	remove("mapped_data");
+	return stats.recv.called - calls;
+}
+
+void test_fixed() {
+	set_test_metadata("recv_all", _("A mapped file is split into chunks of a fixed size"), 1);
+	struct read_split_t split = { .rule = READ_SPLIT_FIXED, .min_size = 1000 };
+	CU_ASSERT_EQUAL(recv_file(&split), 10 + 1);
+}
+
+void test_random() {
+	set_test_metadata("recv_all", _("The random split of a mapped file depends only on the seed"), 1);
+	struct read_split_t split = { .rule = READ_SPLIT_RANDOM, .min_size = 100, .max_size = 400, .seed = 1234 };
+	int first = recv_file(&split);
+	CU_ASSERT(first >= 25 + 1);
+	CU_ASSERT(first <= 100 + 1);
+	CU_ASSERT_EQUAL(recv_file(&split), first);
+}
+
+void test_sizes() {
+	set_test_metadata("recv_all", _("A mapped file is split by the sizes listed in a file"), 1);
+	// The zero sizes are skipped
+	const char *sizes = "3000 0 5000\n0\n1000\n0\n";
+	write_file("mapped_sizes", sizes, strlen(sizes));
+	struct read_split_t split = { .rule = READ_SPLIT_SIZES, .sizes_path = "mapped_sizes" };
+	// 3000, 5000, 1000 and the last 1000 bytes
+	CU_ASSERT_EQUAL(recv_file(&split), 4 + 1);
+	remove("mapped_sizes");
+}
+
+void test_invalid() {
+	set_test_metadata("recv_all", _("An invalid split is rejected"), 1);
+	struct read_split_t split = { .rule = READ_SPLIT_RANDOM, .min_size = 10, .max_size = 5 };
+	CU_ASSERT_PTR_NULL(create_mapped_read_buffer("mapped_data", &split, READ_WRITE_BEFORE_INTERVAL));
+	split.rule = READ_SPLIT_FIXED;
+	split.min_size = 0;
+	CU_ASSERT_PTR_NULL(create_mapped_read_buffer("mapped_data", &split, READ_WRITE_BEFORE_INTERVAL));
+	SANDBOX_BEGIN;
+	SANDBOX_END;
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_fixed, test_random, test_sizes, test_invalid);
+}
@@ -23,19 +23,6 @@
 
 void __real_exit(int status); // Needed as otherwise we'll get a segfault
 
-struct read_fd_table_t {
-	size_t n;
-	struct read_item *items;
-};
-struct read_item {
-	int fd;
-	const struct read_buffer_t *buf;
-	unsigned int chunk_id;
-	size_t bytes_read;
-	struct timespec last_time;
-	int64_t interval;
-};
-
 bool timespec_is_between(const struct timespec *a, const struct timespec *min, const struct timespec *max)
 {
 	int64_t mint = min->tv_sec;
@@ -50,10 +37,6 @@ bool timespec_is_between(const struct timespec *a, const struct timespec *min, c
 	return (mint <= at && at <= maxt);
 }
 
-extern struct read_fd_table_t read_fd_table;
-
-struct read_item;
-
 extern bool fd_is_read_buffered(int fd);
 
 extern ssize_t read_handle_buffer(int fd, void *buf, size_t len, int flags);
@@ -86,8 +69,7 @@ void test_fragmented_recv()
 	MONITOR_ALL_RECV(monitored, true);
 	reinit_network_socket_stats();
 	reinit_read_fd_table();
-	CU_ASSERT_EQUAL(read_fd_table.n, 0); // "read_fd_table is not empty"
-	CU_ASSERT_EQUAL(read_fd_table.items, NULL); // "read_fd_table is not empty"
+	CU_ASSERT_EQUAL(read_fd_count(), 0); // "read_fd_table is not empty"
 	size_t tab1len = 1000;
 	char *tab1 = malloc(tab1len);
 	if (!tab1)
@@ -157,14 +139,14 @@ void test_fragmented_recv()
 	};
 	int fd1 = 17, fd2 = 42, fd3 = 0;
 	CU_ASSERT_EQUAL(set_read_buffer(fd1, &rbuf1), 0);
-	CU_ASSERT_EQUAL(read_fd_table.n, 1);
+	CU_ASSERT_EQUAL(read_fd_count(), 1);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd1));
 	CU_ASSERT_EQUAL(set_read_buffer(fd2, NULL), 0);
-	CU_ASSERT_EQUAL(read_fd_table.n, 1);
+	CU_ASSERT_EQUAL(read_fd_count(), 1);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd1));
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd2));
 	CU_ASSERT_EQUAL(set_read_buffer(fd1, NULL), 1);
-	CU_ASSERT_EQUAL(read_fd_table.n, 0);
+	CU_ASSERT_EQUAL(read_fd_count(), 0);
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd1));
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd2));
 
@@ -172,74 +154,72 @@ void test_fragmented_recv()
 	CU_ASSERT_EQUAL_FATAL(clock_gettime(CLOCK_REALTIME, &beforets1), 0);
 	CU_ASSERT_EQUAL_FATAL(set_read_buffer(fd1, &rbuf1), 0);
 	CU_ASSERT_EQUAL_FATAL(clock_gettime(CLOCK_REALTIME, &afterts1), 0);
-	CU_ASSERT_EQUAL(read_fd_table.n, 1);
+	CU_ASSERT_EQUAL(read_fd_count(), 1);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd1));
 
 	CU_ASSERT_EQUAL(set_read_buffer(fd2, &rbuf1), 0);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd2));
-	CU_ASSERT_EQUAL(read_fd_table.n, 2);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].buf, &rbuf1);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].fd, fd1);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].buf, &rbuf1);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].fd, fd2);
+	CU_ASSERT_EQUAL(read_fd_count(), 2);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->buf, &rbuf1);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->fd, fd1);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->buf, &rbuf1);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->fd, fd2);
 
 	CU_ASSERT_EQUAL_FATAL(clock_gettime(CLOCK_REALTIME, &beforets3), 0);
 	CU_ASSERT_EQUAL(set_read_buffer(fd3, &rbuf3), 0);
 	CU_ASSERT_EQUAL_FATAL(clock_gettime(CLOCK_REALTIME, &afterts3), 0);
-	CU_ASSERT_EQUAL(read_fd_table.n, 3);
+	CU_ASSERT_EQUAL(read_fd_count(), 3);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd3));
-	CU_ASSERT_EQUAL(read_fd_table.items[0].buf, &rbuf1);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].fd, fd1);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].buf, &rbuf1);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].fd, fd2);
-	CU_ASSERT_EQUAL(read_fd_table.items[2].buf, &rbuf3);
-	CU_ASSERT_EQUAL(read_fd_table.items[2].fd, fd3);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->buf, &rbuf1);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->fd, fd1);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->buf, &rbuf1);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->fd, fd2);
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->buf, &rbuf3);
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->fd, fd3);
 
 	CU_ASSERT_EQUAL(set_read_buffer(fd2, &rbuf2), 1);
-	CU_ASSERT_EQUAL(read_fd_table.n, 3);
+	CU_ASSERT_EQUAL(read_fd_count(), 3);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd2));
 	CU_ASSERT_EQUAL(set_read_buffer(fd2, NULL), 1);
-	CU_ASSERT_EQUAL(read_fd_table.n, 2);
+	CU_ASSERT_EQUAL(read_fd_count(), 2);
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd2));
 	CU_ASSERT_EQUAL(set_read_buffer(fd2, NULL), 0);
-	CU_ASSERT_EQUAL(read_fd_table.n, 2);
+	CU_ASSERT_EQUAL(read_fd_count(), 2);
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd2));
 	CU_ASSERT_EQUAL(clock_gettime(CLOCK_REALTIME, &beforets2), 0);
 	CU_ASSERT_EQUAL(set_read_buffer(fd2, &rbuf2), 0);
 	CU_ASSERT_EQUAL(clock_gettime(CLOCK_REALTIME, &afterts2), 0);
-	CU_ASSERT_EQUAL(read_fd_table.n, 3);
+	CU_ASSERT_EQUAL(read_fd_count(), 3);
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd1));
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd2));
 	CU_ASSERT_TRUE(fd_is_read_buffered(fd3));
 
-	CU_ASSERT_EQUAL(read_fd_table.items[0].fd, fd1);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].buf, &rbuf1);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].chunk_id, 0);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].bytes_read, 0);
-	CU_ASSERT_EQUAL(read_fd_table.items[0].interval, 0);
-	CU_ASSERT_TRUE(timespec_is_between(&(read_fd_table.items[0].last_time), &beforets1, &afterts1));
-
-	CU_ASSERT_EQUAL(read_fd_table.items[2].fd, fd2);
-	CU_ASSERT_EQUAL(read_fd_table.items[2].buf, &rbuf2);
-	CU_ASSERT_EQUAL(read_fd_table.items[2].chunk_id, 0);
-	CU_ASSERT_EQUAL(read_fd_table.items[2].bytes_read, 0);
-	CU_ASSERT_EQUAL(read_fd_table.items[2].interval, 0);
-	CU_ASSERT_TRUE(timespec_is_between(&(read_fd_table.items[2].last_time), &beforets2, &afterts2));
-
-	CU_ASSERT_EQUAL(read_fd_table.items[1].fd, fd3);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].buf, &rbuf3);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].chunk_id, 0);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].bytes_read, 0);
-	fprintf(stderr, "%lld %lld\n", (long long)read_fd_table.items[1].interval, (long long)rbuf3.chunks[0].interval);
-	CU_ASSERT_EQUAL(read_fd_table.items[1].interval, rbuf3.chunks[0].interval * MILLION);
-	CU_ASSERT_TRUE(timespec_is_between(&(read_fd_table.items[1].last_time), &beforets3, &afterts3));
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->fd, fd1);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->buf, &rbuf1);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->chunk_id, 0);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->bytes_read, 0);
+	CU_ASSERT_EQUAL(read_get_entry(fd1)->interval, 0);
+	CU_ASSERT_TRUE(timespec_is_between(&(read_get_entry(fd1)->last_time), &beforets1, &afterts1));
+
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->fd, fd2);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->buf, &rbuf2);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->chunk_id, 0);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->bytes_read, 0);
+	CU_ASSERT_EQUAL(read_get_entry(fd2)->interval, 0);
+	CU_ASSERT_TRUE(timespec_is_between(&(read_get_entry(fd2)->last_time), &beforets2, &afterts2));
+
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->fd, fd3);
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->buf, &rbuf3);
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->chunk_id, 0);
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->bytes_read, 0);
+	CU_ASSERT_EQUAL(read_get_entry(fd3)->interval, rbuf3.chunks[0].interval * MILLION);
+	CU_ASSERT_TRUE(timespec_is_between(&(read_get_entry(fd3)->last_time), &beforets3, &afterts3));
 	CU_ASSERT_EQUAL(set_read_buffer(fd3, NULL), 1); // We don't need it
-	CU_ASSERT_EQUAL(read_fd_table.n, 2);
+	CU_ASSERT_EQUAL(read_fd_count(), 2);
 	// Correctly set up of the tests: done
 	// Now, all we have to do is recv the data :-)
 	reinit_read_fd_table();
-	CU_ASSERT_EQUAL(read_fd_table.items, NULL);
-	CU_ASSERT_EQUAL(read_fd_table.n, 0);
+	CU_ASSERT_EQUAL(read_fd_count(), 0);
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd1));
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd2));
 	CU_ASSERT_FALSE(fd_is_read_buffered(fd3));
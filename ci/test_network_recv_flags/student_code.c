@@ -0,0 +1,35 @@
+#include<sys/socket.h>
+#include<sys/uio.h>
+
+#include "student_code.h"
+
+ssize_t recv_exact(int fd, char *buf, size_t len)
+{
+	return recv(fd, buf, len, MSG_WAITALL);
+}
+
+int peek_type(int fd)
+{
+	char c;
+	if (recv(fd, &c, 1, MSG_PEEK) != 1)
+		return -1;
+	return c;
+}
+
+ssize_t recv_record(int fd, char *hdr, size_t hdrlen, char *body, size_t bodylen)
+{
+	struct iovec iov[2] = {
+		{ .iov_base = hdr, .iov_len = hdrlen },
+		{ .iov_base = body, .iov_len = bodylen }
+	};
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = 2
+	};
+	return recvmsg(fd, &msg, MSG_WAITALL);
+}
+
+ssize_t recv_urgent(int fd, char *c)
+{
+	return recv(fd, c, 1, MSG_OOB);
+}
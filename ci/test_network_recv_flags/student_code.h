@@ -0,0 +1,8 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+
+ssize_t recv_exact(int fd, char *buf, size_t len);
+int peek_type(int fd);
+ssize_t recv_record(int fd, char *hdr, size_t hdrlen, char *body, size_t bodylen);
+ssize_t recv_urgent(int fd, char *c);
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FD 42
+
+static char data[] = "Tthe header, then the body of the record";
+
+static struct read_buffer_t *fragmented(int mode)
+{
+	off_t offsets[] = {1, 4, 7, 9, 19};
+	int intervals[] = {1, 2, 2, 1, 2};
+	return create_read_buffer(data, 5, offsets, intervals, mode);
+}
+
+void test_waitall() {
+	set_test_metadata("recv_exact", _("MSG_WAITALL reads across the chunks"), 1);
+	struct read_buffer_t *rbuf = fragmented(READ_WRITE_BEFORE_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	set_read_buffer(FD, rbuf);
+	char buf[sizeof(data)];
+	ssize_t ret = 0, last = 0;
+
+	monitored.recv = true;
+	SANDBOX_BEGIN;
+	ret = recv_exact(FD, buf, 30);
+	last = recv_exact(FD, buf + 30, 30);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 30);
+	// Only the end of the data is left
+	CU_ASSERT_EQUAL(last, 10);
+	CU_ASSERT_EQUAL(memcmp(buf, data, 40), 0);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+}
+
+void test_peek() {
+	set_test_metadata("peek_type", _("MSG_PEEK doesn't consume the data"), 1);
+	struct read_buffer_t *rbuf = fragmented(READ_WRITE_REAL_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	set_read_buffer(FD, rbuf);
+	int first = 0, second = 0;
+
+	monitored.recv = true;
+	SANDBOX_BEGIN;
+	first = peek_type(FD);
+	second = peek_type(FD);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(first, 'T');
+	CU_ASSERT_EQUAL(second, 'T');
+	CU_ASSERT_EQUAL(get_bytes_read(FD), 0);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+}
+
+void test_recvmsg() {
+	set_test_metadata("recv_record", _("recvmsg scatters the data into the iovecs"), 1);
+	struct read_buffer_t *rbuf = fragmented(READ_WRITE_AFTER_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	set_read_buffer(FD, rbuf);
+	char hdr[12], body[28];
+	ssize_t ret = 0;
+
+	monitored.recvmsg = true;
+	SANDBOX_BEGIN;
+	ret = recv_record(FD, hdr, sizeof(hdr), body, sizeof(body));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 40);
+	CU_ASSERT_EQUAL(memcmp(hdr, data, sizeof(hdr)), 0);
+	CU_ASSERT_EQUAL(memcmp(body, data + sizeof(hdr), sizeof(body)), 0);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+}
+
+void test_oob() {
+	set_test_metadata("recv_urgent", _("There is no urgent data"), 1);
+	struct read_buffer_t *rbuf = fragmented(READ_WRITE_BEFORE_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	set_read_buffer(FD, rbuf);
+	char c = 0;
+	ssize_t ret = 0;
+	int err = 0;
+
+	monitored.recv = true;
+	SANDBOX_BEGIN;
+	ret = recv_urgent(FD, &c);
+	err = errno;
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(err, EINVAL);
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_waitall, test_peek, test_recvmsg, test_oob);
+}
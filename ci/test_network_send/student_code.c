@@ -0,0 +1,77 @@
+#include<errno.h>
+#include<unistd.h>
+#include<sys/socket.h>
+#include<sys/uio.h>
+#include<sys/sendfile.h>
+
+#include "student_code.h"
+
+int send_all(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = send(fd, buf, len, 0);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+int write_all(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = write(fd, buf, len);
+		if (n < 0)
+			return -1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+ssize_t try_send(int fd, const char *buf, size_t len)
+{
+	return send(fd, buf, len, MSG_DONTWAIT);
+}
+
+int writev_all(int fd, const char *head, size_t head_len, const char *body, size_t body_len)
+{
+	struct iovec iov[2] = { { (void *)head, head_len }, { (void *)body, body_len } };
+	struct iovec *cur = iov;
+	int cnt = 2;
+	while (cnt > 0) {
+		ssize_t n = writev(fd, cur, cnt);
+		if (n < 0)
+			return -1;
+		while (cnt > 0 && (size_t)n >= cur->iov_len) {
+			n -= cur->iov_len;
+			cur++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			cur->iov_base = (char *)cur->iov_base + n;
+			cur->iov_len -= n;
+		}
+	}
+	return 0;
+}
+
+int sendfile_all(int out_fd, int in_fd, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = sendfile(out_fd, in_fd, NULL, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (n == 0)
+			return -1;
+		len -= n;
+	}
+	return 0;
+}
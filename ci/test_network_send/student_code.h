@@ -0,0 +1,9 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+
+int send_all(int fd, const char *buf, size_t len);
+int write_all(int fd, const char *buf, size_t len);
+ssize_t try_send(int fd, const char *buf, size_t len);
+int writev_all(int fd, const char *head, size_t head_len, const char *body, size_t body_len);
+int sendfile_all(int out_fd, int in_fd, size_t len);
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FD 42
+
+static const char msg[] = "Hello, world! This message is sent in pieces.";
+
+void test_partial_send() {
+	set_test_metadata("send_all", _("send_all handles partial sends"), 1);
+	char capture[sizeof(msg)];
+	memset(capture, 0, sizeof(capture));
+	size_t chunks[] = {3, 5, 10};
+	struct write_buffer_t wbuf = {
+		.nchunks = 3,
+		.chunks = chunks,
+		.capture = capture,
+		.capture_len = sizeof(capture)
+	};
+	CU_ASSERT_EQUAL(set_write_buffer(FD, &wbuf), 0);
+	int ret = 0;
+
+	monitored.send = true;
+	SANDBOX_BEGIN;
+	ret = send_all(FD, msg, sizeof(msg));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.send.called, 4);
+	CU_ASSERT_EQUAL(get_bytes_written(FD), sizeof(msg));
+	CU_ASSERT_EQUAL(memcmp(capture, msg, sizeof(msg)), 0);
+	CU_ASSERT_EQUAL(set_write_buffer(FD, NULL), 1);
+}
+
+void test_eintr() {
+	set_test_metadata("send_all", _("send_all retries after EINTR"), 1);
+	char capture[sizeof(msg)];
+	size_t chunks[] = {4};
+	struct write_buffer_t wbuf = {
+		.nchunks = 1,
+		.chunks = chunks,
+		.eintr_every = 2,
+		.capture = capture,
+		.capture_len = sizeof(capture)
+	};
+	set_write_buffer(FD, &wbuf);
+	int ret = 0;
+
+	monitored.send = true;
+	SANDBOX_BEGIN;
+	ret = send_all(FD, msg, sizeof(msg));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.send.called, 3);
+	CU_ASSERT_EQUAL(memcmp(capture, msg, sizeof(msg)), 0);
+	set_write_buffer(FD, NULL);
+}
+
+void test_nonblocking() {
+	set_test_metadata("try_send", _("A full non-blocking socket returns EAGAIN"), 1);
+	char capture[8];
+	struct write_buffer_t wbuf = {
+		.capacity = 8,
+		.drain_rate = 1,
+		.capture = capture,
+		.capture_len = sizeof(capture)
+	};
+	set_write_buffer(FD, &wbuf);
+	ssize_t first = 0, second = 0;
+	int err = 0;
+
+	monitored.send = true;
+	SANDBOX_BEGIN;
+	first = try_send(FD, msg, sizeof(msg));
+	second = try_send(FD, msg + first, sizeof(msg) - first);
+	err = errno;
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(first, 8);
+	CU_ASSERT_EQUAL(second, -1);
+	CU_ASSERT_EQUAL(err, EAGAIN);
+	CU_ASSERT_EQUAL(memcmp(capture, msg, 8), 0);
+	set_write_buffer(FD, NULL);
+}
+
+void test_backpressure() {
+	set_test_metadata("write_all", _("write_all waits for the peer to drain the data"), 1);
+	char capture[16];
+	struct write_buffer_t wbuf = {
+		.capacity = 16,
+		.drain_rate = 16000,
+		.capture = capture,
+		.capture_len = sizeof(capture)
+	};
+	set_write_buffer(FD, &wbuf);
+	int ret = 0;
+
+	monitored.write = true;
+	SANDBOX_BEGIN;
+	ret = write_all(FD, msg, sizeof(msg));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_TRUE(stats.write.called >= 3);
+	CU_ASSERT_EQUAL(get_bytes_written(FD), sizeof(msg));
+	// Only the first bytes are captured
+	CU_ASSERT_EQUAL(memcmp(capture, msg, sizeof(capture)), 0);
+	set_write_buffer(FD, NULL);
+}
+
+void test_partial_writev() {
+	set_test_metadata("writev_all", _("writev_all handles partial writes"), 1);
+	char capture[sizeof(msg)];
+	memset(capture, 0, sizeof(capture));
+	size_t chunks[] = {3, 5, 10};
+	struct write_buffer_t wbuf = {
+		.nchunks = 3,
+		.chunks = chunks,
+		.capture = capture,
+		.capture_len = sizeof(capture)
+	};
+	set_write_buffer(FD, &wbuf);
+	int ret = 0;
+
+	monitored.writev = true;
+	SANDBOX_BEGIN;
+	ret = writev_all(FD, msg, 6, msg + 6, sizeof(msg) - 6);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.writev.called, 4);
+	CU_ASSERT_EQUAL(get_bytes_written(FD), sizeof(msg));
+	CU_ASSERT_EQUAL(memcmp(capture, msg, sizeof(msg)), 0);
+	set_write_buffer(FD, NULL);
+}
+
+void test_partial_sendfile() {
+	set_test_metadata("sendfile_all", _("sendfile_all copies everything despite partial writes"), 1);
+	off_t offsets[] = {20, sizeof(msg) - 20};
+	int intervals[] = {0, 0};
+	struct read_buffer_t *rbuf = create_read_buffer((void *)msg, 2, offsets, intervals, READ_WRITE_BEFORE_INTERVAL);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(rbuf);
+	set_read_buffer(FD + 1, rbuf);
+	char capture[sizeof(msg)];
+	memset(capture, 0, sizeof(capture));
+	size_t chunks[] = {3, 5, 10};
+	struct write_buffer_t wbuf = {
+		.nchunks = 3,
+		.chunks = chunks,
+		.eintr_every = 4,
+		.capture = capture,
+		.capture_len = sizeof(capture)
+	};
+	set_write_buffer(FD, &wbuf);
+	int ret = 0;
+
+	monitored.sendfile = true;
+	SANDBOX_BEGIN;
+	ret = sendfile_all(FD, FD + 1, sizeof(msg));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(get_bytes_written(FD), sizeof(msg));
+	CU_ASSERT_EQUAL(get_bytes_read(FD + 1), sizeof(msg));
+	CU_ASSERT_EQUAL(memcmp(capture, msg, sizeof(msg)), 0);
+	set_write_buffer(FD, NULL);
+	set_read_buffer(FD + 1, NULL);
+	free_read_buffer(rbuf);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_partial_send, test_eintr, test_nonblocking, test_backpressure, test_partial_writev,
+	    test_partial_sendfile);
+}
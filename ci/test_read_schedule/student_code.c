@@ -0,0 +1,25 @@
+#define _GNU_SOURCE
+#include<string.h>
+#include<unistd.h>
+
+#include "student_code.h"
+
+ssize_t read_request(int fd, char *buf, size_t len)
+{
+	size_t done = 0;
+	while (done < len && memmem(buf, done, "\r\n\r\n", 4) == NULL) {
+		ssize_t n = read(fd, buf + done, len - done);
+		if (n <= 0)
+			return -1;
+		done += n;
+	}
+	return done;
+}
+
+/*
+ * Wrong: assumes that the whole request arrives at once
+ */
+ssize_t read_request_once(int fd, char *buf, size_t len)
+{
+	return read(fd, buf, len);
+}
@@ -0,0 +1,6 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+
+ssize_t read_request(int fd, char *buf, size_t len);
+ssize_t read_request_once(int fd, char *buf, size_t len);
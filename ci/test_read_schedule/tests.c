@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FD 42
+
+static char request[] = "GET / HTTP/1.1\r\nHost: example.com\r\nAccept: */*\r\n\r\n";
+#define REQUEST_LEN (sizeof(request) - 1)
+
+static size_t total(const off_t *offsets, ssize_t n)
+{
+	size_t sum = 0;
+	for (ssize_t i = 0; i < n; i++)
+		sum += offsets[i];
+	return sum;
+}
+
+void test_schedules() {
+	set_test_metadata("read_request", _("The schedules cover the whole data"), 1);
+	struct read_schedule_t uniform = { .kind = READ_SCHEDULE_UNIFORM, .seed = 7, .min_size = 2, .max_size = 9 };
+	struct read_schedule_t geometric = { .kind = READ_SCHEDULE_GEOMETRIC, .seed = 7, .mean_size = 4 };
+	struct read_schedule_t bytes = { .kind = READ_SCHEDULE_BYTES };
+	struct read_schedule_t delimiter = { .kind = READ_SCHEDULE_DELIMITER, .seed = 7, .delimiter = "\r\n" };
+	struct read_schedule_t *schedules[] = {&uniform, &geometric, &bytes, &delimiter};
+	off_t *offsets, *again;
+	int *intervals;
+	for (int i = 0; i < 4; i++) {
+		ssize_t n = read_schedule(request, REQUEST_LEN, schedules[i], &offsets, &intervals);
+		CU_ASSERT(n > 0);
+		CU_ASSERT_EQUAL(total(offsets, n), REQUEST_LEN);
+		free(intervals);
+		// The same seed gives the same schedule
+		CU_ASSERT_EQUAL(read_schedule(request, REQUEST_LEN, schedules[i], &again, &intervals), n);
+		CU_ASSERT_EQUAL(memcmp(offsets, again, n * sizeof(off_t)), 0);
+		free(intervals);
+		free(again);
+		if (schedules[i] == &bytes)
+			CU_ASSERT_EQUAL(n, (ssize_t)REQUEST_LEN);
+		if (schedules[i] == &delimiter) {
+			// All the cuts are around a delimiter
+			size_t pos = 0;
+			for (ssize_t j = 0; j + 1 < n; j++) {
+				pos += offsets[j];
+				CU_ASSERT(request[pos - 1] == '\r' || request[pos - 1] == '\n'
+					|| request[pos] == '\r');
+			}
+		}
+		free(offsets);
+	}
+	uniform.min_size = 0;
+	CU_ASSERT_EQUAL(read_schedule(request, REQUEST_LEN, &uniform, &offsets, &intervals), -1);
+	SANDBOX_BEGIN;
+	SANDBOX_END;
+}
+
+/*
+ * Reads the request with the function arg, from a buffer split by schedule.
+ */
+static int check_request(const struct read_schedule_t *schedule, void *arg)
+{
+	ssize_t (*read_fn)(int, char *, size_t) = *(ssize_t (**)(int, char *, size_t))arg;
+	struct read_buffer_t *rbuf = create_scheduled_read_buffer(request, REQUEST_LEN, schedule, READ_WRITE_BEFORE_INTERVAL);
+	if (rbuf == NULL)
+		return -1;
+	set_read_buffer(FD, rbuf);
+	char buf[128];
+	ssize_t ret = -1;
+
+	monitored.read = true;
+	SANDBOX_BEGIN;
+	ret = read_fn(FD, buf, sizeof(buf));
+	SANDBOX_END;
+
+	set_read_buffer(FD, NULL);
+	free_read_buffer(rbuf);
+	return !(ret == (ssize_t)REQUEST_LEN && memcmp(buf, request, REQUEST_LEN) == 0);
+}
+
+void test_search_correct() {
+	set_test_metadata("read_request", _("A request is read whatever its fragmentation"), 1);
+	ssize_t (*read_fn)(int, char *, size_t) = read_request;
+	struct read_schedule_t uniform = { .kind = READ_SCHEDULE_UNIFORM, .seed = 1, .min_size = 1, .max_size = 16 };
+	struct read_schedule_t delimiter = { .kind = READ_SCHEDULE_DELIMITER, .seed = 1, .delimiter = "\r\n" };
+	// Another child of the test, as a mock server, must not be reaped by the search
+	pid_t other = fork();
+	if (other == 0)
+		_exit(3);
+	CU_ASSERT_EQUAL(read_schedule_search(request, REQUEST_LEN, &uniform, 16, check_request, &read_fn, NULL), 0);
+	CU_ASSERT_EQUAL(read_schedule_search(request, REQUEST_LEN, &delimiter, 16, check_request, &read_fn, NULL), 0);
+	int status = 0;
+	CU_ASSERT_EQUAL(waitpid(other, &status, 0), other);
+	CU_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 3);
+}
+
+void test_search_wrong() {
+	set_test_metadata("read_request_once", _("The minimal failing schedule is found"), 1);
+	ssize_t (*read_fn)(int, char *, size_t) = read_request_once;
+	struct read_schedule_t delimiter = { .kind = READ_SCHEDULE_DELIMITER, .seed = 100, .delimiter = "\r\n" };
+	struct read_schedule_t failing;
+	memset(&failing, 0, sizeof(failing));
+	int nfailed = read_schedule_search(request, REQUEST_LEN, &delimiter, 16, check_request, &read_fn, &failing);
+	// Only the schedule without any cut succeeds, with probability 2^-12
+	CU_ASSERT(nfailed >= 15);
+	CU_ASSERT(failing.seed >= 100 && failing.seed < 116);
+	off_t *offsets;
+	int *intervals;
+	ssize_t best = read_schedule(request, REQUEST_LEN, &failing, &offsets, &intervals);
+	free(offsets);
+	free(intervals);
+	for (uint64_t seed = 100; seed < 116; seed++) {
+		delimiter.seed = seed;
+		ssize_t n = read_schedule(request, REQUEST_LEN, &delimiter, &offsets, &intervals);
+		// All the schedules with fewer chunks succeed, so have only one chunk
+		CU_ASSERT(n >= best || n == 1);
+		free(offsets);
+		free(intervals);
+	}
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_schedules, test_search_correct, test_search_wrong);
+}
@@ -0,0 +1,29 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/stat.h>
+
+#include "student_code.h"
+
+int append(const char *path, const char *data)
+{
+	int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (fd < 0)
+		return -1;
+	ssize_t len = strlen(data);
+	if (write(fd, data, len) != len) {
+		close(fd);
+		return -1;
+	}
+	return close(fd);
+}
+
+long file_size(const char *path)
+{
+	struct stat st;
+	if (stat(path, &st) < 0)
+		return -1;
+	return st.st_size;
+}
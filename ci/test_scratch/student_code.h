@@ -0,0 +1,3 @@
+
+int append(const char *path, const char *data);
+long file_size(const char *path);
@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+static int contents_equal(const char *path, const char *expected)
+{
+	char buf[64];
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+	ssize_t n = read(fd, buf, sizeof(buf));
+	close(fd);
+	return n == (ssize_t)strlen(expected) && memcmp(buf, expected, n) == 0;
+}
+
+void test_append() {
+	set_test_metadata("append", _("append adds the data at the end of the file"), 1);
+	char cwd[512];
+	int ret = 0;
+
+	SANDBOX_BEGIN;
+	ret = append("f.dat", "DEF");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_TRUE(contents_equal("f.dat", "ABCDEF"));
+	CU_ASSERT_EQUAL(append("new.dat", "XY"), 0);
+	CU_ASSERT_PTR_NOT_NULL_FATAL(scratch_path());
+	CU_ASSERT_PTR_NOT_NULL_FATAL(getcwd(cwd, sizeof(cwd)));
+	CU_ASSERT_STRING_EQUAL(cwd, scratch_path());
+}
+
+void test_isolated() {
+	set_test_metadata("append", _("Each test starts with the fixture files only"), 1);
+	int ret = 0;
+
+	SANDBOX_BEGIN;
+	ret = append("f.dat", "GH");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_TRUE(contents_equal("f.dat", "ABCGH"));
+	CU_ASSERT_EQUAL(access("new.dat", F_OK), -1);
+}
+
+void test_read_only() {
+	set_test_metadata("append", _("Read-only fixture files are shared"), 1);
+	struct stat st;
+
+	CU_ASSERT_EQUAL_FATAL(stat("ro.dat", &st), 0);
+	CU_ASSERT(st.st_nlink >= 2);
+	CU_ASSERT_TRUE(contents_equal("ro.dat", "RO"));
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	if (set_scratch_dir(true) < 0
+			|| scratch_fixture("f.dat", "ABC", 3, 0644) < 0
+			|| scratch_fixture("ro.dat", "RO", 2, 0444) < 0)
+		return 1;
+	RUN(test_append, test_isolated, test_read_only);
+}
@@ -0,0 +1,149 @@
+#include<string.h>
+#include<unistd.h>
+#include<netdb.h>
+#include<poll.h>
+#include<sys/uio.h>
+#include<sys/socket.h>
+#include<netinet/in.h>
+#include<arpa/inet.h>
+
+#include "student_code.h"
+
+static int open_socket(const char *host, const char *port, int type, struct sockaddr_storage *addr, socklen_t *addrlen)
+{
+	struct addrinfo hints, *res;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = type;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+	if (getaddrinfo(host, port, &hints, &res) != 0)
+		return -1;
+	int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	memcpy(addr, res->ai_addr, res->ai_addrlen);
+	*addrlen = res->ai_addrlen;
+	freeaddrinfo(res);
+	return fd;
+}
+
+ssize_t ask(const char *host, const char *port, const char *question, char *answer, size_t len)
+{
+	struct sockaddr_storage addr;
+	socklen_t addrlen;
+	int fd = open_socket(host, port, SOCK_STREAM, &addr, &addrlen);
+	if (fd < 0)
+		return -1;
+	if (connect(fd, (struct sockaddr *)&addr, addrlen) < 0
+			|| send(fd, question, strlen(question), 0) < 0
+			|| shutdown(fd, SHUT_WR) < 0) {
+		close(fd);
+		return -1;
+	}
+	size_t done = 0;
+	ssize_t n;
+	while (done < len && (n = recv(fd, answer + done, len - done, 0)) > 0)
+		done += n;
+	close(fd);
+	return done;
+}
+
+int serve_one(int port)
+{
+	int sfd = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (sfd < 0 || bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sfd, 5) < 0)
+		return -1;
+	struct pollfd pfd = { .fd = sfd, .events = POLLIN };
+	if (poll(&pfd, 1, 1000) != 1) {
+		close(sfd);
+		return -1;
+	}
+	int cfd = accept(sfd, NULL, NULL);
+	close(sfd);
+	if (cfd < 0)
+		return -1;
+	char buf[16];
+	size_t done = 0;
+	ssize_t n;
+	while (done < sizeof(buf) && memchr(buf, '\n', done) == NULL
+			&& (n = read(cfd, buf + done, sizeof(buf) - done)) > 0)
+		done += n;
+	int ret = (write(cfd, "pong\n", 5) == 5 ? 0 : -1);
+	close(cfd);
+	return ret;
+}
+
+ssize_t udp_ask(const char *host, const char *port, const char *question, char *answer, size_t len)
+{
+	struct sockaddr_storage addr, from;
+	socklen_t addrlen, fromlen = sizeof(from);
+	int fd = open_socket(host, port, SOCK_DGRAM, &addr, &addrlen);
+	if (fd < 0)
+		return -1;
+	ssize_t n = -1;
+	if (sendto(fd, question, strlen(question), 0, (struct sockaddr *)&addr, addrlen) >= 0)
+		n = recvfrom(fd, answer, len, 0, (struct sockaddr *)&from, &fromlen);
+	close(fd);
+	return n;
+}
+
+int serve_vectored(int port, int *client_port)
+{
+	int sfd = socket(AF_INET, SOCK_STREAM, 0);
+	int one = 1, type = 0;
+	socklen_t typelen = sizeof(type);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (sfd < 0 || setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0
+			|| getsockopt(sfd, SOL_SOCKET, SO_TYPE, &type, &typelen) < 0 || type != SOCK_STREAM
+			|| bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sfd, 5) < 0)
+		return -1;
+	int cfd = accept(sfd, NULL, NULL);
+	close(sfd);
+	if (cfd < 0)
+		return -1;
+	struct sockaddr_in peer;
+	socklen_t peerlen = sizeof(peer);
+	if (getpeername(cfd, (struct sockaddr *)&peer, &peerlen) < 0) {
+		close(cfd);
+		return -1;
+	}
+	*client_port = ntohs(peer.sin_port);
+	char head[3], tail[8];
+	struct iovec in[2] = { { head, sizeof(head) }, { tail, sizeof(tail) } };
+	ssize_t n = readv(cfd, in, 2);
+	struct iovec out[2] = { { "po", 2 }, { "ng\n", 3 } };
+	int ret = (n == 5 && memcmp(head, "pin", 3) == 0 && writev(cfd, out, 2) == 5 ? 0 : -1);
+	close(cfd);
+	return ret;
+}
+
+ssize_t ask_vectored(const char *host, const char *port, char *answer, size_t len)
+{
+	struct sockaddr_storage addr;
+	socklen_t addrlen;
+	int fd = open_socket(host, port, SOCK_STREAM, &addr, &addrlen);
+	if (fd < 0)
+		return -1;
+	struct iovec out[2] = { { "pi", 2 }, { "ng\n", 3 } };
+	if (connect(fd, (struct sockaddr *)&addr, addrlen) < 0 || writev(fd, out, 2) != 5) {
+		close(fd);
+		return -1;
+	}
+	struct iovec in[1] = { { answer, len } };
+	size_t done = 0;
+	ssize_t n;
+	while (done < len && (n = readv(fd, in, 1)) > 0) {
+		done += n;
+		in[0].iov_base = answer + done;
+		in[0].iov_len = len - done;
+	}
+	close(fd);
+	return done;
+}
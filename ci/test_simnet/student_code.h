@@ -0,0 +1,9 @@
+
+#include <stddef.h>
+#include <sys/types.h>
+
+ssize_t ask(const char *host, const char *port, const char *question, char *answer, size_t len);
+int serve_one(int port);
+ssize_t udp_ask(const char *host, const char *port, const char *question, char *answer, size_t len);
+int serve_vectored(int port, int *client_port);
+ssize_t ask_vectored(const char *host, const char *port, char *answer, size_t len);
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/simnet.h"
+
+static struct sockaddr_in make_addr(const char *host, int port)
+{
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	inet_pton(AF_INET, host, &addr.sin_addr);
+	return addr;
+}
+
+void test_client() {
+	set_test_metadata("ask", _("The client talks to a simulated server"), 1);
+	set_simnet(true);
+	set_fd_leak_check(true);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "ping\n", .data_length = 5, .type = RECV_CHUNK },
+		{ .data = "pong", .data_length = 4, .type = SEND_CHUNK },
+		{ .data = "\n", .data_length = 1, .type = SEND_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 3 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	// Port 1 is never open on the real loopback
+	struct sockaddr_in addr = make_addr("127.0.0.1", 1);
+	int peer = simnet_add_server((struct sockaddr *)&addr, sizeof(addr), SOCK_STREAM, &all);
+	CU_ASSERT_EQUAL(peer, 0);
+	char answer[16];
+	ssize_t ret = 0;
+
+	monitored.connect = true;
+	SANDBOX_BEGIN;
+	ret = ask("127.0.0.1", "1", "ping\n", answer, sizeof(answer));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 5);
+	CU_ASSERT_EQUAL(memcmp(answer, "pong\n", 5), 0);
+	CU_ASSERT_EQUAL(stats.connect.called, 1);
+	CU_ASSERT_EQUAL(simnet_report(peer)->status, OK);
+	CU_ASSERT_EQUAL(simnet_report(peer)->done, 1);
+	set_fd_leak_check(false);
+}
+
+void test_client_wrong() {
+	set_test_metadata("ask", _("The simulated server reports unexpected data"), 1);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "PING\n", .data_length = 5, .type = RECV_CHUNK },
+		{ .data = "pong\n", .data_length = 5, .type = SEND_CHUNK },
+		{ .data = "bye\n", .data_length = 4, .type = RECV_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 3 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	struct sockaddr_in addr = make_addr("127.0.0.1", 1);
+	int peer = simnet_add_server((struct sockaddr *)&addr, sizeof(addr), SOCK_STREAM, &all);
+	char answer[16];
+	ssize_t ret = 0, refused = 0;
+
+	SANDBOX_BEGIN;
+	ret = ask("127.0.0.1", "1", "ping\n", answer, sizeof(answer));
+	// The only transaction is over
+	refused = ask("127.0.0.1", "1", "ping\n", answer, sizeof(answer));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 5);
+	CU_ASSERT_EQUAL(refused, -1);
+	CU_ASSERT_EQUAL(simnet_report(peer)->status, NOT_SAME_DATA);
+	CU_ASSERT_EQUAL(simnet_report(peer)->chunk, 0);
+	CU_ASSERT_EQUAL(simnet_report(peer)->done, 1);
+}
+
+void test_server() {
+	set_test_metadata("serve_one", _("The server answers a simulated client"), 1);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "pi", .data_length = 2, .type = SEND_CHUNK },
+		{ .data = "ng\n", .data_length = 3, .type = SEND_CHUNK },
+		{ .data = "pong\n", .data_length = 5, .type = RECV_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 3 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	struct sockaddr_in addr = make_addr("127.0.0.1", 8080);
+	int peer = simnet_add_client((struct sockaddr *)&addr, sizeof(addr), SOCK_STREAM, &all);
+	int ret = -1;
+
+	monitored.poll = true;
+	monitored.accept = true;
+	SANDBOX_BEGIN;
+	ret = serve_one(8080);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.poll.called, 1);
+	CU_ASSERT_EQUAL(stats.accept.called, 1);
+	CU_ASSERT_EQUAL(simnet_report(peer)->status, OK);
+	CU_ASSERT_EQUAL(simnet_report(peer)->done, 1);
+}
+
+void test_udp() {
+	set_test_metadata("udp_ask", _("The client exchanges datagrams with a simulated server"), 1);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "time?", .data_length = 5, .type = RECV_CHUNK },
+		{ .data = "noon", .data_length = 4, .type = SEND_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 2 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	struct sockaddr_in addr = make_addr("127.0.0.1", 5353);
+	int peer = simnet_add_server((struct sockaddr *)&addr, sizeof(addr), SOCK_DGRAM, &all);
+	char answer[16];
+	ssize_t ret = 0;
+
+	SANDBOX_BEGIN;
+	ret = udp_ask("127.0.0.1", "5353", "time?", answer, sizeof(answer));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 4);
+	CU_ASSERT_EQUAL(memcmp(answer, "noon", 4), 0);
+	CU_ASSERT_EQUAL(simnet_report(peer)->status, OK);
+	CU_ASSERT_EQUAL(simnet_report(peer)->done, 1);
+	set_simnet(false);
+}
+
+void test_vectored_server() {
+	set_test_metadata("serve_vectored", _("The server sets options and uses vectored I/O on simulated sockets"), 1);
+	set_simnet(true);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "ping\n", .data_length = 5, .type = SEND_CHUNK },
+		{ .data = "pong\n", .data_length = 5, .type = RECV_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 2 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	struct sockaddr_in addr = make_addr("127.0.0.1", 8081);
+	int peer = simnet_add_client((struct sockaddr *)&addr, sizeof(addr), SOCK_STREAM, &all);
+	int ret = -1, client_port = 0;
+
+	SANDBOX_BEGIN;
+	ret = serve_vectored(8081, &client_port);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(client_port, SIMNET_PORT_BASE + peer);
+	CU_ASSERT_EQUAL(simnet_report(peer)->status, OK);
+	CU_ASSERT_EQUAL(simnet_report(peer)->done, 1);
+}
+
+void test_vectored_client() {
+	set_test_metadata("ask_vectored", _("The client uses vectored I/O on a simulated socket"), 1);
+	struct cs_network_chunk chunks[] = {
+		{ .data = "ping\n", .data_length = 5, .type = RECV_CHUNK },
+		{ .data = "pong\n", .data_length = 5, .type = SEND_CHUNK }
+	};
+	struct cs_network_transaction trans = { .chunks = chunks, .nchunks = 2 };
+	struct cs_network_transactions all = { .transactions = &trans, .ntransactions = 1 };
+	struct sockaddr_in addr = make_addr("127.0.0.1", 1);
+	int peer = simnet_add_server((struct sockaddr *)&addr, sizeof(addr), SOCK_STREAM, &all);
+	char answer[16];
+	ssize_t ret = 0;
+
+	SANDBOX_BEGIN;
+	ret = ask_vectored("127.0.0.1", "1", answer, sizeof(answer));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 5);
+	CU_ASSERT_EQUAL(memcmp(answer, "pong\n", 5), 0);
+	CU_ASSERT_EQUAL(simnet_report(peer)->status, OK);
+	set_simnet(false);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_client, test_client_wrong, test_server, test_udp, test_vectored_server, test_vectored_client);
+}
@@ -0,0 +1,61 @@
+#include<stdio.h>
+#include<stdlib.h>
+
+#include "student_code.h"
+
+int write_lines(const char *path, int n, int buffered)
+{
+	FILE *f = fopen(path, "w");
+	if (f == NULL)
+		return -1;
+	if (!buffered && setvbuf(f, NULL, _IONBF, 0) != 0) {
+		fclose(f);
+		return -1;
+	}
+	for (int i = 0; i < n; i++) {
+		if (fprintf(f, "line %d\n", i) < 0) {
+			fclose(f);
+			return -1;
+		}
+	}
+	if (fclose(f) != 0)
+		return -1;
+	return 0;
+}
+
+int copy_chars(const char *src, FILE *out)
+{
+	FILE *in = fopen(src, "r");
+	if (in == NULL)
+		return -1;
+	int n = 0;
+	int c;
+	while ((c = fgetc(in)) != EOF) {
+		if (putc(c, out) == EOF) {
+			fclose(in);
+			return -1;
+		}
+		n++;
+	}
+	fclose(in);
+	printf("copied\n");
+	return n;
+}
+
+int copy_lines(const char *src, FILE *out)
+{
+	FILE *in = fopen(src, "r");
+	if (in == NULL)
+		return -1;
+	char line[64];
+	int n = 0;
+	while (fgets(line, sizeof(line), in) != NULL) {
+		if (fputs(line, out) == EOF) {
+			fclose(in);
+			return -1;
+		}
+		n++;
+	}
+	fclose(in);
+	return n;
+}
@@ -0,0 +1,5 @@
+
+#include <stdio.h>
+int write_lines(const char *path, int n, int buffered);
+int copy_chars(const char *src, FILE *out);
+int copy_lines(const char *src, FILE *out);
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define PATH "/tmp/ctester_stdio.txt"
+
+void test_buffered() {
+	set_test_metadata("write_lines", _("Buffered output makes few writes"), 1);
+	int ret = 0;
+
+	MONITOR_ALL_STDIO(monitored, true);
+	SANDBOX_BEGIN;
+	ret = write_lines(PATH, 100, 1);
+	SANDBOX_END;
+	unlink(PATH);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.fopen.called, 1);
+	CU_ASSERT_EQUAL(stats.fprintf.called, 100);
+	CU_ASSERT_EQUAL(stats.fclose.called, 1);
+	CU_ASSERT_EQUAL(stats.setvbuf.called, 0);
+	CU_ASSERT_EQUAL(stats.stdio.write_calls, 100);
+	CU_ASSERT(stdio_calls_per_flush() > 10);
+}
+
+void test_unbuffered() {
+	set_test_metadata("write_lines", _("Unbuffered output writes on every call"), 1);
+	int ret = 0;
+
+	MONITOR_ALL_STDIO(monitored, true);
+	SANDBOX_BEGIN;
+	ret = write_lines(PATH, 100, 0);
+	SANDBOX_END;
+	unlink(PATH);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.setvbuf.called, 1);
+	CU_ASSERT_EQUAL(stats.setvbuf.last_params.mode, _IONBF);
+	CU_ASSERT_EQUAL(stats.stdio.flushes, 100);
+	CU_ASSERT(stdio_calls_per_flush() == 1);
+}
+
+void test_enospc() {
+	set_test_metadata("write_lines", _("write_lines reports a full disk"), 1);
+	int ret = 0;
+
+	MONITOR_ALL_STDIO(monitored, true);
+	failures.fprintf = FAIL_THIRD;
+	failures.fprintf_ret = -1;
+	failures.fprintf_errno = ENOSPC;
+	SANDBOX_BEGIN;
+	ret = write_lines(PATH, 100, 1);
+	SANDBOX_END;
+	unlink(PATH);
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.fprintf.called, 3);
+	// The stream must be closed even if writing failed
+	if (stats.fclose.called != 1) {
+		push_info_msg(_("You did not close the file after an error"));
+		CU_FAIL();
+	}
+}
+
+void test_fopen_fail() {
+	set_test_metadata("write_lines", _("write_lines reports fopen failures"), 1);
+	int ret = 0;
+
+	MONITOR_ALL_STDIO(monitored, true);
+	failures.fopen = FAIL_FIRST;
+	failures.fopen_ret = NULL;
+	failures.fopen_errno = EACCES;
+	SANDBOX_BEGIN;
+	ret = write_lines(PATH, 100, 1);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.fprintf.called, 0);
+	CU_ASSERT_EQUAL(access(PATH, F_OK), -1);
+}
+
+static void write_source() {
+	FILE *f = fopen(PATH, "w");
+	fputs("hello", f);
+	fclose(f);
+}
+
+void test_chars() {
+	set_test_metadata("copy_chars", _("Character I/O is monitored"), 1);
+	int ret = 0;
+
+	write_source();
+	FILE *out = tmpfile();
+	MONITOR_ALL_STDIO(monitored, true);
+	SANDBOX_BEGIN;
+	ret = copy_chars(PATH, out);
+	SANDBOX_END;
+	fclose(out);
+	unlink(PATH);
+
+	CU_ASSERT_EQUAL(ret, 5);
+	CU_ASSERT_EQUAL(stats.fgetc.called, 6);
+	CU_ASSERT_EQUAL(stats.fgetc.last_return, EOF);
+	CU_ASSERT_EQUAL(stats.fputc.called, 5);
+	CU_ASSERT_EQUAL(stats.fputc.last_params.c, 'o');
+	// The compiler turns printf("copied\n") into puts("copied")
+	CU_ASSERT_EQUAL(stats.printf.called + stats.puts.called, 1);
+	CU_ASSERT_EQUAL(stats.stdio.write_calls, 6);
+	struct callsite_stats_t cs = callsite_stats("fputc", "copy_chars");
+	CU_ASSERT_EQUAL(cs.sites, 1);
+	CU_ASSERT_EQUAL(cs.called, 5);
+	CU_ASSERT_EQUAL(cs.bytes, 5);
+	CU_ASSERT_EQUAL(callsite_stats("fgetc", "copy_chars").called, 6);
+}
+
+void test_chars_fail() {
+	set_test_metadata("copy_chars", _("copy_chars reports putc failures"), 1);
+	int ret = 0;
+
+	write_source();
+	FILE *out = tmpfile();
+	MONITOR_ALL_STDIO(monitored, true);
+	failures.fputc = FAIL_SECOND;
+	failures.fputc_ret = EOF;
+	failures.fputc_errno = EIO;
+	SANDBOX_BEGIN;
+	ret = copy_chars(PATH, out);
+	SANDBOX_END;
+	fclose(out);
+	unlink(PATH);
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.fputc.called, 2);
+	CU_ASSERT_EQUAL(stats.fgetc.called, 2);
+	CU_ASSERT_EQUAL(stats.fclose.called, 1);
+}
+
+void test_lines() {
+	set_test_metadata("copy_lines", _("Line I/O is counted per call site"), 1);
+	int ret = 0;
+
+	FILE *f = fopen(PATH, "w");
+	fputs("first\nsecond\n", f);
+	fclose(f);
+	FILE *out = tmpfile();
+	MONITOR_ALL_STDIO(monitored, true);
+	SANDBOX_BEGIN;
+	ret = copy_lines(PATH, out);
+	SANDBOX_END;
+	fclose(out);
+	unlink(PATH);
+
+	CU_ASSERT_EQUAL(ret, 2);
+	CU_ASSERT_EQUAL(callsite_stats("fgets", "copy_lines").bytes, 13);
+	CU_ASSERT_EQUAL(callsite_stats("fputs", "copy_lines").bytes, 13);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_buffered, test_unbuffered, test_enospc, test_fopen_fail,
+	    test_chars, test_chars_fail, test_lines);
+}
@@ -0,0 +1,26 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include "student_code.h"
+
+int count_upper(const char *s)
+{
+	int n = 0;
+	size_t len = strlen(s);
+	for (size_t i = 0; i < len; i++) {
+		if (s[i] >= 'A' && s[i] <= 'Z')
+			n++;
+	}
+	return n;
+}
+
+int count_upper_slow(const char *s)
+{
+	int n = 0;
+	for (size_t i = 0; i < strlen(s); i++) {
+		if (s[i] >= 'A' && s[i] <= 'Z')
+			n++;
+	}
+	return n;
+}
@@ -0,0 +1,3 @@
+
+int count_upper(const char *s);
+int count_upper_slow(const char *s);
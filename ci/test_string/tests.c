@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <string.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define INPUT_LEN 1000
+
+static char input[INPUT_LEN + 1];
+
+static void make_input()
+{
+	for (int i = 0; i < INPUT_LEN; i++)
+		input[i] = (i % 4 == 0) ? 'A' : 'b';
+	input[INPUT_LEN] = '\0';
+}
+
+void test_linear() {
+	set_test_metadata("count_upper", _("count_upper goes through its input once"), 1);
+	int ret = 0;
+	size_t len = 0;
+	make_input();
+
+	MONITOR_ALL_STRING(monitored, true);
+	SANDBOX_BEGIN;
+	ret = count_upper(input);
+	// Not counted: only the calls of the student are wrapped
+	len = strlen(input);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, INPUT_LEN / 4);
+	CU_ASSERT_EQUAL(len, INPUT_LEN);
+	CU_ASSERT_EQUAL(stats.strlen.called, 1);
+	CU_ASSERT_EQUAL(stats.strlen.bytes, INPUT_LEN + 1);
+	CU_ASSERT(string_bytes_ratio(INPUT_LEN) < 2);
+}
+
+void test_quadratic() {
+	set_test_metadata("count_upper", _("strlen in the loop condition is detected"), 1);
+	int ret = 0;
+	make_input();
+
+	MONITOR_ALL_STRING(monitored, true);
+	SANDBOX_BEGIN;
+	ret = count_upper_slow(input);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, INPUT_LEN / 4);
+	CU_ASSERT_EQUAL(stats.strlen.called, INPUT_LEN + 1);
+	CU_ASSERT_EQUAL(callsite_stats("strlen", "count_upper_slow").called, INPUT_LEN + 1);
+	if (string_bytes_ratio(INPUT_LEN) > 10) {
+		push_info_msg(_("Your code calls strlen on the whole string at each iteration"));
+		set_tag("quadratic");
+	}
+	CU_ASSERT(string_bytes_ratio(INPUT_LEN) > 100);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_linear, test_quadratic);
+}
@@ -0,0 +1,20 @@
+#include<stdio.h>
+#include<stdlib.h>
+
+#include "student_code.h"
+
+int sum(const int *tab, int n)
+{
+	int s = 0;
+	for (int i = 0; i < n; i++)
+		s += tab[i];
+	return s;
+}
+
+int last_negative(const int *tab, int n)
+{
+	int i = n - 1;
+	while (tab[i] >= 0)
+		i--;
+	return i;
+}
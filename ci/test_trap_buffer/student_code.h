@@ -0,0 +1,3 @@
+
+int sum(const int *tab, int n);
+int last_negative(const int *tab, int n);
@@ -0,0 +1,47 @@
+#include <stdlib.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+#define N 100
+
+void test_sum() {
+	set_test_metadata("sum", _("sum reads only the array"), 1);
+	int tab[N];
+	for (int i = 0; i < N; i++)
+		tab[i] = i;
+	int ret = 0;
+
+	// Many buffers, recycled by the trap arena
+	for (int i = 0; i < 10000; i++) {
+		int *trapped = trap_buffer(sizeof(tab), TRAP_BOTH, PROT_READ, tab);
+		CU_ASSERT_PTR_NOT_NULL_FATAL(trapped);
+		SANDBOX_BEGIN;
+		ret = sum(trapped, N);
+		SANDBOX_END;
+		free_trap(trapped, sizeof(tab));
+	}
+
+	CU_ASSERT_EQUAL(ret, N * (N - 1) / 2);
+}
+
+void test_last_negative() {
+	set_test_metadata("last_negative", _("last_negative stays in the array"), 1);
+	int tab[N];
+	for (int i = 0; i < N; i++)
+		tab[i] = i;
+	int ret = 0;
+
+	// Not freed: released at the beginning of the next test
+	int *trapped = trap_buffer(sizeof(tab), TRAP_LEFT, PROT_READ, tab);
+	SANDBOX_BEGIN;
+	ret = last_negative(trapped, N);
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	RUN(test_sum, test_last_negative);
+}
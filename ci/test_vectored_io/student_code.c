@@ -0,0 +1,40 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+#include<sys/uio.h>
+#include<sys/sendfile.h>
+
+#include "student_code.h"
+
+int write_record(int fd, const char *key, const char *value)
+{
+	struct iovec iov[3] = {
+		{ .iov_base = (void *) key, .iov_len = strlen(key) },
+		{ .iov_base = "=", .iov_len = 1 },
+		{ .iov_base = (void *) value, .iov_len = strlen(value) },
+	};
+	ssize_t len = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+	return (writev(fd, iov, 3) == len ? 0 : -1);
+}
+
+ssize_t read_message(int fd, char *header, char *body, size_t len)
+{
+	struct iovec iov[2] = {
+		{ .iov_base = header, .iov_len = 4 },
+		{ .iov_base = body, .iov_len = len },
+	};
+	return readv(fd, iov, 2);
+}
+
+ssize_t copy_fd(int out, int in, size_t size)
+{
+	size_t done = 0;
+	while (done < size) {
+		ssize_t n = sendfile(out, in, NULL, size - done);
+		if (n <= 0)
+			return -1;
+		done += n;
+	}
+	return done;
+}
@@ -0,0 +1,6 @@
+
+#include <sys/types.h>
+
+int write_record(int fd, const char *key, const char *value);
+ssize_t read_message(int fd, char *header, char *body, size_t len);
+ssize_t copy_fd(int out, int in, size_t size);
@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+#include "CTester/read_write.h"
+
+#define FILE_SIZE 100000
+
+void test_writev() {
+	set_test_metadata("write_record", _("write_record writes the record with one call"), 1);
+	int fd = open("/dev/null", O_WRONLY);
+	int ret = 0;
+
+	monitored.write = true;
+	monitored.writev = true;
+	SANDBOX_BEGIN;
+	ret = write_record(fd, "key", "value");
+	SANDBOX_END;
+	close(fd);
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.writev.called, 1);
+	CU_ASSERT_EQUAL(stats.writev.last_params.iovcnt, 3);
+	CU_ASSERT_EQUAL(stats.writev.io.bytes, 9);
+	CU_ASSERT_EQUAL(stats.write.called, 0);
+}
+
+void test_readv_partial() {
+	set_test_metadata("read_message", _("readv returns the data that has arrived"), 1);
+	char data[] = "HEADbodybody";
+	off_t offsets[] = {6, 6};
+	int intervals[] = {0, 0};
+	struct read_buffer_t rbuf = { .mode = READ_WRITE_AFTER_INTERVAL };
+	char header[4], body[16];
+	ssize_t ret = 0;
+	int p[2];
+	CU_ASSERT_EQUAL_FATAL(pipe(p), 0);
+	CU_ASSERT_EQUAL_FATAL(create_partial_read_buffer(data, 2, offsets, intervals, &rbuf), 0);
+	set_read_buffer(p[0], &rbuf);
+
+	monitored.readv = true;
+	SANDBOX_BEGIN;
+	ret = read_message(p[0], header, body, sizeof(body));
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 6);
+	CU_ASSERT_NSTRING_EQUAL(header, "HEAD", 4);
+	CU_ASSERT_NSTRING_EQUAL(body, "bo", 2);
+	CU_ASSERT_EQUAL(stats.readv.io.short_calls, 1);
+	CU_ASSERT_EQUAL(get_bytes_read(p[0]), 6);
+	set_read_buffer(p[0], NULL);
+	free_partial_read_buffer(&rbuf);
+	close(p[0]);
+	close(p[1]);
+}
+
+void test_sendfile() {
+	set_test_metadata("copy_fd", _("copy_fd copies the file with sendfile"), 1);
+	int in = open("data.bin", O_RDONLY);
+	int out = open("/dev/null", O_WRONLY);
+	ssize_t ret = 0;
+	CU_ASSERT_TRUE_FATAL(in >= 0 && out >= 0);
+
+	monitored.read = true;
+	monitored.sendfile = true;
+	SANDBOX_BEGIN;
+	ret = copy_fd(out, in, FILE_SIZE);
+	SANDBOX_END;
+	close(in);
+	close(out);
+
+	CU_ASSERT_EQUAL(ret, FILE_SIZE);
+	CU_ASSERT_EQUAL(stats.sendfile.io.bytes, FILE_SIZE);
+	CU_ASSERT(stats.sendfile.called >= 1);
+	CU_ASSERT_EQUAL(stats.read.called, 0);
+}
+
+void test_sendfile_fail() {
+	set_test_metadata("copy_fd", _("copy_fd reports the failures of sendfile"), 1);
+	int in = open("data.bin", O_RDONLY);
+	int out = open("/dev/null", O_WRONLY);
+	ssize_t ret = 0;
+	CU_ASSERT_TRUE_FATAL(in >= 0 && out >= 0);
+
+	monitored.sendfile = true;
+	failures.sendfile = FAIL_FIRST;
+	failures.sendfile_ret = -1;
+	failures.sendfile_errno = EIO;
+	SANDBOX_BEGIN;
+	ret = copy_fd(out, in, FILE_SIZE);
+	SANDBOX_END;
+	close(in);
+	close(out);
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(stats.sendfile.called, 1);
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	static char data[FILE_SIZE];
+	memset(data, 'x', sizeof(data));
+	if (set_scratch_dir(true) < 0 || scratch_fixture("data.bin", data, sizeof(data), 0644) < 0)
+		return 1;
+	RUN(test_writev, test_readv_partial, test_sendfile, test_sendfile_fail);
+}
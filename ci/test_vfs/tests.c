@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "student_code.h"
+#include "CTester/CTester.h"
+
+static int contents_equal(const char *path, const char *expected)
+{
+	size_t len = 0;
+	const char *data = vfs_contents(path, &len);
+	return data != NULL && len == strlen(expected) && memcmp(data, expected, len) == 0;
+}
+
+void test_append() {
+	set_test_metadata("append", _("append adds the data at the end of the file"), 1);
+	int ret = 0;
+
+	monitored.open = true;
+	monitored.write = true;
+	SANDBOX_BEGIN;
+	ret = append("f.dat", "DEF");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_EQUAL(stats.open.called, 1);
+	CU_ASSERT_EQUAL(stats.write.last_return, 3);
+	CU_ASSERT_TRUE(contents_equal("f.dat", "ABCDEF"));
+	// Nothing has been written on the disk
+	CU_ASSERT_EQUAL(access("f.dat", F_OK), -1);
+}
+
+void test_snapshot() {
+	set_test_metadata("append", _("Each test starts with the files of the snapshot"), 1);
+	long size = 0;
+	int ret = 0;
+
+	SANDBOX_BEGIN;
+	size = file_size("f.dat");
+	ret = append("new.dat", "XY");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(size, 3);
+	CU_ASSERT_EQUAL(ret, 0);
+	CU_ASSERT_TRUE(contents_equal("new.dat", "XY"));
+	CU_ASSERT_TRUE(contents_equal("f.dat", "ABC"));
+	CU_ASSERT_EQUAL(file_size("missing.dat"), -1);
+}
+
+void test_enospc() {
+	set_test_metadata("append", _("append detects a full disk"), 1);
+	int ret = 0;
+	vfs_set_max_size("f.dat", 4);
+
+	SANDBOX_BEGIN;
+	ret = append("f.dat", "DEF");
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_TRUE(contents_equal("f.dat", "ABCD"));
+}
+
+void test_eacces() {
+	set_test_metadata("append", _("append reports the errors of open"), 1);
+	int ret = 0;
+	int err = 0;
+	vfs_set_errno("f.dat", EACCES);
+
+	SANDBOX_BEGIN;
+	ret = append("f.dat", "DEF");
+	err = errno;
+	SANDBOX_END;
+
+	CU_ASSERT_EQUAL(ret, -1);
+	CU_ASSERT_EQUAL(err, EACCES);
+	CU_ASSERT_TRUE(contents_equal("f.dat", "ABC"));
+}
+
+int main(int argc,char** argv)
+{
+	BAN_FUNCS();
+	set_vfs(true);
+	vfs_create("f.dat", "ABC", 3, 0644);
+	vfs_snapshot();
+	RUN(test_append, test_snapshot, test_enospc, test_eacces);
+}
@@ -39,7 +39,8 @@ if banned_funcs:
     p = subprocess.Popen(shlex.split("readelf -s student_code.o"), stderr=subprocess.STDOUT, stdout=subprocess.PIPE)
     readelf_output = p.communicate()[0].decode('utf-8')
     for func in banned_funcs:
-        if re.search("UND {}\n".format(func), readelf_output):
+        # The Makefile renames some functions to __wrap_FUNC in student_code.o
+        if re.search("UND (__wrap_)?{}\n".format(func), readelf_output):
             feedback.set_tag("banned_funcs", True)
             feedback.set_global_result("failed")
             feedback.set_global_feedback("Vous utilisez la fonction {}, qui n'est pas autorisée.".format(func))
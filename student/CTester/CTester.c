@@ -19,6 +19,10 @@
 #include <malloc.h>
 
 #include "wrap.h"
+#include "trap.h"
+#include "vfs.h"
+#include "simnet.h"
+#include "scratch.h"
 
 #define TAGS_NB_MAX 20
 #define TAGS_LEN_MAX 30
@@ -123,39 +127,35 @@ void set_tag(char *tag)
         strncpy(test_metadata.tags[test_metadata.nb_tags++], tag, TAGS_LEN_MAX);
 }
 
-void segv_handler(int sig, siginfo_t *unused, void *unused2)
+/*
+ * The signal handlers may interrupt the allocator, so they don't allocate:
+ * they only note the signal, and sandbox_fail reports it once the sandbox
+ * has been left.
+ */
+static volatile sig_atomic_t sandbox_signal = 0;
+static volatile sig_atomic_t sandbox_use_after_free = 0;
+
+void segv_handler(int sig, siginfo_t *info, void *unused2)
 {
-    (void)sig;
-    (void)unused;
     (void)unused2;
-    wrap_monitoring = false;
-    push_info_msg(_("Your code produced a segfault."));
-    set_tag("sigsegv");
-    wrap_monitoring = true;
+    sandbox_signal = sig;
+    sandbox_use_after_free = malloc_quarantined(info->si_addr);
     siglongjmp(segv_jmp, 1);
 }
 
 void fpe_handler(int sig, siginfo_t *unused, void *unused2)
 {
-    (void)sig;
     (void)unused;
     (void)unused2;
-    wrap_monitoring = false;
-    push_info_msg(_("Your code produced an arithmetic exception."));
-    set_tag("sigfpe");
-    wrap_monitoring = true;
+    sandbox_signal = sig;
     siglongjmp(segv_jmp, 1);
 }
 
 void alarm_handler(int sig, siginfo_t *unused, void *unused2)
 {
-    (void)sig;
     (void)unused;
     (void)unused2;
-    wrap_monitoring = false;
-    push_info_msg(_("Your code exceeded the maximal allowed execution time."));
-    set_tag("timeout");
-    wrap_monitoring = true;
+    sandbox_signal = sig;
     siglongjmp(segv_jmp, 1);
 }
 
@@ -178,12 +178,39 @@ int sandbox_begin()
     while ((n = read(usr_pipe_stdout[0], buf, BUFSIZ)) > 0);
     while ((n = read(usr_pipe_stderr[0], buf, BUFSIZ)) > 0);
 
+    // The peak heap usage is measured per sandbox
+    stats.memory.peak = stats.memory.used;
+
     wrap_monitoring = true;
     return 0;
 }
 
 void sandbox_fail()
 {
+    malloc_sandbox_abort();
+    wrap_monitoring = false;
+    switch (sandbox_signal) {
+        case SIGSEGV:
+            if (sandbox_use_after_free) {
+                push_info_msg(_("Your code used memory after freeing it."));
+                set_tag("use_after_free");
+            } else {
+                push_info_msg(_("Your code produced a segfault."));
+                set_tag("sigsegv");
+            }
+            break;
+        case SIGFPE:
+            push_info_msg(_("Your code produced an arithmetic exception."));
+            set_tag("sigfpe");
+            break;
+        case SIGALRM:
+            push_info_msg(_("Your code exceeded the maximal allowed execution time."));
+            set_tag("timeout");
+            break;
+    }
+    sandbox_signal = 0;
+    sandbox_use_after_free = 0;
+    wrap_monitoring = true;
     CU_FAIL("Segfault or timeout");
 }
 
@@ -195,7 +222,7 @@ void sandbox_end()
     dup2(true_stdout, STDOUT_FILENO); // TODO
     dup2(true_stderr, STDERR_FILENO);
 
-    // ... and looking for a double free warning
+    // ... and forwarding what the student wrote
     char buf[BUFSIZ];
     memset(buf, 0, sizeof(buf));
     ssize_t n = 0;
@@ -206,16 +233,51 @@ void sandbox_end()
 
 
     while ((n = read(pipe_stderr[0], buf, BUFSIZ)) > 0) {
-        if (strstr(buf, "double free or corruption") != NULL) {
-            // TODO n'y a-t-il pas un risque que le message se fasse couper en plusieurs morceaux à cause de read ?
-            CU_FAIL("Double free or corruption");
-            push_info_msg(_("Your code produced a double free."));
-            set_tag("double_free");
-        }
         write(usr_pipe_stderr[1], buf, n);
         write(STDERR_FILENO, buf, n);
     }
 
+    struct malloc_free_errors_t free_errors;
+    malloc_free_errors(&free_errors);
+    if (free_errors.double_free > 0) {
+        CU_FAIL("Double free");
+        push_info_msg(_("Your code produced a double free."));
+        set_tag("double_free");
+    }
+    if (free_errors.invalid > 0) {
+        CU_FAIL("Invalid free");
+        push_info_msg(_("Your code freed a pointer that was not returned by malloc."));
+        set_tag("invalid_free");
+    }
+    if (free_errors.interior > 0) {
+        CU_FAIL("Free of an interior pointer");
+        push_info_msg(_("Your code freed a pointer to the middle of an allocated block."));
+        set_tag("interior_free");
+    }
+
+    mmap_sandbox_end();
+
+    const char *fd_creator = NULL;
+    if (fd_sandbox_end(&fd_creator) > 0 && fd_leak_check_enabled()) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), _("Your code did not close a file descriptor returned by %s."), fd_creator);
+        CU_FAIL("File descriptor leak");
+        push_info_msg(msg);
+        set_tag("fd_leak");
+    }
+
+    // Writes in freed blocks are detected when they leave the quarantine
+    if (malloc_quarantine_flush() > 0) {
+        CU_FAIL("Use after free");
+        push_info_msg(_("Your code wrote in memory after freeing it."));
+        set_tag("use_after_free");
+    }
+
+    if (malloc_budget_refused() > 0) {
+        CU_FAIL("Heap budget exceeded");
+        push_info_msg(_("Your code tried to use more heap memory than allowed."));
+        set_tag("heap_budget");
+    }
 
     it_val.it_value.tv_sec = 0;
     it_val.it_value.tv_usec = 0;
@@ -242,6 +304,14 @@ void start_test()
     memset(&failures, 0, sizeof(failures));
     memset(&monitored, 0, sizeof(monitored));
     memset(&logs, 0, sizeof(logs));
+    malloc_reset_accounting();
+    free_all_traps();
+    callsite_reset();
+    mmap_reset();
+    fd_reset();
+    vfs_reset();
+    simnet_reset();
+    scratch_begin();
 }
 
 /**
@@ -283,8 +353,6 @@ int run_tests(int argc, char *argv[], void *tests[], int nb_tests) {
 
     mallopt(M_PERTURB, 142); // newly allocated memory with malloc will be set to ~142
 
-    // Code for detecting properly double free errors
-    mallopt(M_CHECK_ACTION, 1); // don't abort if double free
     true_stderr = dup(STDERR_FILENO); // preparing a non-blocking pipe for stderr
     true_stdout = dup(STDOUT_FILENO); // preparing a non-blocking pipe for stderr
     fstdout = fdopen(true_stdout, "w"); // We can't just copy-paste stdout and stderr
@@ -374,7 +442,9 @@ int run_tests(int argc, char *argv[], void *tests[], int nb_tests) {
 
         start_test();
 
-        if (CU_basic_run_test(pSuite,pTest) != CUE_SUCCESS) {
+        CU_ErrorCode run_ret = CU_basic_run_test(pSuite,pTest);
+        scratch_end();
+        if (run_ret != CUE_SUCCESS) {
             fclose(f_out);
             fprintf(stderr, "Error when executing tests: CU_basic_run_test\n");
             return CU_get_error();
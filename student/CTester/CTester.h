@@ -7,6 +7,8 @@
 
 #include "wrap.h"
 #include "trap.h"
+#include "vfs.h"
+#include "scratch.h"
 
 #include <libintl.h>
 #include <locale.h>
@@ -0,0 +1,92 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <string.h>
+
+#include "callsite.h"
+
+static struct callsite_t callsites[CALLSITE_MAX];
+static unsigned int callsites_n = 0;
+
+static size_t callsite_slot(const void *caller)
+{
+    uint64_t h = (uintptr_t)caller * 0x9e3779b97f4a7c15ull;
+    return (size_t)(h >> 32) & (CALLSITE_MAX - 1);
+}
+
+struct callsite_t *callsite_enter(const char *func, void *caller)
+{
+    size_t slot = callsite_slot(caller);
+    for (size_t probe = 0; probe < CALLSITE_MAX; probe++) {
+        struct callsite_t *cs = &callsites[slot];
+        void *c = __atomic_load_n(&cs->caller, __ATOMIC_ACQUIRE);
+        if (c == NULL) {
+            if (__atomic_load_n(&callsites_n, __ATOMIC_RELAXED) >= CALLSITE_MAX / 4 * 3) {
+                return NULL;
+            }
+            if (__atomic_compare_exchange_n(&cs->caller, &c, caller, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&cs->func, func, __ATOMIC_RELEASE);
+                __atomic_fetch_add(&callsites_n, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&cs->called, 1, __ATOMIC_RELAXED);
+                return cs;
+            }
+            // Another thread claimed the slot first: c is its caller
+        }
+        if (c == caller) {
+            const char *f;
+            while ((f = __atomic_load_n(&cs->func, __ATOMIC_ACQUIRE)) == NULL)
+                ; // The slot is being claimed by another thread
+            if (f == func) {
+                __atomic_fetch_add(&cs->called, 1, __ATOMIC_RELAXED);
+                return cs;
+            }
+        }
+        slot = (slot + 1) & (CALLSITE_MAX - 1);
+    }
+    return NULL;
+}
+
+void callsite_failed(struct callsite_t *cs)
+{
+    if (cs != NULL) {
+        __atomic_fetch_add(&cs->failed, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void callsite_bytes(struct callsite_t *cs, ssize_t bytes)
+{
+    if (cs != NULL && bytes > 0) {
+        __atomic_fetch_add(&cs->bytes, (uint64_t)bytes, __ATOMIC_RELAXED);
+    }
+}
+
+struct callsite_stats_t callsite_stats(const char *func, const char *caller)
+{
+    struct callsite_stats_t s;
+    memset(&s, 0, sizeof(s));
+    for (size_t i = 0; i < CALLSITE_MAX; i++) {
+        struct callsite_t *cs = &callsites[i];
+        if (cs->caller == NULL || cs->func == NULL || strcmp(cs->func, func) != 0) {
+            continue;
+        }
+        if (caller != NULL) {
+            Dl_info info;
+            if (dladdr(cs->caller, &info) == 0 || info.dli_sname == NULL
+                    || strcmp(info.dli_sname, caller) != 0) {
+                continue;
+            }
+        }
+        s.sites++;
+        s.called += cs->called;
+        s.failed += cs->failed;
+        s.bytes += cs->bytes;
+    }
+    return s;
+}
+
+void callsite_reset(void)
+{
+    if (callsites_n > 0) {
+        memset(callsites, 0, sizeof(callsites));
+        callsites_n = 0;
+    }
+}
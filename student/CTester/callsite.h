@@ -0,0 +1,75 @@
+#ifndef __CTESTER_CALLSITE_H__
+#define __CTESTER_CALLSITE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ * Statistics of the calls to the wrapped functions, by call site: a call site
+ * is identified by the return address of the call, i.e. by a call instruction
+ * in the code of the student, and by the wrapped function it calls.
+ *
+ * The wrappers fill the table with CALLSITE when the function is monitored,
+ * and start_test empties it. The table uses open addressing without locks:
+ * slots are claimed with an atomic compare-and-swap and the counters are
+ * updated atomically, so that recording a call only costs a hash lookup,
+ * even when the code of the student is multi-threaded.
+ */
+#define CALLSITE_MAX 1024 // Number of slots, a power of two; at most 3/4 are used
+
+struct callsite_t {
+    void *caller; // Return address of the call, NULL if the slot is empty
+    const char *func; // Name of the wrapped function
+    uint32_t called; // Number of calls
+    uint32_t failed; // Number of calls that failed because of failures
+    uint64_t bytes; // Bytes transferred (or allocated) by the calls
+};
+
+/**
+ * Counts a call to the wrapped function func (which must be a string literal)
+ * returning to caller, and returns its call site, or NULL if the table is full.
+ */
+struct callsite_t *callsite_enter(const char *func, void *caller);
+
+/**
+ * Counts a call from the caller of the current function, which must be
+ * the wrapper of func itself.
+ */
+#define CALLSITE(func) callsite_enter(func, __builtin_return_address(0))
+
+/**
+ * Counts a failure of the call, forced by failures.
+ * Does nothing if cs is NULL.
+ */
+void callsite_failed(struct callsite_t *cs);
+
+/**
+ * Adds bytes to the bytes transferred by the call site, if it is positive.
+ * Does nothing if cs is NULL.
+ */
+void callsite_bytes(struct callsite_t *cs, ssize_t bytes);
+
+struct callsite_stats_t {
+    int sites; // Number of call sites
+    int called;
+    int failed;
+    uint64_t bytes;
+};
+
+/**
+ * Returns the sums of the statistics of all the call sites of func in
+ * the function named caller (NULL for any function). The name of the function
+ * containing a call site is resolved with dladdr, which only knows the symbols
+ * exported by the executable: this is the case of the non-static functions,
+ * thanks to -rdynamic in the Makefile.
+ */
+struct callsite_stats_t callsite_stats(const char *func, const char *caller);
+
+/**
+ * Empties the table. Called by start_test.
+ */
+void callsite_reset(void);
+
+#endif // __CTESTER_CALLSITE_H__
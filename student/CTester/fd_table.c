@@ -0,0 +1,76 @@
+#include <string.h>
+
+#include "fd_table.h"
+#include "wrap.h"
+
+extern bool wrap_monitoring;
+extern struct wrap_stats_t stats;
+
+static struct fd_entry_t fds[FD_TABLE_SIZE];
+static bool leak_check = false;
+
+void set_fd_leak_check(bool enabled)
+{
+    leak_check = enabled;
+}
+
+bool fd_leak_check_enabled(void)
+{
+    return leak_check;
+}
+
+struct fd_entry_t *fd_entry(int fd)
+{
+    if (fd < 0 || fd >= FD_TABLE_SIZE) {
+        return NULL;
+    }
+    return &fds[fd];
+}
+
+void fd_opened(int fd, int type, const char *creator)
+{
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL) {
+        return;
+    }
+    e->type = type;
+    e->creator = creator;
+    e->student = wrap_monitoring;
+    if (wrap_monitoring) {
+        stats.fd.opened++;
+    }
+}
+
+void fd_closed(int fd)
+{
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL) {
+        return;
+    }
+    e->type = FD_TYPE_NONE;
+    e->creator = NULL;
+    e->student = false;
+}
+
+int fd_sandbox_end(const char **creator)
+{
+    int leaked = 0;
+    for (int fd = 0; fd < FD_TABLE_SIZE; fd++) {
+        if (fds[fd].student) {
+            if (leaked == 0 && creator != NULL) {
+                *creator = fds[fd].creator;
+            }
+            fds[fd].student = false;
+            leaked++;
+        }
+    }
+    stats.fd.leaked += leaked;
+    return leaked;
+}
+
+void fd_reset(void)
+{
+    for (int fd = 0; fd < FD_TABLE_SIZE; fd++) {
+        fds[fd].student = false;
+    }
+}
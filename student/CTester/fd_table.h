@@ -0,0 +1,88 @@
+#ifndef __CTESTER_FD_TABLE_H__
+#define __CTESTER_FD_TABLE_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "read_write.h"
+
+/**
+ * Registry of the file descriptors, indexed directly by their number.
+ *
+ * The wrappers of the calls creating a descriptor (open, creat, socket,
+ * accept) record it with the name of the call and its type, whether they
+ * are monitored or not, and the wrapper of close forgets it.
+ * The state of the buffered reads and writes of a descriptor
+ * (see read_write.h) is kept in the same entry, so that it is found without a search.
+ *
+ * The descriptors created inside the sandbox and still open at its end
+ * are counted as leaks by sandbox_end, which makes the test fail if
+ * the leak check is enabled with set_fd_leak_check.
+ * Descriptors above FD_TABLE_SIZE are not tracked.
+ */
+#define FD_TABLE_SIZE 1024
+
+#define FD_TYPE_NONE 0 // Not open, or not created by a wrapped call
+#define FD_TYPE_FILE 1 // File of the real file system
+#define FD_TYPE_VFS 2 // File of the VFS (see vfs.h)
+#define FD_TYPE_SOCKET 3 // Socket, from socket or accept
+
+struct fd_entry_t {
+    int type; // One of the FD_TYPE_ constants
+    const char *creator; // Name of the call that returned the descriptor
+    bool student; // Created inside the sandbox, and not closed since
+    bool read_buffered; // read holds a read_buffer_t set with set_read_buffer
+    struct read_item read;
+    bool write_buffered; // write holds a write_buffer_t set with set_write_buffer
+    struct write_item write;
+};
+
+/**
+ * Descriptors created and leaked by the code in the sandbox.
+ */
+struct stats_fd_t {
+    int opened; // Descriptors created inside the sandbox
+    int leaked; // Of these, descriptors still open at the end of the sandbox
+};
+
+/**
+ * Enables or disables the leak check; it stays so for the following tests.
+ * It should stay disabled for the code that returns a descriptor.
+ */
+void set_fd_leak_check(bool enabled);
+
+bool fd_leak_check_enabled(void);
+
+/**
+ * Returns the entry of fd, or NULL if fd is out of the table.
+ */
+struct fd_entry_t *fd_entry(int fd);
+
+/**
+ * Records that fd has just been returned by the call creator, with the
+ * given type. Does nothing if fd is negative (the call failed).
+ * The buffered reads set on fd before it was created are kept.
+ */
+void fd_opened(int fd, int type, const char *creator);
+
+/**
+ * Records that fd has been closed.
+ */
+void fd_closed(int fd);
+
+/**
+ * Counts in stats.fd.leaked the descriptors created inside the sandbox and
+ * still open, then forgets that they were, so that they are reported
+ * only once. Called by sandbox_end; returns the number of leaks, and
+ * sets *creator (if creator isn't NULL) to the name of the call that
+ * created the first one.
+ */
+int fd_sandbox_end(const char **creator);
+
+/**
+ * Forgets which descriptors were created inside the sandbox.
+ * Called by start_test.
+ */
+void fd_reset(void);
+
+#endif // __CTESTER_FD_TABLE_H__
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -6,8 +7,22 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
 
 #include "read_write.h"
+#include "fd_table.h"
+
+int __real_open(const char *pathname, int flags, mode_t mode);
+int __real_close(int fd);
+int __real_fstat(int fd, struct stat *buf);
+void *__real_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
+int __real_munmap(void *addr, size_t length);
 
 int64_t MILLION = 1000*1000;
 #define BILLION (1000*1000*1000)
@@ -45,38 +60,19 @@ int64_t get_time_interval(const struct timespec *pasttime, const struct timespec
 
 // #define READ_MODE_BUFCHUK 1 // not used
 
+
 /**
- * Precision for the 'interval' field.
- * It contains the wait time for the current chunk, as measured from the previous call.
- * It may be positive: in this case, it means the next data was not available
- * at the end of the previous call, and it is the time the current call has
- * to wait before accessing data. Minus the interval between the two calls.
- * It may be negative: in this case, it represents the opposite of the amout
- * of time the current chunk has been available.
- * Thanks to this field, we can enable the chunks at more or less the right moment.
+ * The read states are kept in the descriptor registry, indexed by fd;
+ * read_fd_n counts the fd's that have one.
  */
-struct read_item {
-    int fd; // the file descriptor this structure applies to
-    //int mode; // the type of data provider used; not used
-    const struct read_buffer_t *buf; // Provided read_buffer_t structure
-    unsigned int chunk_id; // Current chunk, or next chunk to be received
-    size_t bytes_read; // Number of bytes read inside the current chunk
-    struct timespec last_time; // Time of the end of the last call of read on this fd/socket
-    int64_t interval; // In real-time mode (READ_WRITE_REAL_INTERVAL), real wait interval for the current chunk (in nanoseconds).
-};
-
-struct read_fd_table_t {
-    size_t n;
-    struct read_item *items;
-} read_fd_table;
+static size_t read_fd_n = 0;
 
 struct read_item *read_get_entry(int fd)
 {
-    for (unsigned int i = 0; i < read_fd_table.n; i++) {
-        if (read_fd_table.items[i].fd == fd)
-            return &(read_fd_table.items[i]);
-    }
-    return NULL;
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL || !e->read_buffered)
+        return NULL;
+    return &(e->read);
 }
 
 bool fd_is_read_buffered(int fd)
@@ -84,199 +80,560 @@ bool fd_is_read_buffered(int fd)
     return (read_get_entry(fd) != NULL);
 }
 
-void reinit_read_fd_table_item(int i)
+int read_remove_entry(int fd)
 {
-    // We need to clean up _recv_fd_table.items[i]
-    read_fd_table.items[i].buf = NULL; // We're not responsible to free it.
-    read_fd_table.items[i].chunk_id = 0;
-    read_fd_table.items[i].interval = 0;
-    read_fd_table.items[i].last_time = (struct timespec) {
-        .tv_sec = 0,
-        .tv_nsec = 0
-    };
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL || !e->read_buffered)
+        return 0;
+    memset(&(e->read), 0, sizeof(struct read_item));
+    e->read_buffered = false;
+    read_fd_n--;
+    return 1;
 }
 
+/**
+ * Returns a pointer to the cleaned read state of fd,
+ * where we can safely store our informations,
+ * or NULL if fd is out of the registry.
+ */
+struct read_item *read_get_new_entry(int fd)
+{
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL)
+        return NULL;
+    if (!e->read_buffered) {
+        e->read_buffered = true;
+        read_fd_n++;
+    }
+    memset(&(e->read), 0, sizeof(struct read_item));
+    return &(e->read);
+}
 
-int read_remove_entry(int fd)
+/**
+ * Destination of the data read: the iovcnt buffers of iov, filled in order.
+ * The chunks are copied directly into them, without an intermediate buffer.
+ */
+struct read_dest {
+    const struct iovec *iov;
+    int iovcnt;
+    int idx; // Buffer being filled
+    size_t off; // Bytes already filled in iov[idx]
+    size_t done; // Bytes already filled in all the buffers
+};
+
+static void read_dest_copy(struct read_dest *dest, const char *src, size_t n)
 {
-    bool found = false;
-    for (unsigned int i = 0; i < read_fd_table.n; i++) {
-        if (read_fd_table.items[i].fd == fd) {
-            found = true;
-            if (i < read_fd_table.n - 1) {
-                struct read_item *dest = &(read_fd_table.items[i]);
-                memmove(dest, dest + 1, (read_fd_table.n - i - 1) * sizeof(struct read_item));
-                memset(&(read_fd_table.items[read_fd_table.n-1]), 0, sizeof(struct read_item));
-                // This is not really a problem that we have a useless thing at the end
-            }
-            read_fd_table.n--;
+    while (n > 0 && dest->idx < dest->iovcnt) {
+        const struct iovec *v = &(dest->iov[dest->idx]);
+        size_t k = MIN(n, v->iov_len - dest->off);
+        memmove((char *)v->iov_base + dest->off, src, k);
+        src += k;
+        n -= k;
+        dest->off += k;
+        dest->done += k;
+        if (dest->off >= v->iov_len) {
+            dest->idx++;
+            dest->off = 0;
         }
     }
-    if (read_fd_table.n == 0) {
-        free(read_fd_table.items);
-        read_fd_table.items = NULL;
+}
+
+/**
+ * Chunks of a mapped read buffer (see create_mapped_read_buffer):
+ * the file is mapped read-only, and the chunks are computed one at a time
+ * from the split rule, pointing directly into the mapping.
+ */
+struct read_mapping_t {
+    const char *data; // Mapped file
+    size_t len;
+    const char *sizes; // Mapped file of the sizes, for READ_SPLIT_SIZES
+    size_t sizes_len;
+    struct read_split_t split;
+};
+
+/**
+ * Computes in cur->chunk the chunk starting at cur->consumed
+ * (cur->chunk.buf is NULL after the end of the file).
+ */
+static void read_map_chunk(struct read_item *cur)
+{
+    const struct read_mapping_t *m = cur->buf->mapping;
+    if (cur->consumed >= m->len) {
+        memset(&(cur->chunk), 0, sizeof(cur->chunk));
+        return;
+    }
+    size_t rest = m->len - cur->consumed;
+    size_t size = rest;
+    if (m->split.rule == READ_SPLIT_FIXED) {
+        size = m->split.min_size;
+    } else if (m->split.rule == READ_SPLIT_RANDOM) {
+        size = rng_range(&(cur->rng), m->split.min_size, m->split.max_size);
+    } else { // READ_SPLIT_SIZES
+        // The zero sizes are skipped: an empty chunk would read as the end of the file
+        size_t pos = cur->sizes_pos, next = 0;
+        while (next == 0 && pos < m->sizes_len) {
+            while (pos < m->sizes_len && !isdigit((unsigned char)m->sizes[pos]))
+                pos++;
+            while (pos < m->sizes_len && isdigit((unsigned char)m->sizes[pos]))
+                next = next * 10 + (m->sizes[pos++] - '0');
+        }
+        if (next > 0)
+            size = next;
+        cur->sizes_pos = pos;
     }
-    return (found ? 1 : 0);
+    cur->chunk = (struct read_bufchunk_t) {
+        .interval = m->split.interval,
+        .buf = m->data + cur->consumed,
+        .buflen = MIN(size, rest)
+    };
 }
 
 /**
- * Returns a pointer to an entry in the table,
- * where we can safely store our informations.
- * May be a pre-existing chunk,
- * in which case the fd's will match.
+ * Computes in cur->chunk the current chunk of a mapped or generated buffer.
  */
-struct read_item *read_get_new_entry(int fd)
+static void read_load_chunk(struct read_item *cur)
 {
-    unsigned int i = 0;
-    for (i = 0; i < read_fd_table.n; i++) {
-        if (read_fd_table.items[i].fd == fd) {
-            // We should clean it before changing it
-            reinit_read_fd_table_item(i);
-            break;
+    cur->pending = false;
+    if ((cur->buf->mode & READ_WRITE_MAPPED) != 0) {
+        read_map_chunk(cur);
+    } else {
+        memset(&(cur->chunk), 0, sizeof(cur->chunk));
+        if (cur->buf->generate(cur->buf->generator_arg, cur->chunk_id, &(cur->chunk)) == 0) {
+            // End of the stream
+            memset(&(cur->chunk), 0, sizeof(cur->chunk));
         }
     }
-    if (i >= read_fd_table.n) {
-        // realloc
-        struct read_item *tmp = realloc(read_fd_table.items, (read_fd_table.n + 1) * sizeof(struct read_item));
-        if (tmp == NULL)
-            return NULL;
-        read_fd_table.items = tmp;
-        read_fd_table.n++;
+    if (READ_WRITE_INTERVAL_MODE(cur->buf->mode) == READ_WRITE_REAL_INTERVAL && cur->chunk.buf != NULL) {
+        cur->interval += MILLION * (cur->chunk.interval);
     }
-    // Now, we can insert at index i
-    return &(read_fd_table.items[i]);
 }
 
-size_t read_handle_buffer_no_rt(struct read_item *cur, void *buf, size_t len, int flags, int64_t call_interval)
+/**
+ * Returns the current chunk of cur, or NULL if all the chunks have been read.
+ * The chunk of a mapped or generated buffer is computed the first time it is needed.
+ */
+static const struct read_bufchunk_t *read_chunk(struct read_item *cur)
 {
-    const struct read_bufchunk_t *curchunk = &(cur->buf->chunks[cur->chunk_id]);
-    if (cur->bytes_read == 0) {
+    if ((cur->buf->mode & (READ_WRITE_MAPPED | READ_WRITE_GENERATED)) != 0) {
+        if (cur->pending) {
+            read_load_chunk(cur);
+        }
+        return (cur->chunk.buf != NULL ? &(cur->chunk) : NULL);
+    }
+    if (cur->chunk_id >= cur->buf->nchunks) {
+        return NULL;
+    }
+    return &(cur->buf->chunks[cur->chunk_id]);
+}
+
+/**
+ * Waits until the current chunk of cur is available, as required
+ * by its interval in the mode of the buffer.
+ * Returns 0, or -1 with errno set to EAGAIN if the call would block
+ * but the caller requested it shouldn't block.
+ */
+static int read_wait_chunk(struct read_item *cur, int flags, int64_t call_interval)
+{
+    const struct read_bufchunk_t *curchunk = read_chunk(cur);
+    int64_t sleeptime = 0;
+    if (READ_WRITE_INTERVAL_MODE(cur->buf->mode) == READ_WRITE_REAL_INTERVAL) {
+        /*
+         * Assume the following:
+         * - cur->interval was the time to wait for the current chunk to become
+         *   active, at the end of the previous call.
+         * - cur->bytes_read is 0 only if we have to wait.
+         */
+        cur->interval -= call_interval;
+        /*
+         * Assume the following:
+         * - cur->interval is the remaining time to wait for the current chunk to become active.
+         * - cur->bytes_read is 0 only if we have to wait.
+         */
+        sleeptime = cur->interval;
+    } else if (cur->bytes_read == 0 && !cur->ready) {
         // We may have to wait
-        int64_t sleeptime = 0;
-        if (cur->buf->mode == READ_WRITE_BEFORE_INTERVAL) {
+        if (READ_WRITE_INTERVAL_MODE(cur->buf->mode) == READ_WRITE_BEFORE_INTERVAL) {
             sleeptime = MILLION * (curchunk->interval);
         } else { // READ_WRITE_AFTER_INTERVAL
             sleeptime = MILLION * (curchunk->interval) - call_interval;
         }
-        if (sleeptime > 0) {
-            if ((flags & MSG_DONTWAIT) != 0) {
-                errno = EAGAIN;
-                return -1;
-            }
-            struct timespec tmp = (struct timespec) {
-                .tv_sec = sleeptime / BILLION,
-                .tv_nsec = sleeptime % BILLION
-            };
-            nanosleep(&tmp, NULL);
-            getnanotime(&(cur->last_time)); // We need to update
+    }
+    if (sleeptime > 0) {
+        if ((flags & MSG_DONTWAIT) != 0) {
+            errno = EAGAIN;
+            return -1;
         }
+        struct timespec tmp = (struct timespec) {
+            .tv_sec = sleeptime / BILLION,
+            .tv_nsec = sleeptime % BILLION
+        };
+        nanosleep(&tmp, NULL);
+        getnanotime(&(cur->last_time)); // We need to update
+        if (READ_WRITE_INTERVAL_MODE(cur->buf->mode) == READ_WRITE_REAL_INTERVAL) {
+            cur->interval = 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Moves cur to the next chunk.
+ */
+static void read_next_chunk(struct read_item *cur)
+{
+    cur->consumed += read_chunk(cur)->buflen;
+    cur->chunk_id++;
+    cur->bytes_read = 0;
+    cur->ready = false;
+    if ((cur->buf->mode & (READ_WRITE_MAPPED | READ_WRITE_GENERATED)) != 0) {
+        // Loaded by the next read, which also updates the interval
+        cur->pending = true;
+    } else if (READ_WRITE_INTERVAL_MODE(cur->buf->mode) == READ_WRITE_REAL_INTERVAL
+            && cur->chunk_id < cur->buf->nchunks) {
+        // Update interval
+        cur->interval += MILLION * (cur->buf->chunks[cur->chunk_id].interval);
     }
+}
+
+ssize_t read_handle_buffer_no_rt(struct read_item *cur, struct read_dest *dest, size_t len, int flags, int64_t call_interval)
+{
+    if (read_wait_chunk(cur, flags, call_interval) < 0) {
+        return -1;
+    }
+    const struct read_bufchunk_t *curchunk = read_chunk(cur);
     size_t bytes_left = curchunk->buflen - cur->bytes_read;
     size_t transfered_bytes = MIN(len, bytes_left);
-    memmove(buf, (curchunk->buf + cur->bytes_read), transfered_bytes);
+    read_dest_copy(dest, (const char *)curchunk->buf + cur->bytes_read, transfered_bytes);
     cur->bytes_read += transfered_bytes;
+    cur->ready = true;
     if (cur->bytes_read >= curchunk->buflen) {
-        cur->chunk_id++;
-        cur->bytes_read = 0;
+        read_next_chunk(cur);
     }
     return transfered_bytes;
 }
 
-size_t read_handle_buffer_rt(struct read_item *cur, void *buf, size_t len, int flags, int64_t call_interval)
+ssize_t read_handle_buffer_rt(struct read_item *cur, struct read_dest *dest, size_t len, int flags, int64_t call_interval)
 {
-    /*
-     * Assume the following:
-     * - cur->interval was the time to wait for the current chunk to become
-     *   active, at the end of the previous call.
-     * - cur->bytes_read is 0 only if we have to wait.
-     */
-    cur->interval -= call_interval;
-    /*
-     * Assume the following:
-     * - cur->interval is the remaining time to wait for the current chunk to become active.
-     * - cur->bytes_read is 0 only if we have to wait.
-     */
-    if (cur->interval > 0) {
-        if ((flags & MSG_DONTWAIT) != 0) {
-            // The call would block but the caller requested it shouldn't block
-            errno = EAGAIN;
-            return -1;
-        }
-        int64_t sleeptime = cur->interval;
-        struct timespec tmp = (struct timespec) {
-            .tv_sec = sleeptime / BILLION,
-            .tv_nsec = sleeptime % BILLION
-        };
-        nanosleep(&tmp, NULL);
-        cur->interval = 0;
-        getnanotime(&(cur->last_time));
+    if (read_wait_chunk(cur, flags, call_interval) < 0) {
+        return -1;
     }
     /*
      * Assume the following:
      * - cur->interval is the negative of the time the current chunk has been available.
      */
     size_t total_bytes = 0;
-    for (unsigned int i = cur->chunk_id; i < cur->buf->nchunks; i++) {
-        if (len <= 0) {
-            break;
-        }
-        const struct read_bufchunk_t *curchunk = &(cur->buf->chunks[i]);
+    const struct read_bufchunk_t *curchunk;
+    // Stops at the first chunk not available yet
+    while (len > 0 && (curchunk = read_chunk(cur)) != NULL && cur->interval <= 0) {
         size_t bytes_left = curchunk->buflen - cur->bytes_read;
         size_t transfered_bytes = MIN(len, bytes_left);
-        memmove((buf + total_bytes), (curchunk->buf + cur->bytes_read), transfered_bytes);
+        read_dest_copy(dest, (const char *)curchunk->buf + cur->bytes_read, transfered_bytes);
         cur->bytes_read += transfered_bytes;
         len -= transfered_bytes;
         total_bytes += transfered_bytes;
         if (cur->bytes_read >= curchunk->buflen) {
             // Emptied chunk
-            cur->chunk_id++;
-            cur->bytes_read = 0;
-            if (cur->chunk_id < cur->buf->nchunks) {
-                // Update interval
-                cur->interval += MILLION * (cur->buf->chunks[cur->chunk_id].interval);
-                if (cur->interval > 0) {
-                    break; // Not available yet
-                }
-            }
+            read_next_chunk(cur);
         }
     }
     return total_bytes;
 }
 
-ssize_t read_handle_buffer(int fd, void *buf, size_t len, int flags)
+/**
+ * Receives the current chunk as a single datagram: the bytes that don't
+ * fit in dest are discarded, and the address of the chunk is copied in msg.
+ * Returns the full length of the datagram.
+ */
+ssize_t read_handle_datagram(struct read_item *cur, struct read_dest *dest, struct msghdr *msg, int flags, int64_t call_interval)
+{
+    if (read_wait_chunk(cur, flags, call_interval) < 0) {
+        return -1;
+    }
+    const struct read_bufchunk_t *curchunk = read_chunk(cur);
+    size_t buflen = curchunk->buflen;
+    read_dest_copy(dest, curchunk->buf, buflen);
+    if (dest->done < curchunk->buflen) {
+        msg->msg_flags |= MSG_TRUNC;
+    }
+    if (msg->msg_name != NULL && curchunk->addr != NULL) {
+        memcpy(msg->msg_name, curchunk->addr, MIN(msg->msg_namelen, curchunk->addrlen));
+    }
+    msg->msg_namelen = (curchunk->addr != NULL ? curchunk->addrlen : 0);
+    read_next_chunk(cur);
+    return buflen;
+}
+
+ssize_t read_handle_buffer_msg(int fd, struct msghdr *msg, int flags)
 {
-    // TODO add support for MSG_OOB, MSG_PEEK and MSG_WAITALL to flags
+    if ((flags & MSG_OOB) != 0) {
+        // There is never out-of-band data in a read buffer
+        errno = EINVAL;
+        return -1;
+    }
     struct read_item *cur = read_get_entry(fd);
     if (cur == NULL) {
         errno = EINTR; // This is about the only case where this can happen
         return -1;
     }
+    struct read_dest dest = {
+        .iov = msg->msg_iov,
+        .iovcnt = msg->msg_iovlen,
+        .idx = 0,
+        .off = 0,
+        .done = 0
+    };
+    size_t len = 0;
+    for (size_t i = 0; i < msg->msg_iovlen; i++) {
+        len += msg->msg_iov[i].iov_len;
+    }
+    socklen_t namelen = msg->msg_namelen;
+    msg->msg_namelen = 0; // A byte stream has no source address
+    msg->msg_controllen = 0;
+    msg->msg_flags = 0;
+    bool datagram = (cur->buf->mode & READ_WRITE_DATAGRAM) != 0;
+    if ((flags & MSG_PEEK) != 0 && (cur->buf->mode & READ_WRITE_GENERATED) != 0) {
+        /*
+         * The generator reuses its memory, so that the chunks after the
+         * current one can't be generated and then restored: a peek stops
+         * at the end of the current chunk.
+         */
+        const struct read_bufchunk_t *curchunk = read_chunk(cur);
+        if (curchunk != NULL) {
+            len = MIN(len, curchunk->buflen - cur->bytes_read);
+        }
+        flags &= ~MSG_WAITALL;
+    }
+    // A peek is a normal read, after which the position is restored
+    struct read_item saved = *cur;
+    ssize_t ret = 0;
+    do {
+        struct timespec curtime;
+        getnanotime(&curtime);
+        int64_t call_interval = get_time_interval(&(cur->last_time), &curtime);
+        cur->last_time = curtime;
+        if (read_chunk(cur) == NULL) {
+            if (datagram) {
+                // No datagram will ever arrive, as if a receive timeout had expired
+                errno = EAGAIN;
+                ret = -1;
+            }
+            // Nothing left to read
+            break;
+        }
+        int mode = READ_WRITE_INTERVAL_MODE(cur->buf->mode);
+        if (datagram) {
+            msg->msg_namelen = namelen;
+            ret = read_handle_datagram(cur, &dest, msg, flags, call_interval);
+            // MSG_WAITALL has no effect on datagrams
+            break;
+        } else if (mode == READ_WRITE_BEFORE_INTERVAL || mode == READ_WRITE_AFTER_INTERVAL) {
+            ret = read_handle_buffer_no_rt(cur, &dest, len - dest.done, flags, call_interval);
+        } else if (mode == READ_WRITE_REAL_INTERVAL) {
+            ret = read_handle_buffer_rt(cur, &dest, len - dest.done, flags, call_interval);
+        } else {
+            errno = EINVAL;
+            ret = -1;
+        }
+        // With MSG_WAITALL, we read until len bytes, the end or an error
+    } while (ret >= 0 && (flags & MSG_WAITALL) != 0 && dest.done < len);
+    if ((flags & MSG_PEEK) != 0) {
+        /*
+         * The waits already done stay done: the next call computes its
+         * intervals from the restored last_time, and ready tells
+         * that the current chunk has already been waited for.
+         */
+        saved.ready = saved.ready || (ret >= 0 && saved.bytes_read == 0);
+        *cur = saved;
+    }
+    if (ret < 0 && dest.done == 0) {
+        return -1;
+    }
+    if (datagram && (flags & MSG_TRUNC) != 0) {
+        // The real length of the datagram, even if it was truncated
+        return ret;
+    }
+    return dest.done;
+}
+
+ssize_t read_handle_buffer_iov(int fd, const struct iovec *iov, int iovcnt, int flags)
+{
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (struct iovec *)iov;
+    msg.msg_iovlen = iovcnt;
+    return read_handle_buffer_msg(fd, &msg, flags);
+}
+
+ssize_t read_handle_buffer(int fd, void *buf, size_t len, int flags)
+{
+    struct iovec iov = {
+        .iov_base = buf,
+        .iov_len = len
+    };
+    return read_handle_buffer_iov(fd, &iov, 1, flags);
+}
+
+void reinit_read_fd_table()
+{
+    // As we're not responsible to clean up all the recv_buffer_t, we can just forget them
+    for (int fd = 0; read_fd_n > 0 && fd < FD_TABLE_SIZE; fd++) {
+        read_remove_entry(fd);
+    }
+}
+
+size_t read_fd_count()
+{
+    return read_fd_n;
+}
+
+/**
+ * write-related
+ */
+
+struct write_item *write_get_entry(int fd)
+{
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL || !e->write_buffered)
+        return NULL;
+    return &(e->write);
+}
+
+bool fd_is_write_buffered(int fd)
+{
+    return (write_get_entry(fd) != NULL);
+}
+
+int set_write_buffer(int fd, const struct write_buffer_t *buf)
+{
+    struct fd_entry_t *e = fd_entry(fd);
+    if (e == NULL) {
+        return (buf == NULL ? 0 : -1);
+    }
+    bool already_there = e->write_buffered;
+    memset(&(e->write), 0, sizeof(struct write_item));
+    e->write_buffered = (buf != NULL);
+    if (buf != NULL) {
+        e->write.buf = buf;
+        getnanotime(&(e->write.last_time));
+    }
+    return (already_there ? 1 : 0);
+}
+
+ssize_t get_bytes_written(int fd)
+{
+    struct write_item *cur = write_get_entry(fd);
+    if (cur == NULL)
+        return -1;
+    return cur->bytes_written;
+}
+
+/**
+ * Removes from cur->queued the bytes drained since the last call.
+ */
+static void write_drain(struct write_item *cur)
+{
     struct timespec curtime;
     getnanotime(&curtime);
-    int64_t call_interval = get_time_interval(&(cur->last_time), &curtime);
-    cur->last_time = curtime;
-    if (cur->chunk_id >= cur->buf->nchunks) {
-        // Nothing left to read; we can return immediately 0
-        // TODO remove this as a particular case
-        return 0;
+    uint64_t rate = cur->buf->drain_rate;
+    if (rate == 0 || cur->queued == 0) {
+        cur->queued = 0;
+        cur->last_time = curtime;
+        return;
     }
-    size_t bytes_transfered = 0;
-    if (cur->buf->mode == READ_WRITE_BEFORE_INTERVAL || cur->buf->mode == READ_WRITE_AFTER_INTERVAL) {
-        bytes_transfered = read_handle_buffer_no_rt(cur, buf, len, flags, call_interval);
-    } else if (cur->buf->mode == READ_WRITE_REAL_INTERVAL) {
-        bytes_transfered = read_handle_buffer_rt(cur, buf, len, flags, call_interval);
-    } else {
+    int64_t elapsed = get_time_interval(&(cur->last_time), &curtime);
+    uint64_t drained = (elapsed <= 0 ? 0 : (uint64_t)elapsed * rate / BILLION);
+    if (drained >= cur->queued) {
+        cur->queued = 0;
+        cur->last_time = curtime;
+    } else if (drained > 0) {
+        // The time of a partially drained byte is kept for the next call
+        cur->queued -= drained;
+        int64_t ns = cur->last_time.tv_nsec + (int64_t)(drained * BILLION / rate);
+        cur->last_time.tv_sec += ns / BILLION;
+        cur->last_time.tv_nsec = ns % BILLION;
+    }
+}
+
+static bool fd_is_nonblocking(int fd, int flags)
+{
+    if ((flags & MSG_DONTWAIT) != 0)
+        return true;
+    int fl = fcntl(fd, F_GETFL);
+    return (fl != -1 && (fl & O_NONBLOCK) != 0);
+}
+
+ssize_t write_reserve_buffer(int fd, size_t len, int flags)
+{
+    struct write_item *cur = write_get_entry(fd);
+    if (cur == NULL) {
+        errno = EINTR;
         return -1;
     }
-    return bytes_transfered;
+    const struct write_buffer_t *wbuf = cur->buf;
+    unsigned int call_id = cur->call_id++;
+    if (wbuf->eintr_every != 0 && (call_id + 1) % wbuf->eintr_every == 0) {
+        errno = EINTR;
+        return -1;
+    }
+    if (len == 0)
+        return 0;
+    if (call_id < wbuf->nchunks)
+        len = MIN(len, wbuf->chunks[call_id]);
+    write_drain(cur);
+    if (wbuf->capacity != 0 && cur->queued >= wbuf->capacity) {
+        if (fd_is_nonblocking(fd, flags)) {
+            errno = EAGAIN;
+            return -1;
+        }
+        // Wait until at least one byte has been drained
+        uint64_t excess = cur->queued - wbuf->capacity + 1;
+        int64_t sleeptime = (excess * BILLION + wbuf->drain_rate - 1) / wbuf->drain_rate;
+        struct timespec tmp = (struct timespec) {
+            .tv_sec = sleeptime / BILLION,
+            .tv_nsec = sleeptime % BILLION
+        };
+        nanosleep(&tmp, NULL);
+        write_drain(cur);
+    }
+    if (wbuf->capacity != 0)
+        len = MIN(len, wbuf->capacity - cur->queued);
+    return len;
 }
 
-void reinit_read_fd_table()
+void write_commit_buffer(int fd, const struct iovec *iov, int iovcnt, size_t len)
 {
-    // As we're not responsible to clean up all the recv_buffer_t, we can just free everything up
-    free(read_fd_table.items);
-    read_fd_table.items = NULL;
-    read_fd_table.n = 0;
+    struct write_item *cur = write_get_entry(fd);
+    if (cur == NULL)
+        return;
+    const struct write_buffer_t *wbuf = cur->buf;
+    // Copy the accepted bytes that fit in capture
+    size_t copied = cur->bytes_written;
+    for (int i = 0; i < iovcnt && copied < MIN(wbuf->capture_len, cur->bytes_written + len); i++) {
+        size_t n = MIN(iov[i].iov_len, MIN(wbuf->capture_len, cur->bytes_written + len) - copied);
+        memcpy((char *)wbuf->capture + copied, iov[i].iov_base, n);
+        copied += n;
+    }
+    cur->bytes_written += len;
+    cur->queued += len;
+}
+
+ssize_t write_handle_buffer(int fd, const struct iovec *iov, int iovcnt, int flags)
+{
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    ssize_t ret = write_reserve_buffer(fd, len, flags);
+    if (ret > 0)
+        write_commit_buffer(fd, iov, iovcnt, ret);
+    return ret;
+}
+
+void reinit_write_fd_table()
+{
+    for (int fd = 0; fd < FD_TABLE_SIZE; fd++) {
+        set_write_buffer(fd, NULL);
+    }
 }
 
 /*int enable_socket_recv_send_monitoring(bool active)
@@ -302,9 +659,10 @@ int set_read_buffer(int fd, const struct read_buffer_t *buf)
     if (buf == NULL) {
         return read_remove_entry(fd);
     }
-    if (buf->mode != READ_WRITE_REAL_INTERVAL &&
-        buf->mode != READ_WRITE_AFTER_INTERVAL &&
-        buf->mode != READ_WRITE_BEFORE_INTERVAL) {
+    int mode = READ_WRITE_INTERVAL_MODE(buf->mode);
+    if (mode != READ_WRITE_REAL_INTERVAL &&
+        mode != READ_WRITE_AFTER_INTERVAL &&
+        mode != READ_WRITE_BEFORE_INTERVAL) {
         return -2;
     }
     bool already_there = false;
@@ -320,11 +678,16 @@ int set_read_buffer(int fd, const struct read_buffer_t *buf)
     tmp->chunk_id = 0;
     tmp->bytes_read = 0;
     getnanotime(&(tmp->last_time));
-    if (buf->mode == READ_WRITE_REAL_INTERVAL && buf->nchunks > 0) {
+    tmp->interval = 0;
+    if ((buf->mode & (READ_WRITE_MAPPED | READ_WRITE_GENERATED)) != 0) {
+        if ((buf->mode & READ_WRITE_MAPPED) != 0) {
+            rng_seed(&(tmp->rng), buf->mapping->split.seed);
+        }
+        // The first chunk, and its interval, are computed by the first read
+        tmp->pending = true;
+    } else if (mode == READ_WRITE_REAL_INTERVAL && buf->nchunks > 0) {
         // The first wait interval should be that of the first chunk.
         tmp->interval = MILLION * (buf->chunks[0].interval);
-    } else {
-        tmp->interval = 0;
     }
     return (already_there ? 1 : 0);
 }
@@ -335,14 +698,8 @@ ssize_t get_bytes_read(int fd)
     struct read_item *cur = read_get_entry(fd);
     if (cur == NULL)
         return -1;
-    size_t bread = 0;
-    for (unsigned int i = 0; i < cur->chunk_id; i++) {
-        bread += cur->buf->chunks[i].buflen;
-    }
-    if (cur->chunk_id < cur->buf->nchunks) {
-        bread += cur->bytes_read;
-    }
-    return bread;
+    // bytes_read is 0 after the last chunk
+    return cur->consumed + cur->bytes_read;
 }
 
 int get_current_chunk_id(int fd)
@@ -380,6 +737,9 @@ struct read_buffer_t *create_read_buffer(void *data, size_t n, off_t *offsets, i
     if (!buf)
         return NULL;
     buf->mode = mode;
+    buf->mapping = NULL;
+    buf->generate = NULL;
+    buf->generator_arg = NULL;
     if (create_partial_read_buffer(data, n, offsets, intervals, buf)) {
         free(buf);
         return NULL;
@@ -387,6 +747,309 @@ struct read_buffer_t *create_read_buffer(void *data, size_t n, off_t *offsets, i
     return buf;
 }
 
+/**
+ * Maps the file path read-only in *data, and its size in *len.
+ * Returns 0 on success, -1 with errno set.
+ */
+static int map_file(const char *path, const char **data, size_t *len)
+{
+    int fd = __real_open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (__real_fstat(fd, &st) < 0) {
+        int err = errno;
+        __real_close(fd);
+        errno = err;
+        return -1;
+    }
+    *data = NULL;
+    *len = st.st_size;
+    if (*len > 0) {
+        void *p = __real_mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            int err = errno;
+            __real_close(fd);
+            errno = err;
+            return -1;
+        }
+        // The chunks are read once, in order
+        madvise(p, *len, MADV_SEQUENTIAL);
+        *data = p;
+    }
+    __real_close(fd);
+    return 0;
+}
+
+static void unmap_file(const char *data, size_t len)
+{
+    if (data != NULL)
+        __real_munmap((void *)data, len);
+}
+
+struct read_buffer_t *create_mapped_read_buffer(const char *path, const struct read_split_t *split, int mode)
+{
+    if ((split->rule == READ_SPLIT_FIXED && split->min_size == 0)
+            || (split->rule == READ_SPLIT_RANDOM && (split->min_size == 0 || split->min_size > split->max_size))
+            || (split->rule == READ_SPLIT_SIZES && split->sizes_path == NULL)
+            || (split->rule != READ_SPLIT_FIXED && split->rule != READ_SPLIT_RANDOM && split->rule != READ_SPLIT_SIZES)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    struct read_buffer_t *buf = malloc(sizeof(*buf));
+    struct read_mapping_t *m = malloc(sizeof(*m));
+    if (buf == NULL || m == NULL) {
+        free(buf);
+        free(m);
+        return NULL;
+    }
+    memset(m, 0, sizeof(*m));
+    m->split = *split;
+    m->split.sizes_path = NULL; // Only needed here
+    if (map_file(path, &(m->data), &(m->len)) < 0
+            || (split->rule == READ_SPLIT_SIZES && map_file(split->sizes_path, &(m->sizes), &(m->sizes_len)) < 0)) {
+        int err = errno;
+        unmap_file(m->data, m->len);
+        free(m);
+        free(buf);
+        errno = err;
+        return NULL;
+    }
+    buf->mode = mode | READ_WRITE_MAPPED;
+    buf->nchunks = 0;
+    buf->chunks = NULL;
+    buf->mapping = m;
+    buf->generate = NULL;
+    buf->generator_arg = NULL;
+    return buf;
+}
+
+struct read_buffer_t *create_generated_read_buffer(read_generator_t generate, void *arg, int mode)
+{
+    if (generate == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+    struct read_buffer_t *buf = malloc(sizeof(*buf));
+    if (buf == NULL)
+        return NULL;
+    buf->mode = mode | READ_WRITE_GENERATED;
+    buf->nchunks = 0;
+    buf->chunks = NULL;
+    buf->mapping = NULL;
+    buf->generate = generate;
+    buf->generator_arg = arg;
+    return buf;
+}
+
+static bool read_schedule_valid(const struct read_schedule_t *schedule)
+{
+    switch (schedule->kind) {
+    case READ_SCHEDULE_UNIFORM:
+        return schedule->min_size > 0 && schedule->min_size <= schedule->max_size;
+    case READ_SCHEDULE_GEOMETRIC:
+        return schedule->mean_size > 0;
+    case READ_SCHEDULE_BYTES:
+        return true;
+    case READ_SCHEDULE_DELIMITER:
+        return schedule->delimiter != NULL && schedule->delimiter[0] != '\0';
+    default:
+        return false;
+    }
+}
+
+/**
+ * Adds to cuts, of *ncuts positions, the positions where data is cut
+ * around the delimiters, in increasing order.
+ */
+static void read_schedule_cuts(const char *data, size_t len, const char *delimiter, struct rng_t *rng, size_t *cuts, size_t *ncuts)
+{
+    size_t dlen = strlen(delimiter);
+    const char *p = data;
+    while ((size_t)(p - data) < len
+            && (p = memmem(p, len - (p - data), delimiter, dlen)) != NULL) {
+        size_t start = p - data;
+        for (size_t pos = start; pos <= start + dlen; pos++) {
+            bool last = (*ncuts > 0 ? cuts[*ncuts - 1] : 0) >= pos;
+            if (pos > 0 && pos < len && !last && (rng_next(rng) & 1) != 0) {
+                cuts[(*ncuts)++] = pos;
+            }
+        }
+        p += dlen;
+    }
+}
+
+ssize_t read_schedule(const void *data, size_t len, const struct read_schedule_t *schedule, off_t **offsets, int **intervals)
+{
+    if (!read_schedule_valid(schedule)) {
+        errno = EINVAL;
+        return -1;
+    }
+    // There are at most len chunks, of one byte
+    *offsets = malloc((len > 0 ? len : 1) * sizeof(off_t));
+    *intervals = malloc((len > 0 ? len : 1) * sizeof(int));
+    size_t *cuts = NULL;
+    if (schedule->kind == READ_SCHEDULE_DELIMITER) {
+        cuts = malloc((len > 0 ? len : 1) * sizeof(size_t));
+    }
+    if (*offsets == NULL || *intervals == NULL || (schedule->kind == READ_SCHEDULE_DELIMITER && cuts == NULL)) {
+        free(*offsets);
+        free(*intervals);
+        free(cuts);
+        return -1;
+    }
+    struct rng_t rng;
+    rng_seed(&rng, schedule->seed);
+    size_t ncuts = 0, cut = 0;
+    if (schedule->kind == READ_SCHEDULE_DELIMITER) {
+        read_schedule_cuts(data, len, schedule->delimiter, &rng, cuts, &ncuts);
+    }
+    size_t n = 0;
+    for (size_t pos = 0; pos < len; n++) {
+        size_t rest = len - pos;
+        size_t size = 1;
+        if (schedule->kind == READ_SCHEDULE_UNIFORM) {
+            size = rng_range(&rng, schedule->min_size, schedule->max_size);
+        } else if (schedule->kind == READ_SCHEDULE_GEOMETRIC) {
+            while (size < rest && rng_next(&rng) % schedule->mean_size != 0)
+                size++;
+        } else if (schedule->kind == READ_SCHEDULE_DELIMITER) {
+            size = (cut < ncuts ? cuts[cut++] : len) - pos;
+        }
+        size = MIN(size, rest);
+        (*offsets)[n] = size;
+        (*intervals)[n] = (schedule->max_interval > 0 ? (int)rng_range(&rng, 0, schedule->max_interval) : 0);
+        pos += size;
+    }
+    free(cuts);
+    return n;
+}
+
+struct read_buffer_t *create_scheduled_read_buffer(void *data, size_t len, const struct read_schedule_t *schedule, int mode)
+{
+    off_t *offsets;
+    int *intervals;
+    ssize_t n = read_schedule(data, len, schedule, &offsets, &intervals);
+    if (n < 0)
+        return NULL;
+    struct read_buffer_t *buf = create_read_buffer(data, n, offsets, intervals, mode);
+    free(offsets);
+    free(intervals);
+    return buf;
+}
+
+/**
+ * Runs one check of read_schedule_search in a child, which exits
+ * with 0 if it succeeded.
+ */
+static pid_t read_schedule_fork(const struct read_schedule_t *schedule, read_schedule_check_t check, void *arg)
+{
+    // Else the buffered output would be written by the children too
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // The handler of the parent jumps back into its sandbox
+        signal(SIGALRM, SIG_DFL);
+        alarm(READ_SCHEDULE_TIMEOUT);
+        _exit(check(schedule, arg) == 0 ? 0 : 1);
+    }
+    return pid;
+}
+
+int read_schedule_search(const void *data, size_t len, const struct read_schedule_t *schedule, int k,
+        read_schedule_check_t check, void *arg, struct read_schedule_t *failing)
+{
+    if (k <= 0 || !read_schedule_valid(schedule)) {
+        errno = EINVAL;
+        return -1;
+    }
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs < 1)
+        jobs = 1;
+    pid_t *pids = malloc(k * sizeof(pid_t));
+    bool *failed = malloc(k * sizeof(bool));
+    if (pids == NULL || failed == NULL) {
+        free(pids);
+        free(failed);
+        return -1;
+    }
+    int started = 0, running = 0, err = 0;
+    while (started < k || running > 0) {
+        if (started < k && running < jobs && err == 0) {
+            struct read_schedule_t s = *schedule;
+            s.seed += started;
+            pids[started] = read_schedule_fork(&s, check, arg);
+            if (pids[started] < 0) {
+                err = errno;
+                k = started; // Waits for the running children, then fails
+            } else {
+                started++;
+                running++;
+            }
+            continue;
+        }
+        // Only waits for its own children, not for the mock servers
+        // and clients the test may have launched
+        int status, oldest = -1;
+        bool reaped = false;
+        for (int i = 0; i < started && !reaped; i++) {
+            if (pids[i] <= 0)
+                continue;
+            if (oldest < 0)
+                oldest = i;
+            pid_t pid = waitpid(pids[i], &status, WNOHANG);
+            if (pid == pids[i]) {
+                failed[i] = !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+                pids[i] = 0;
+                running--;
+                reaped = true;
+            }
+        }
+        if (reaped)
+            continue;
+        // None has ended yet: blocks on the oldest one
+        if (waitpid(pids[oldest], &status, 0) < 0) {
+            if (errno == EINTR)
+                continue;
+            err = errno;
+            break;
+        }
+        failed[oldest] = !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        pids[oldest] = 0;
+        running--;
+    }
+    int nfailed = 0;
+    ssize_t best = -1;
+    for (int i = 0; err == 0 && i < k; i++) {
+        if (!failed[i])
+            continue;
+        nfailed++;
+        struct read_schedule_t s = *schedule;
+        s.seed += i;
+        off_t *offsets;
+        int *intervals;
+        ssize_t n = read_schedule(data, len, &s, &offsets, &intervals);
+        if (n < 0) {
+            err = errno;
+            break;
+        }
+        free(offsets);
+        free(intervals);
+        if (best < 0 || n < best) {
+            best = n;
+            if (failing != NULL)
+                *failing = s;
+        }
+    }
+    free(pids);
+    free(failed);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return nfailed;
+}
+
 void free_partial_read_buffer(struct read_buffer_t *buf)
 {
     for (unsigned int i = 0; i < buf->nchunks; i++) {
@@ -403,6 +1066,13 @@ void free_partial_read_buffer(struct read_buffer_t *buf)
 
 void free_read_buffer(struct read_buffer_t *buf)
 {
+    if ((buf->mode & READ_WRITE_MAPPED) != 0) {
+        struct read_mapping_t *m = buf->mapping;
+        unmap_file(m->data, m->len);
+        unmap_file(m->sizes, m->sizes_len);
+        free(m);
+        buf->mapping = NULL;
+    }
     free_partial_read_buffer(buf);
     buf->mode = 0;
     free(buf);
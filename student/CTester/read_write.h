@@ -19,6 +19,13 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+#include "util_random.h"
 
 /**
  * Functions and structures for manipulating read and write system calls,
@@ -109,11 +116,15 @@
  *   of the previous chunk, and thus relative.
  * - buf : chunk of data to be read.
  * - buflen: length of this buffer.
+ * - addr, addrlen: in datagram mode (READ_WRITE_DATAGRAM), source address of
+ *   the chunk, returned by recvfrom and recvmsg; unused otherwise.
  */
 struct read_bufchunk_t {
     int interval;
     const void *buf;
     size_t buflen;
+    const struct sockaddr *addr; // Source address of the datagram, may be NULL
+    socklen_t addrlen;
 };
 
 /**
@@ -137,17 +148,114 @@ struct read_bufchunk_t {
 #define READ_WRITE_AFTER_INTERVAL 2 // At least interval µs after emptying the chunk
 #define READ_WRITE_BEFORE_INTERVAL 3 // At least interval µs before reading a new chunk
 
+/**
+ * Flag to combine with one of the modes above (for example
+ * READ_WRITE_BEFORE_INTERVAL | READ_WRITE_DATAGRAM), for a SOCK_DGRAM socket:
+ * each chunk is then a single datagram, received by a single call,
+ * never merged with the next one nor split between two calls.
+ * The bytes that don't fit in the buffer of the caller are discarded,
+ * MSG_TRUNC is set in msg_flags by recvmsg, and the flag MSG_TRUNC makes
+ * the call return the real length of the datagram. The address of the
+ * chunk is returned by recvfrom and recvmsg as the source address.
+ * When all the datagrams have been received, the calls fail with EAGAIN,
+ * as if a receive timeout had expired.
+ */
+#define READ_WRITE_DATAGRAM 0x10
+
+/**
+ * Flag set by create_mapped_read_buffer: the chunks are computed from a
+ * mapped file, instead of being taken from the chunks table.
+ */
+#define READ_WRITE_MAPPED 0x20
+
+/**
+ * Flag set by create_generated_read_buffer: the chunks are produced
+ * one at a time by a generator (see read_generator_t).
+ */
+#define READ_WRITE_GENERATED 0x40
+
+#define READ_WRITE_INTERVAL_MODE(mode) ((mode) & ~(READ_WRITE_DATAGRAM | READ_WRITE_MAPPED | READ_WRITE_GENERATED))
+
 /**
  * Structure representing a group of fragments of data, as it would be received
  * by subsequent read/recv of fragmented data. When simulating a partial-return
  * read/recv, this is the full data to be read, split into different chunks.
  */
+/**
+ * Generator of the chunks of a buffer created by create_generated_read_buffer.
+ * It is called with the number of the chunk, from 0, when the code tested
+ * needs it, i.e. only once the previous chunk has been completely read:
+ * the generator is never ahead of the reader, whatever the length
+ * of the stream, and can slow it down with the interval of the chunks.
+ * It fills *chunk (with buflen > 0) and returns 1, or returns 0 at the end
+ * of the stream. The data of chunk must stay valid until the next call,
+ * so that a generator can always reuse the same memory.
+ */
+typedef int (*read_generator_t)(void *arg, size_t chunk_id, struct read_bufchunk_t *chunk);
+
 struct read_buffer_t {
     int mode; // The mode of interpretation of interval
     size_t nchunks; // Number of chunks
     struct read_bufchunk_t *chunks; // Table of chunks
+    struct read_mapping_t *mapping; // With READ_WRITE_MAPPED, source of the chunks
+    read_generator_t generate; // With READ_WRITE_GENERATED, source of the chunks
+    void *generator_arg; // First argument of generate
+};
+
+/**
+ * Rules splitting a file into chunks, for create_mapped_read_buffer.
+ */
+#define READ_SPLIT_FIXED 1 // All the chunks have min_size bytes
+#define READ_SPLIT_RANDOM 2 // Sizes drawn uniformly in [min_size, max_size], from seed
+#define READ_SPLIT_SIZES 3 // Sizes listed in the file sizes_path
+
+/**
+ * Compact description of the fragmentation of a file, instead of one
+ * read_bufchunk_t per chunk. The sizes of the file sizes_path are written
+ * in decimal, separated by spaces or newlines (zero sizes are skipped);
+ * the data left after the last size forms a last chunk. The last chunk is shorter if the file ends.
+ * All the chunks have the same interval.
+ */
+struct read_split_t {
+    int rule; // One of the READ_SPLIT_ constants
+    size_t min_size; // At least 1
+    size_t max_size;
+    uint64_t seed;
+    const char *sizes_path;
+    int interval;
 };
 
+/**
+ * State of the buffered reads of a file descriptor, kept in its entry
+ * of the descriptor registry (see fd_table.h).
+ *
+ * Precision for the 'interval' field.
+ * It contains the wait time for the current chunk, as measured from the previous call.
+ * It may be positive: in this case, it means the next data was not available
+ * at the end of the previous call, and it is the time the current call has
+ * to wait before accessing data. Minus the interval between the two calls.
+ * It may be negative: in this case, it represents the opposite of the amout
+ * of time the current chunk has been available.
+ * Thanks to this field, we can enable the chunks at more or less the right moment.
+ */
+struct read_item {
+    int fd; // the file descriptor this structure applies to
+    //int mode; // the type of data provider used; not used
+    const struct read_buffer_t *buf; // Provided read_buffer_t structure
+    unsigned int chunk_id; // Current chunk, or next chunk to be received
+    size_t bytes_read; // Number of bytes read inside the current chunk
+    struct timespec last_time; // Time of the end of the last call of read on this fd/socket
+    int64_t interval; // In real-time mode (READ_WRITE_REAL_INTERVAL), real wait interval for the current chunk (in nanoseconds).
+    bool ready; // In the other modes, the current chunk has already been waited for
+    size_t consumed; // Number of bytes of the chunks before the current one
+    // With READ_WRITE_MAPPED or READ_WRITE_GENERATED
+    struct read_bufchunk_t chunk; // Current chunk
+    bool pending; // chunk must be computed before being read
+    size_t sizes_pos; // Position of the next size in the file of the sizes
+    struct rng_t rng; // Generator of the random sizes
+};
+
+
 /**
  * Sets the data to be retrieved from read/recv, for partial-return,
  * when simulating fragmented arrival of data.
@@ -156,7 +264,7 @@ struct read_buffer_t {
  * Returns
  * -  0 if fd was not previously set to have a read_buffer_t
  * -  1 if fd has been previously set to have a read_buffer_t
- * - -1 if malloc error
+ * - -1 if fd cannot be buffered (negative, or not below FD_TABLE_SIZE)
  * - -2 if argument error (typically buf->mode)
  */
 int set_read_buffer(int fd, const struct read_buffer_t *buf);
@@ -200,6 +308,88 @@ struct read_buffer_t *create_read_buffer(void *data, size_t n, off_t *offsets, i
  */
 void free_partial_read_buffer(struct read_buffer_t *buf);
 
+/**
+ * Creates a read buffer serving the contents of the file path, split
+ * into chunks by split. The file is mapped read-only, so that even a
+ * file of several gigabytes takes no memory beyond the page cache:
+ * the chunks point into the mapping, and are only copied into the buffer
+ * of the caller. The fixture files of the scratch directories
+ * (see scratch.h) can be mapped with their relative path.
+ * mode is one of the modes above, possibly with READ_WRITE_DATAGRAM.
+ * Returns NULL with errno set on failure (EINVAL if split is invalid).
+ * The buffer is freed, and the file unmapped, by free_read_buffer.
+ */
+struct read_buffer_t *create_mapped_read_buffer(const char *path, const struct read_split_t *split, int mode);
+
+/**
+ * Creates a read buffer whose chunks are produced on demand by generate,
+ * called with arg, for a stream of any length in constant memory.
+ * mode is one of the modes above, possibly with READ_WRITE_DATAGRAM.
+ * A read with MSG_PEEK doesn't go past the end of the current chunk.
+ * Returns NULL with errno set on failure. Freed by free_read_buffer.
+ */
+struct read_buffer_t *create_generated_read_buffer(read_generator_t generate, void *arg, int mode);
+
+/**
+ * Fragmentation schedules, to test the code reading data with many
+ * different splits into chunks instead of a few written by hand.
+ * A schedule is drawn from its seed, so that it can be reproduced.
+ */
+#define READ_SCHEDULE_UNIFORM 1 // Sizes drawn uniformly in [min_size, max_size]
+#define READ_SCHEDULE_GEOMETRIC 2 // Each byte ends its chunk with probability 1/mean_size
+#define READ_SCHEDULE_BYTES 3 // One byte per chunk
+#define READ_SCHEDULE_DELIMITER 4 // Cuts just before, inside or after each delimiter, each with probability 1/2
+
+struct read_schedule_t {
+    int kind; // One of the READ_SCHEDULE_ constants
+    uint64_t seed;
+    size_t min_size; // READ_SCHEDULE_UNIFORM, at least 1
+    size_t max_size; // READ_SCHEDULE_UNIFORM
+    size_t mean_size; // READ_SCHEDULE_GEOMETRIC, at least 1
+    const char *delimiter; // READ_SCHEDULE_DELIMITER, for example "\r\n"
+    int max_interval; // The intervals are drawn uniformly in [0, max_interval]
+};
+
+/**
+ * Splits the len bytes of data following schedule, in arrays of sizes and
+ * intervals allocated in *offsets and *intervals, to be passed to
+ * create_read_buffer and freed by the caller.
+ * Returns the number of chunks, or -1 with errno set (EINVAL if schedule is invalid).
+ */
+ssize_t read_schedule(const void *data, size_t len, const struct read_schedule_t *schedule, off_t **offsets, int **intervals);
+
+/**
+ * Creates a read buffer of the len bytes of data, split following schedule.
+ * Returns NULL with errno set on failure. Freed by free_read_buffer.
+ */
+struct read_buffer_t *create_scheduled_read_buffer(void *data, size_t len, const struct read_schedule_t *schedule, int mode);
+
+/**
+ * Checks the code tested with one schedule, typically by creating a
+ * buffer with create_scheduled_read_buffer and running the code in a sandbox.
+ * Returns 0 if the code behaved correctly, another value otherwise.
+ */
+typedef int (*read_schedule_check_t)(const struct read_schedule_t *schedule, void *arg);
+
+/**
+ * Maximum duration of a check run by read_schedule_search, in seconds:
+ * a check still running is killed, and counted as failed.
+ */
+#define READ_SCHEDULE_TIMEOUT 10
+
+/**
+ * Runs check(s, arg) for k schedules s, equal to schedule but with the seeds
+ * schedule->seed to schedule->seed + k - 1. Each check runs in its own
+ * forked child, as many at a time as there are processors, so that
+ * a crash or a corrupted state doesn't affect the others nor the test;
+ * the assertions of the checks are thus lost, only their result counts.
+ * If at least one check fails, the minimal failing schedule, i.e. the one
+ * with the fewest chunks (then with the lowest seed), is stored in *failing.
+ * Returns the number of failed checks, or -1 with errno set on error.
+ */
+int read_schedule_search(const void *data, size_t len, const struct read_schedule_t *schedule, int k,
+        read_schedule_check_t check, void *arg, struct read_schedule_t *failing);
+
 /**
  * Deallocates the provided read buffer. This doesn't free the actual data
  * returned by successive calls of recv and read. Also frees buf itself,
@@ -213,6 +403,126 @@ void free_read_buffer(struct read_buffer_t *buf);
  */
 void reinit_read_fd_table();
 
+/**
+ * Returns the number of fd's currently associated with a read_buffer_t.
+ */
+size_t read_fd_count();
+
+/**
+ * Returns the read state of fd, or NULL if fd has no read_buffer_t.
+ */
+struct read_item *read_get_entry(int fd);
+
+/**
+ * Reads from the read_buffer_t of fd into the iovcnt buffers of iov,
+ * as recv or recvmsg would; used by the wrappers of read, readv, recv,
+ * recvfrom and recvmsg. The flags MSG_DONTWAIT, MSG_PEEK and MSG_WAITALL
+ * are supported; MSG_OOB fails with EINVAL, as there is no urgent data.
+ * Returns the number of bytes read, or -1 with errno set.
+ */
+ssize_t read_handle_buffer_iov(int fd, const struct iovec *iov, int iovcnt, int flags);
+
+/**
+ * Same as read_handle_buffer_iov, for recvmsg: reads into msg->msg_iov,
+ * and sets msg_name, msg_namelen and msg_flags as recvmsg does.
+ */
+ssize_t read_handle_buffer_msg(int fd, struct msghdr *msg, int flags);
+
+
+
+/**
+ * write-related
+ */
+
+/**
+ * Structure describing how the data written to a fd with write, send,
+ * sendto or sendmsg is accepted, when simulating a peer that reads it
+ * slowly. It is the counterpart of read_buffer_t: nothing reaches the
+ * real fd, the accepted data is copied in capture instead.
+ * Fields:
+ * - capacity: number of bytes the fd can hold before it is full;
+ *   0 for no limit. A call on a full fd waits until some room is available,
+ *   or fails with EAGAIN if the fd is non-blocking (O_NONBLOCK) or if
+ *   MSG_DONTWAIT is set. Otherwise, it accepts as many bytes as it can,
+ *   and returns this smaller count.
+ * - drain_rate: number of bytes removed from the fd per second,
+ *   as if the peer read them. 0 means that they are removed immediately,
+ *   so that capacity is never reached.
+ * - chunks: chunks[i] is the maximum number of bytes accepted by the i-th
+ *   call (counted from set_write_buffer), for an arbitrary partial return.
+ *   There is no such limit after the nchunks first calls.
+ * - eintr_every: if n is not 0, every n-th call fails with EINTR
+ *   without accepting anything.
+ * - capture: buffer of capture_len bytes, receiving the accepted data;
+ *   the data accepted beyond capture_len is counted, but not copied.
+ *   capture may be NULL if capture_len is 0.
+ */
+struct write_buffer_t {
+    size_t capacity;
+    size_t drain_rate;
+    size_t nchunks;
+    const size_t *chunks;
+    unsigned int eintr_every;
+    void *capture;
+    size_t capture_len;
+};
+
+/**
+ * State of the buffered writes of a file descriptor, kept in its entry
+ * of the descriptor registry (see fd_table.h).
+ */
+struct write_item {
+    const struct write_buffer_t *buf; // Provided write_buffer_t structure
+    unsigned int call_id; // Number of calls since set_write_buffer
+    size_t bytes_written; // Number of bytes accepted since set_write_buffer
+    size_t queued; // Number of accepted bytes not drained yet
+    struct timespec last_time; // Time at which queued was computed
+};
+
+/**
+ * Sets how the data written to fd is accepted, for partial-return and
+ * backpressure; buf must stay valid until it is unset.
+ * A NULL buf removes the association.
+ * Returns
+ * -  0 if fd was not previously set to have a write_buffer_t
+ * -  1 if fd has been previously set to have a write_buffer_t
+ * - -1 if fd cannot be buffered (negative, or not below FD_TABLE_SIZE)
+ */
+int set_write_buffer(int fd, const struct write_buffer_t *buf);
+
+bool fd_is_write_buffered(int fd);
+
+/**
+ * Returns the number of bytes accepted on fd since its write_buffer_t was
+ * set, or -1 if there is none. The first bytes are in buf->capture.
+ */
+ssize_t get_bytes_written(int fd);
+
+/**
+ * Accepts the data of the iovcnt buffers of iov on fd, as described by its
+ * write_buffer_t; used by the wrappers of write, writev, send, sendto
+ * and sendmsg.
+ * Returns the number of bytes accepted, or -1 with errno set.
+ */
+ssize_t write_handle_buffer(int fd, const struct iovec *iov, int iovcnt, int flags);
+
+/**
+ * The two halves of write_handle_buffer, for sendfile and splice, which
+ * must not read more than the output accepts: write_reserve_buffer
+ * counts a call of len bytes on fd and returns the number of bytes it
+ * accepts (waiting for room if needed), or -1 with errno set;
+ * write_commit_buffer then accepts the len first bytes of iov, len being
+ * at most the reserved count.
+ */
+ssize_t write_reserve_buffer(int fd, size_t len, int flags);
+void write_commit_buffer(int fd, const struct iovec *iov, int iovcnt, size_t len);
+
+/**
+ * Removes all the association between fd's and write_buffer_t's that have
+ * been previously set. It doesn't free the structures, however.
+ */
+void reinit_write_fd_table();
+
 
 #endif // __CTESTER_READ_WRITE_H__
 
@@ -0,0 +1,267 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <ftw.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+
+#include "scratch.h"
+
+#define SCRATCH_PATH_MAX 256
+
+static char root[SCRATCH_PATH_MAX]; // Private directory, empty string if disabled
+static char fixture[SCRATCH_PATH_MAX + 16]; // Directory of the fixture files, in root
+static char current[SCRATCH_PATH_MAX + 16]; // Scratch directory of the current test
+static int original_cwd = -1; // Working directory before the current test
+static unsigned int tests = 0;
+static bool registered = false;
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw)
+{
+    (void)sb;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+static void remove_tree(const char *path)
+{
+    nftw(path, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static void scratch_cleanup(void)
+{
+    scratch_end();
+    if (root[0] != '\0') {
+        remove_tree(root);
+        root[0] = '\0';
+    }
+}
+
+int set_scratch_dir(bool enabled)
+{
+    if (!enabled) {
+        scratch_cleanup();
+        return 0;
+    }
+    if (root[0] != '\0') {
+        return 0;
+    }
+    struct stat st;
+    const char *base = (stat(SCRATCH_ROOT, &st) == 0 && S_ISDIR(st.st_mode)
+            && access(SCRATCH_ROOT, W_OK) == 0) ? SCRATCH_ROOT : SCRATCH_ROOT_FALLBACK;
+    snprintf(root, sizeof(root), "%s/ctester-XXXXXX", base);
+    if (mkdtemp(root) == NULL) {
+        root[0] = '\0';
+        return -1;
+    }
+    snprintf(fixture, sizeof(fixture), "%s/fixture", root);
+    if (mkdir(fixture, 0700) < 0) {
+        int err = errno;
+        remove_tree(root);
+        root[0] = '\0';
+        errno = err;
+        return -1;
+    }
+    if (!registered) {
+        atexit(scratch_cleanup);
+        registered = true;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int scratch_fixture(const char *name, const void *data, size_t len, mode_t mode)
+{
+    if (root[0] == '\0') {
+        errno = EINVAL;
+        return -1;
+    }
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", fixture, name) >= (int)sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    unlink(path);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    if (write_all(fd, data, len) < 0 || fchmod(fd, mode & 07777) < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return close(fd);
+}
+
+/*
+ * Copies the contents of the file src_fd into dst_fd: as a copy-on-write
+ * clone if the file system supports it, with plain reads and writes otherwise.
+ */
+static int copy_fd(int src_fd, int dst_fd)
+{
+    if (ioctl(dst_fd, FICLONE, src_fd) == 0) {
+        return 0;
+    }
+    char buf[BUFSIZ];
+    ssize_t n;
+    while ((n = read(src_fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (write_all(dst_fd, buf, n) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int copy_file(const char *src, const char *dst, mode_t mode)
+{
+    int src_fd = open(src, O_RDONLY, 0);
+    if (src_fd < 0) {
+        return -1;
+    }
+    int dst_fd = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (dst_fd < 0) {
+        int err = errno;
+        close(src_fd);
+        errno = err;
+        return -1;
+    }
+    int ret = copy_fd(src_fd, dst_fd);
+    if (ret == 0) {
+        ret = fchmod(dst_fd, mode & 07777);
+    }
+    int err = errno;
+    close(src_fd);
+    close(dst_fd);
+    errno = err;
+    return ret;
+}
+
+int scratch_fixture_copy(const char *path)
+{
+    if (root[0] == '\0') {
+        errno = EINVAL;
+        return -1;
+    }
+    struct stat st;
+    if (stat(path, &st) < 0) {
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        errno = EINVAL;
+        return -1;
+    }
+    const char *name = strrchr(path, '/');
+    name = (name == NULL ? path : name + 1);
+    char dst[PATH_MAX];
+    if (snprintf(dst, sizeof(dst), "%s/%s", fixture, name) >= (int)sizeof(dst)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    unlink(dst);
+    return copy_file(path, dst, st.st_mode);
+}
+
+const char *scratch_path(void)
+{
+    return (current[0] != '\0' ? current : NULL);
+}
+
+/*
+ * Puts the fixture files in the directory dir.
+ */
+static int populate(const char *dir)
+{
+    DIR *d = opendir(fixture);
+    if (d == NULL) {
+        return -1;
+    }
+    int ret = 0;
+    struct dirent *e;
+    while (ret == 0 && (e = readdir(d)) != NULL) {
+        if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) {
+            continue;
+        }
+        char src[PATH_MAX], dst[PATH_MAX];
+        snprintf(src, sizeof(src), "%s/%s", fixture, e->d_name);
+        snprintf(dst, sizeof(dst), "%s/%s", dir, e->d_name);
+        struct stat st;
+        if (stat(src, &st) < 0) {
+            ret = -1;
+        } else if (!(st.st_mode & S_IWUSR) && link(src, dst) == 0) {
+            // A read-only file can be shared by all the tests
+        } else {
+            ret = copy_file(src, dst, st.st_mode);
+        }
+    }
+    closedir(d);
+    return ret;
+}
+
+void scratch_begin(void)
+{
+    scratch_end();
+    if (root[0] == '\0') {
+        return;
+    }
+    snprintf(current, sizeof(current), "%s/test-%u", root, ++tests);
+    if (mkdir(current, 0700) < 0 || populate(current) < 0
+            || (original_cwd = open(".", O_RDONLY | O_DIRECTORY, 0)) < 0) {
+        fprintf(stderr, "Error when preparing the scratch directory: %s\n", strerror(errno));
+        remove_tree(current);
+        current[0] = '\0';
+        return;
+    }
+    if (chdir(current) < 0) {
+        fprintf(stderr, "Error when moving to the scratch directory: %s\n", strerror(errno));
+        close(original_cwd);
+        original_cwd = -1;
+        remove_tree(current);
+        current[0] = '\0';
+    }
+}
+
+void scratch_end(void)
+{
+    if (original_cwd >= 0) {
+        if (fchdir(original_cwd) < 0) {
+            fprintf(stderr, "Error when leaving the scratch directory: %s\n", strerror(errno));
+        }
+        close(original_cwd);
+        original_cwd = -1;
+    }
+    if (current[0] != '\0') {
+        remove_tree(current);
+        current[0] = '\0';
+    }
+}
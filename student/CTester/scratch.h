@@ -0,0 +1,65 @@
+#ifndef __CTESTER_SCRATCH_H__
+#define __CTESTER_SCRATCH_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/**
+ * Private scratch directories: when they are enabled, each test runs
+ * in a new empty directory, its working directory from start_test to
+ * the end of the test, which is then removed with all its contents.
+ * Tests running at the same time, or one after the other, thus never see
+ * the files of each other, even with the same relative paths.
+ *
+ * The directories are created in a private directory in /dev/shm,
+ * so that their files stay in RAM, or in /tmp if /dev/shm is not available.
+ * This private directory is removed when set_scratch_dir(false) is called,
+ * or when the program exits.
+ */
+#define SCRATCH_ROOT "/dev/shm"
+#define SCRATCH_ROOT_FALLBACK "/tmp"
+
+/**
+ * Enables or disables the scratch directories, for the following tests.
+ * Returns 0 on success, -1 with errno set if the private directory
+ * couldn't be created.
+ */
+int set_scratch_dir(bool enabled);
+
+/**
+ * Adds a fixture file: a copy of it is put in the scratch directory of each
+ * following test. It is named name, contains the len bytes of data, and
+ * has the permissions mode. A read-only fixture (without S_IWUSR) is
+ * hard-linked into the scratch directories instead of being copied.
+ * Returns 0 on success, -1 with errno set on failure (or if the scratch
+ * directories are not enabled).
+ */
+int scratch_fixture(const char *name, const void *data, size_t len, mode_t mode);
+
+/**
+ * Adds a copy of the existing file path as a fixture file, named after
+ * the last component of path. Returns 0 on success, -1 with errno set.
+ */
+int scratch_fixture_copy(const char *path);
+
+/**
+ * Returns the absolute path of the scratch directory of the current test,
+ * or NULL if there is none.
+ */
+const char *scratch_path(void);
+
+/**
+ * Creates the scratch directory of a test, fills it with the fixture
+ * and moves into it. Called by start_test; does nothing if the scratch
+ * directories are not enabled.
+ */
+void scratch_begin(void);
+
+/**
+ * Moves back to the original working directory and removes the scratch
+ * directory of the test. Called at the end of each test.
+ */
+void scratch_end(void);
+
+#endif // __CTESTER_SCRATCH_H__
@@ -0,0 +1,949 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "simnet.h"
+#include "fd_table.h"
+
+int __real_open(const char *pathname, int flags, mode_t mode);
+int __real_close(int fd);
+int __real_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+int __real_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+/**
+ * A scripted peer. Its position in its transactions is trans, chunk and off
+ * (the bytes of the current chunk already exchanged).
+ */
+struct simnet_peer_t {
+    bool used;
+    bool client; // Connects to the code tested, instead of being connected to
+    int type; // SOCK_STREAM or SOCK_DGRAM
+    struct sockaddr_storage addr; // Address of a server, or address a client connects to
+    socklen_t addrlen;
+    struct sockaddr_storage src; // Address of the peer seen by the code tested
+    socklen_t srclen;
+    const struct cs_network_transactions *transactions;
+    size_t trans;
+    size_t chunk;
+    size_t off;
+    int conn; // Socket connected to the peer for the current transaction, or -1
+    struct simnet_report_t report;
+};
+
+#define SIMNET_OPTIONS_MAX 8 // Options set with setsockopt kept by a socket
+
+/**
+ * An option set with setsockopt, as an int.
+ */
+struct simnet_option_t {
+    int level;
+    int name; // 0 if the slot is empty
+    int value;
+};
+
+#define SIMNET_CREATED 1
+#define SIMNET_LISTENING 2
+#define SIMNET_CONNECTED 3
+
+struct simnet_socket_t {
+    bool used; // The descriptor is a socket of the network
+    int domain;
+    int type; // SOCK_STREAM or SOCK_DGRAM
+    int state; // One of the SIMNET_ constants above
+    bool bound;
+    struct sockaddr_storage local;
+    socklen_t locallen;
+    int peer; // Connected peer, or peer of the last datagram, or -1
+    struct sockaddr_storage remote; // Address the socket is connected to
+    socklen_t remotelen;
+    bool wr_closed; // Shut down for writing: the peer got the end of the stream
+    struct simnet_option_t options[SIMNET_OPTIONS_MAX];
+};
+
+static bool simnet_on = false;
+static struct simnet_peer_t peers[SIMNET_PEERS_MAX];
+static struct simnet_socket_t sockets[SIMNET_FD_MAX];
+
+void set_simnet(bool enabled)
+{
+    simnet_on = enabled;
+}
+
+bool simnet_enabled(void)
+{
+    return simnet_on;
+}
+
+bool simnet_owns(int fd)
+{
+    return fd >= 0 && fd < SIMNET_FD_MAX && sockets[fd].used;
+}
+
+/*
+ * Returns the socket fd, or NULL with errno set if it isn't one of the network.
+ */
+static struct simnet_socket_t *simnet_get(int fd)
+{
+    if (!simnet_owns(fd)) {
+        errno = EBADF;
+        return NULL;
+    }
+    return &sockets[fd];
+}
+
+/*
+ * Returns true if a and b are the same address, the wildcard address
+ * of one of them matching any address of the other.
+ */
+static bool addr_match(const struct sockaddr_storage *a, const struct sockaddr_storage *b)
+{
+    if (a->ss_family != b->ss_family) {
+        return false;
+    }
+    if (a->ss_family == AF_INET) {
+        const struct sockaddr_in *a4 = (const struct sockaddr_in *)a, *b4 = (const struct sockaddr_in *)b;
+        return a4->sin_port == b4->sin_port
+            && (a4->sin_addr.s_addr == b4->sin_addr.s_addr
+                || a4->sin_addr.s_addr == htonl(INADDR_ANY) || b4->sin_addr.s_addr == htonl(INADDR_ANY));
+    }
+    const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *)a, *b6 = (const struct sockaddr_in6 *)b;
+    return a6->sin6_port == b6->sin6_port
+        && (IN6_ARE_ADDR_EQUAL(&a6->sin6_addr, &b6->sin6_addr)
+            || IN6_IS_ADDR_UNSPECIFIED(&a6->sin6_addr) || IN6_IS_ADDR_UNSPECIFIED(&b6->sin6_addr));
+}
+
+/*
+ * Copies the address addr, of the domain of the network, in *ss.
+ * Returns 0, or -1 with errno set if it isn't valid.
+ */
+static int addr_copy(struct sockaddr_storage *ss, socklen_t *sslen, const struct sockaddr *addr, socklen_t addrlen)
+{
+    if (addr == NULL
+            || !((addr->sa_family == AF_INET && addrlen >= sizeof(struct sockaddr_in))
+                || (addr->sa_family == AF_INET6 && addrlen >= sizeof(struct sockaddr_in6)))) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(ss, 0, sizeof(*ss));
+    *sslen = (addr->sa_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6));
+    memcpy(ss, addr, *sslen);
+    return 0;
+}
+
+/*
+ * Returns the address src in addr, truncated to *addrlen, as the real calls.
+ */
+static void addr_return(struct sockaddr *addr, socklen_t *addrlen, const struct sockaddr_storage *src, socklen_t srclen)
+{
+    if (addr != NULL && addrlen != NULL) {
+        memcpy(addr, src, MIN(*addrlen, srclen));
+        *addrlen = srclen;
+    }
+}
+
+/**
+ * The peers
+ */
+
+static int peer_add(bool client, const struct sockaddr *addr, socklen_t addrlen, int type, const struct cs_network_transactions *transactions)
+{
+    if ((type != SOCK_STREAM && type != SOCK_DGRAM) || transactions == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int i = 0; i < SIMNET_PEERS_MAX; i++) {
+        struct simnet_peer_t *p = &peers[i];
+        if (p->used) {
+            continue;
+        }
+        memset(p, 0, sizeof(*p));
+        if (addr_copy(&(p->addr), &(p->addrlen), addr, addrlen) < 0) {
+            return -1;
+        }
+        p->used = true;
+        p->client = client;
+        p->type = type;
+        p->transactions = transactions;
+        p->conn = -1;
+        p->report.status = OK;
+        if (!client) {
+            memcpy(&(p->src), &(p->addr), sizeof(p->src));
+            p->srclen = p->addrlen;
+        } else if (addr->sa_family == AF_INET) {
+            struct sockaddr_in *src = (struct sockaddr_in *)&(p->src);
+            src->sin_family = AF_INET;
+            src->sin_port = htons(SIMNET_PORT_BASE + i);
+            src->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            p->srclen = sizeof(*src);
+        } else {
+            struct sockaddr_in6 *src = (struct sockaddr_in6 *)&(p->src);
+            src->sin6_family = AF_INET6;
+            src->sin6_port = htons(SIMNET_PORT_BASE + i);
+            src->sin6_addr = in6addr_loopback;
+            p->srclen = sizeof(*src);
+        }
+        return i;
+    }
+    errno = ENOMEM;
+    return -1;
+}
+
+int simnet_add_server(const struct sockaddr *addr, socklen_t addrlen, int type, const struct cs_network_transactions *transactions)
+{
+    return peer_add(false, addr, addrlen, type, transactions);
+}
+
+int simnet_add_client(const struct sockaddr *addr, socklen_t addrlen, int type, const struct cs_network_transactions *transactions)
+{
+    return peer_add(true, addr, addrlen, type, transactions);
+}
+
+const struct simnet_report_t *simnet_report(int peer)
+{
+    if (peer < 0 || peer >= SIMNET_PEERS_MAX || !peers[peer].used) {
+        return NULL;
+    }
+    return &(peers[peer].report);
+}
+
+/*
+ * Returns the current chunk of p, or NULL at the end of its transaction
+ * (or after its last transaction).
+ */
+static const struct cs_network_chunk *peer_chunk(const struct simnet_peer_t *p)
+{
+    if (p->trans >= p->transactions->ntransactions) {
+        return NULL;
+    }
+    const struct cs_network_transaction *t = &(p->transactions->transactions[p->trans]);
+    return (p->chunk < t->nchunks ? &(t->chunks[p->chunk]) : NULL);
+}
+
+/*
+ * Records the problem status at the current chunk of p, if it's the first one.
+ */
+static void peer_fail(struct simnet_peer_t *p, int status)
+{
+    if (p->report.status == OK) {
+        p->report = (struct simnet_report_t) {
+            .status = status,
+            .transaction = p->trans,
+            .chunk = p->chunk,
+            .done = p->report.done
+        };
+    }
+}
+
+static void peer_next_transaction(struct simnet_peer_t *p)
+{
+    p->trans++;
+    p->chunk = 0;
+    p->off = 0;
+    p->report.done++;
+}
+
+static void peer_next_chunk(struct simnet_peer_t *p)
+{
+    p->chunk++;
+    p->off = 0;
+    if (p->type == SOCK_DGRAM && peer_chunk(p) == NULL) {
+        // The datagrams of the next transaction follow
+        peer_next_transaction(p);
+    }
+}
+
+/*
+ * The code tested closed its side of the stream: the chunks that p
+ * expects to receive, up to the next one it sends, will never arrive.
+ */
+static void peer_eof(struct simnet_peer_t *p)
+{
+    const struct cs_network_chunk *c;
+    while ((c = peer_chunk(p)) != NULL && c->type == RECV_CHUNK) {
+        peer_fail(p, p->off == 0 ? NOTHING_RECV : TOO_FEW);
+        peer_next_chunk(p);
+    }
+}
+
+/*
+ * The connection of p was closed by the code tested: ends its transaction.
+ */
+static void peer_disconnect(struct simnet_peer_t *p)
+{
+    const struct cs_network_chunk *c;
+    while ((c = peer_chunk(p)) != NULL) {
+        if (c->type == RECV_CHUNK) {
+            peer_fail(p, p->off == 0 ? NOTHING_RECV : TOO_FEW);
+        }
+        peer_next_chunk(p);
+    }
+    if (p->trans < p->transactions->ntransactions) {
+        peer_next_transaction(p);
+    }
+    p->conn = -1;
+}
+
+/*
+ * Returns true if p is a client connecting to the listening socket s.
+ */
+static bool peer_connecting(const struct simnet_peer_t *p, const struct simnet_socket_t *s)
+{
+    return p->used && p->client && p->type == SOCK_STREAM && p->conn < 0
+        && p->trans < p->transactions->ntransactions && addr_match(&(p->addr), &(s->local));
+}
+
+/*
+ * Returns the peer sending the next datagram to s, or -1 if none does.
+ */
+static int peer_sending(const struct simnet_socket_t *s)
+{
+    for (int i = -1; i < SIMNET_PEERS_MAX; i++) {
+        // The connected peer first, then the clients of the bound address
+        int id = (i < 0 ? s->peer : i);
+        if (id < 0 || (i >= 0 && !(peers[i].client && s->bound && addr_match(&(peers[i].addr), &(s->local))))) {
+            continue;
+        }
+        const struct simnet_peer_t *p = &peers[id];
+        const struct cs_network_chunk *c = (p->used && p->type == SOCK_DGRAM ? peer_chunk(p) : NULL);
+        if (c != NULL && c->type == SEND_CHUNK) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Returns the peer of type SOCK_DGRAM at the address dest, or -1.
+ */
+static int peer_at(const struct sockaddr_storage *dest)
+{
+    for (int i = 0; i < SIMNET_PEERS_MAX; i++) {
+        if (peers[i].used && peers[i].type == SOCK_DGRAM && addr_match(&(peers[i].src), dest)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Scatter and gather
+ */
+
+static size_t iov_length(const struct iovec *iov, size_t iovcnt)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+/*
+ * Copies the n bytes of src at the offset off of the buffers of iov.
+ */
+static void iov_scatter(const struct iovec *iov, size_t iovcnt, size_t off, const char *src, size_t n)
+{
+    for (size_t i = 0; i < iovcnt && n > 0; i++) {
+        if (off >= iov[i].iov_len) {
+            off -= iov[i].iov_len;
+            continue;
+        }
+        size_t k = MIN(n, iov[i].iov_len - off);
+        memcpy((char *)iov[i].iov_base + off, src, k);
+        src += k;
+        n -= k;
+        off = 0;
+    }
+}
+
+/*
+ * Returns true if the n bytes at the offset off of the buffers of iov equal data.
+ */
+static bool iov_equal(const struct iovec *iov, size_t iovcnt, size_t off, const char *data, size_t n)
+{
+    for (size_t i = 0; i < iovcnt && n > 0; i++) {
+        if (off >= iov[i].iov_len) {
+            off -= iov[i].iov_len;
+            continue;
+        }
+        size_t k = MIN(n, iov[i].iov_len - off);
+        if (memcmp((const char *)iov[i].iov_base + off, data, k) != 0) {
+            return false;
+        }
+        data += k;
+        n -= k;
+        off = 0;
+    }
+    return true;
+}
+
+/**
+ * The system calls
+ */
+
+void simnet_reset(void)
+{
+    for (int fd = 0; fd < SIMNET_FD_MAX; fd++) {
+        if (sockets[fd].used) {
+            simnet_close(fd);
+            fd_closed(fd);
+        }
+    }
+    memset(peers, 0, sizeof(peers));
+}
+
+int simnet_socket(int domain, int type, int protocol)
+{
+    (void)protocol;
+    int base = type & ~(SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if ((domain != AF_INET && domain != AF_INET6) || (base != SOCK_STREAM && base != SOCK_DGRAM)) {
+        errno = EPROTONOSUPPORT;
+        return -1;
+    }
+    int flags = O_RDWR | ((type & SOCK_NONBLOCK) ? O_NONBLOCK : 0) | ((type & SOCK_CLOEXEC) ? O_CLOEXEC : 0);
+    int fd = __real_open("/dev/null", flags, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fd >= SIMNET_FD_MAX) {
+        __real_close(fd);
+        errno = EMFILE;
+        return -1;
+    }
+    sockets[fd] = (struct simnet_socket_t) {
+        .used = true,
+        .domain = domain,
+        .type = base,
+        .state = SIMNET_CREATED,
+        .bound = false,
+        .peer = -1,
+        .wr_closed = false
+    };
+    return fd;
+}
+
+int simnet_bind(int fd, const struct sockaddr *addr, socklen_t addrlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (s->bound || addr == NULL || addr->sa_family != s->domain) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (addr_copy(&(s->local), &(s->locallen), addr, addrlen) < 0) {
+        return -1;
+    }
+    for (int i = 0; i < SIMNET_FD_MAX; i++) {
+        if (i != fd && sockets[i].used && sockets[i].bound && sockets[i].type == s->type
+                && addr_match(&(sockets[i].local), &(s->local))) {
+            errno = EADDRINUSE;
+            return -1;
+        }
+    }
+    s->bound = true;
+    return 0;
+}
+
+int simnet_connect(int fd, const struct sockaddr *addr, socklen_t addrlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    struct sockaddr_storage dest;
+    socklen_t destlen;
+    if (addr_copy(&dest, &destlen, addr, addrlen) < 0) {
+        return -1;
+    }
+    if (s->type == SOCK_DGRAM) {
+        // Only sets the default destination
+        s->peer = peer_at(&dest);
+        s->state = SIMNET_CONNECTED;
+        memcpy(&(s->remote), &dest, sizeof(dest));
+        s->remotelen = destlen;
+        return 0;
+    }
+    if (s->state == SIMNET_CONNECTED) {
+        errno = EISCONN;
+        return -1;
+    }
+    for (int i = 0; i < SIMNET_PEERS_MAX; i++) {
+        struct simnet_peer_t *p = &peers[i];
+        if (p->used && !p->client && p->type == SOCK_STREAM && p->conn < 0
+                && p->trans < p->transactions->ntransactions && addr_match(&(p->addr), &dest)) {
+            p->conn = fd;
+            s->peer = i;
+            s->state = SIMNET_CONNECTED;
+            memcpy(&(s->remote), &dest, sizeof(dest));
+            s->remotelen = destlen;
+            return 0;
+        }
+    }
+    errno = ECONNREFUSED;
+    return -1;
+}
+
+int simnet_listen(int fd, int backlog)
+{
+    (void)backlog;
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (s->type != SOCK_STREAM || s->state == SIMNET_CONNECTED) {
+        errno = (s->type != SOCK_STREAM ? EOPNOTSUPP : EINVAL);
+        return -1;
+    }
+    s->state = SIMNET_LISTENING;
+    return 0;
+}
+
+int simnet_accept(int fd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (s->state != SIMNET_LISTENING) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int i = 0; i < SIMNET_PEERS_MAX; i++) {
+        struct simnet_peer_t *p = &peers[i];
+        if (!peer_connecting(p, s)) {
+            continue;
+        }
+        int cfd = simnet_socket(s->domain, SOCK_STREAM, 0);
+        if (cfd < 0) {
+            return -1;
+        }
+        sockets[cfd].state = SIMNET_CONNECTED;
+        sockets[cfd].peer = i;
+        memcpy(&(sockets[cfd].local), &(s->local), sizeof(s->local));
+        sockets[cfd].locallen = s->locallen;
+        memcpy(&(sockets[cfd].remote), &(p->src), sizeof(p->src));
+        sockets[cfd].remotelen = p->srclen;
+        p->conn = cfd;
+        addr_return(addr, addrlen, &(p->src), p->srclen);
+        return cfd;
+    }
+    // No client will ever connect
+    errno = EAGAIN;
+    return -1;
+}
+
+ssize_t simnet_sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+    (void)flags;
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    size_t len = iov_length(msg->msg_iov, msg->msg_iovlen);
+    if (s->wr_closed) {
+        errno = EPIPE;
+        return -1;
+    }
+    if (s->type == SOCK_DGRAM) {
+        int id = s->peer;
+        if (msg->msg_name != NULL) {
+            struct sockaddr_storage dest;
+            socklen_t destlen;
+            if (addr_copy(&dest, &destlen, msg->msg_name, msg->msg_namelen) < 0) {
+                return -1;
+            }
+            id = s->peer = peer_at(&dest);
+        } else if (s->state != SIMNET_CONNECTED) {
+            errno = EDESTADDRREQ;
+            return -1;
+        }
+        if (id < 0) {
+            // Nobody listens: the datagram is lost
+            return len;
+        }
+        struct simnet_peer_t *p = &peers[id];
+        const struct cs_network_chunk *c = peer_chunk(p);
+        if (c == NULL || c->type != RECV_CHUNK) {
+            peer_fail(p, TOO_MUCH);
+            return len;
+        }
+        if (len != c->data_length) {
+            peer_fail(p, len < c->data_length ? TOO_FEW : TOO_MUCH);
+        } else if (!iov_equal(msg->msg_iov, msg->msg_iovlen, 0, c->data, len)) {
+            peer_fail(p, NOT_SAME_DATA);
+        }
+        peer_next_chunk(p);
+        return len;
+    }
+    if (s->state != SIMNET_CONNECTED) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    struct simnet_peer_t *p = &peers[s->peer];
+    // The peer receives everything at once, as into the buffer of a real socket
+    for (size_t done = 0; done < len; ) {
+        const struct cs_network_chunk *c = peer_chunk(p);
+        if (c == NULL || c->type != RECV_CHUNK) {
+            peer_fail(p, TOO_MUCH);
+            break;
+        }
+        size_t n = MIN(len - done, c->data_length - p->off);
+        if (!iov_equal(msg->msg_iov, msg->msg_iovlen, done, (const char *)c->data + p->off, n)) {
+            peer_fail(p, NOT_SAME_DATA);
+        }
+        done += n;
+        p->off += n;
+        if (p->off >= c->data_length) {
+            peer_next_chunk(p);
+        }
+    }
+    return len;
+}
+
+ssize_t simnet_recvmsg(int fd, struct msghdr *msg, int flags)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    size_t len = iov_length(msg->msg_iov, msg->msg_iovlen);
+    socklen_t namelen = msg->msg_namelen;
+    msg->msg_namelen = 0;
+    msg->msg_controllen = 0;
+    msg->msg_flags = 0;
+    if (s->type == SOCK_DGRAM) {
+        int id = peer_sending(s);
+        if (id < 0) {
+            // No datagram will ever arrive
+            errno = EAGAIN;
+            return -1;
+        }
+        struct simnet_peer_t *p = &peers[id];
+        const struct cs_network_chunk *c = peer_chunk(p);
+        iov_scatter(msg->msg_iov, msg->msg_iovlen, 0, c->data, MIN(len, c->data_length));
+        if (len < c->data_length) {
+            msg->msg_flags |= MSG_TRUNC;
+        }
+        msg->msg_namelen = namelen;
+        addr_return(msg->msg_name, &(msg->msg_namelen), &(p->src), p->srclen);
+        size_t n = ((flags & MSG_TRUNC) != 0 ? c->data_length : MIN(len, c->data_length));
+        if ((flags & MSG_PEEK) == 0) {
+            s->peer = id;
+            peer_next_chunk(p);
+        }
+        return n;
+    }
+    if (s->state != SIMNET_CONNECTED) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    struct simnet_peer_t *p = &peers[s->peer];
+    if (s->wr_closed) {
+        peer_eof(p);
+    }
+    const struct cs_network_chunk *c = peer_chunk(p);
+    if (c == NULL) {
+        // The peer closed the connection
+        return 0;
+    }
+    if (c->type == RECV_CHUNK) {
+        // The peer waits for data that can't come during this call
+        errno = EAGAIN;
+        return -1;
+    }
+    // Copies the consecutive chunks sent, without moving p for a peek
+    size_t chunk = p->chunk, off = p->off, done = 0;
+    const struct cs_network_transaction *t = &(p->transactions->transactions[p->trans]);
+    while (done < len && chunk < t->nchunks && t->chunks[chunk].type == SEND_CHUNK) {
+        size_t n = MIN(len - done, t->chunks[chunk].data_length - off);
+        iov_scatter(msg->msg_iov, msg->msg_iovlen, done, (const char *)t->chunks[chunk].data + off, n);
+        done += n;
+        off += n;
+        if (off >= t->chunks[chunk].data_length) {
+            chunk++;
+            off = 0;
+        }
+    }
+    if ((flags & MSG_PEEK) == 0) {
+        p->chunk = chunk;
+        p->off = off;
+    }
+    return done;
+}
+
+int simnet_shutdown(int fd, int how)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (s->type != SOCK_STREAM || s->state != SIMNET_CONNECTED) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    if (how == SHUT_WR || how == SHUT_RDWR) {
+        s->wr_closed = true;
+        peer_eof(&peers[s->peer]);
+    }
+    return 0;
+}
+
+int simnet_setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (optval == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (optlen < sizeof(int) || optname == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    // Only the first int of the structured options (SO_LINGER...) is kept
+    int value;
+    memcpy(&value, optval, sizeof(value));
+    struct simnet_option_t *free_slot = NULL;
+    for (int i = 0; i < SIMNET_OPTIONS_MAX; i++) {
+        struct simnet_option_t *o = &(s->options[i]);
+        if (o->name == optname && o->level == level) {
+            o->value = value;
+            return 0;
+        }
+        if (o->name == 0 && free_slot == NULL) {
+            free_slot = o;
+        }
+    }
+    if (free_slot == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    *free_slot = (struct simnet_option_t) { .level = level, .name = optname, .value = value };
+    return 0;
+}
+
+int simnet_getsockopt(int fd, int level, int optname, void *optval, socklen_t *optlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (optval == NULL || optlen == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    int value = 0;
+    if (level == SOL_SOCKET && optname == SO_TYPE) {
+        value = s->type;
+    } else if (level == SOL_SOCKET && optname == SO_DOMAIN) {
+        value = s->domain;
+    } else if (level == SOL_SOCKET && optname == SO_ACCEPTCONN) {
+        value = (s->state == SIMNET_LISTENING);
+    } else if (!(level == SOL_SOCKET && optname == SO_ERROR)) {
+        // The value set by setsockopt, 0 otherwise
+        for (int i = 0; i < SIMNET_OPTIONS_MAX; i++) {
+            if (s->options[i].name == optname && s->options[i].level == level) {
+                value = s->options[i].value;
+            }
+        }
+    }
+    memcpy(optval, &value, MIN(*optlen, sizeof(value)));
+    *optlen = MIN(*optlen, sizeof(value));
+    return 0;
+}
+
+int simnet_getsockname(int fd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (addr == NULL || addrlen == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (s->bound || (s->state == SIMNET_CONNECTED && s->locallen > 0)) {
+        // Bound, or accepted on a bound socket
+        addr_return(addr, addrlen, &(s->local), s->locallen);
+        return 0;
+    }
+    // Not bound: the wildcard address, with port 0
+    struct sockaddr_storage any;
+    memset(&any, 0, sizeof(any));
+    any.ss_family = s->domain;
+    addr_return(addr, addrlen, &any, (s->domain == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6)));
+    return 0;
+}
+
+int simnet_getpeername(int fd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (addr == NULL || addrlen == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (s->state != SIMNET_CONNECTED) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    addr_return(addr, addrlen, &(s->remote), s->remotelen);
+    return 0;
+}
+
+int simnet_close(int fd)
+{
+    struct simnet_socket_t *s = simnet_get(fd);
+    if (s == NULL) {
+        return -1;
+    }
+    if (s->type == SOCK_STREAM && s->state == SIMNET_CONNECTED && peers[s->peer].conn == fd) {
+        peer_disconnect(&peers[s->peer]);
+    }
+    memset(s, 0, sizeof(*s));
+    return __real_close(fd);
+}
+
+/*
+ * Returns the events of poll that are ready on the socket s.
+ */
+static short simnet_events(const struct simnet_socket_t *s)
+{
+    if (s->type == SOCK_DGRAM) {
+        return POLLOUT | (peer_sending(s) >= 0 ? POLLIN : 0);
+    }
+    if (s->state == SIMNET_LISTENING) {
+        for (int i = 0; i < SIMNET_PEERS_MAX; i++) {
+            if (peer_connecting(&peers[i], s)) {
+                return POLLIN;
+            }
+        }
+        return 0;
+    }
+    if (s->state != SIMNET_CONNECTED) {
+        return POLLOUT | POLLHUP;
+    }
+    struct simnet_peer_t *p = &peers[s->peer];
+    if (s->wr_closed) {
+        peer_eof(p);
+    }
+    const struct cs_network_chunk *c = peer_chunk(p);
+    short events = (s->wr_closed ? 0 : POLLOUT);
+    if (c == NULL || c->type == SEND_CHUNK) {
+        events |= POLLIN;
+    }
+    return events;
+}
+
+int simnet_poll(struct pollfd *fds, nfds_t nfds, int timeout)
+{
+    nfds_t owned = 0;
+    int ready = 0;
+    for (nfds_t i = 0; i < nfds; i++) {
+        if (simnet_owns(fds[i].fd)) {
+            owned++;
+            fds[i].revents = simnet_events(&sockets[fds[i].fd]) & (fds[i].events | POLLHUP | POLLERR);
+            ready += (fds[i].revents != 0);
+        }
+    }
+    if (owned == 0) {
+        return __real_poll(fds, nfds, timeout);
+    }
+    if (owned == nfds) {
+        // Nothing can change while waiting
+        return ready;
+    }
+    // The other descriptors, with the sockets negated so that the real poll ignores them
+    bool mine[nfds];
+    short saved[nfds];
+    for (nfds_t i = 0; i < nfds; i++) {
+        mine[i] = simnet_owns(fds[i].fd);
+        saved[i] = fds[i].revents;
+        if (mine[i]) {
+            fds[i].fd = -fds[i].fd - 1;
+        }
+    }
+    int ret = __real_poll(fds, nfds, (ready > 0 ? 0 : timeout));
+    for (nfds_t i = 0; i < nfds; i++) {
+        if (mine[i]) {
+            fds[i].fd = -fds[i].fd - 1;
+            fds[i].revents = saved[i];
+        }
+    }
+    return (ret < 0 ? ret : ret + ready);
+}
+
+int simnet_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout)
+{
+    fd_set r, w;
+    FD_ZERO(&r);
+    FD_ZERO(&w);
+    int owned = 0, ready = 0, others = 0;
+    for (int fd = 0; fd < nfds; fd++) {
+        bool in_r = (readfds != NULL && FD_ISSET(fd, readfds));
+        bool in_w = (writefds != NULL && FD_ISSET(fd, writefds));
+        bool in_e = (exceptfds != NULL && FD_ISSET(fd, exceptfds));
+        if (!(in_r || in_w || in_e)) {
+            continue;
+        }
+        if (!simnet_owns(fd)) {
+            others++;
+            continue;
+        }
+        owned++;
+        short events = simnet_events(&sockets[fd]);
+        if (in_r && (events & (POLLIN | POLLHUP))) {
+            FD_SET(fd, &r);
+            ready++;
+        }
+        if (in_w && (events & POLLOUT)) {
+            FD_SET(fd, &w);
+            ready++;
+        }
+        if (in_r) {
+            FD_CLR(fd, readfds);
+        }
+        if (in_w) {
+            FD_CLR(fd, writefds);
+        }
+        if (in_e) {
+            FD_CLR(fd, exceptfds);
+        }
+    }
+    if (owned == 0) {
+        return __real_select(nfds, readfds, writefds, exceptfds, timeout);
+    }
+    int ret = 0;
+    if (others > 0) {
+        struct timeval zero = { .tv_sec = 0, .tv_usec = 0 };
+        ret = __real_select(nfds, readfds, writefds, exceptfds, (ready > 0 ? &zero : timeout));
+        if (ret < 0) {
+            return ret;
+        }
+    } else {
+        // Nothing can change while waiting
+        if (readfds != NULL)
+            FD_ZERO(readfds);
+        if (writefds != NULL)
+            FD_ZERO(writefds);
+        if (exceptfds != NULL)
+            FD_ZERO(exceptfds);
+    }
+    for (int fd = 0; fd < nfds; fd++) {
+        if (FD_ISSET(fd, &r))
+            FD_SET(fd, readfds);
+        if (FD_ISSET(fd, &w))
+            FD_SET(fd, writefds);
+    }
+    return ret + ready;
+}
@@ -0,0 +1,121 @@
+#ifndef __CTESTER_SIMNET_H__
+#define __CTESTER_SIMNET_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#include "util_sockets.h"
+
+/**
+ * Simulated network, replacing the real one for the code running
+ * in the sandbox when it is enabled with set_simnet: instead of forking
+ * a mock server or client bound to a real port (launch_test_tcp_server
+ * and the others, see util_sockets.h), the test adds scripted peers,
+ * which play their cs_network_transactions in the same process, driven
+ * by the calls of the code tested. There are no kernel sockets, so tests
+ * running in parallel never collide on a port.
+ *
+ * Inside the sandbox, socket creates the AF_INET and AF_INET6 sockets
+ * in the simulated network; the wrappers of bind, connect, listen, accept,
+ * send, sendto, sendmsg, write, writev, recv, recvfrom, recvmsg, read, readv,
+ * sendfile, splice, poll, select, setsockopt, getsockopt, getsockname,
+ * getpeername, shutdown and close then serve these descriptors until they
+ * are closed, whether these calls are monitored or not. The options set with
+ * setsockopt are only kept, to be returned by getsockopt. Each of them is a real
+ * descriptor opened on /dev/null, so that its number cannot be reused.
+ *
+ * A peer of type SOCK_STREAM plays one transaction per connection:
+ * a server peer accepts a connection on its address, a client peer
+ * connects to the address the code tested listens on, and the next
+ * transaction starts with the next connection. The peer closes the
+ * connection when the last chunk of the transaction has been exchanged,
+ * and checks the RECV_CHUNK chunks as the mock server does. A peer of
+ * type SOCK_DGRAM exchanges one datagram per chunk, the transactions
+ * following one another.
+ *
+ * As the peers only act when the code tested calls the wrappers,
+ * a call that would wait for them forever (a recv while the peer waits
+ * for data, an accept without connection) fails with EAGAIN, as if a
+ * timeout had expired, and poll and select return 0 in that case.
+ */
+#define SIMNET_PEERS_MAX 16 // Maximum number of peers
+#define SIMNET_FD_MAX 1024 // Descriptors above this one cannot be used by the network
+#define SIMNET_PORT_BASE 40000 // Port of the client peer i is SIMNET_PORT_BASE + i
+
+/**
+ * What a peer observed. status is OK, or the first problem found:
+ * TOO_FEW or NOTHING_RECV if the connection ended before a RECV_CHUNK
+ * was complete, TOO_MUCH if the code tested sent data that the peer
+ * didn't expect, NOT_SAME_DATA if it differed (see util_sockets.h).
+ */
+struct simnet_report_t {
+    int status;
+    size_t transaction; // Transaction of the first problem
+    size_t chunk; // Chunk of the first problem in it
+    size_t done; // Number of transactions ended
+};
+
+/**
+ * Enables or disables the simulated network; it stays so for the following tests.
+ */
+void set_simnet(bool enabled);
+
+bool simnet_enabled(void);
+
+/**
+ * Adds a server peer, of type SOCK_STREAM or SOCK_DGRAM, reachable
+ * at the address addr, playing transactions (which must stay valid
+ * until the end of the test). Returns the number of the peer,
+ * or -1 with errno set on failure.
+ */
+int simnet_add_server(const struct sockaddr *addr, socklen_t addrlen, int type, const struct cs_network_transactions *transactions);
+
+/**
+ * Adds a client peer, connecting to (or sending to) the code tested
+ * at the address addr, once it listens on it (or is bound to it).
+ * Returns the number of the peer, or -1 with errno set on failure.
+ */
+int simnet_add_client(const struct sockaddr *addr, socklen_t addrlen, int type, const struct cs_network_transactions *transactions);
+
+/**
+ * Returns the report of the peer, or NULL if it doesn't exist.
+ */
+const struct simnet_report_t *simnet_report(int peer);
+
+/**
+ * Closes all the descriptors of the network and removes the peers.
+ * Called by start_test, so that each test adds its own peers.
+ */
+void simnet_reset(void);
+
+/**
+ * Returns true if fd is a socket of the simulated network.
+ */
+bool simnet_owns(int fd);
+
+/**
+ * Implementations of the system calls, for the wrappers; they behave as
+ * the real ones, with the same errno values. simnet_poll and simnet_select
+ * use the real calls for the other descriptors.
+ */
+int simnet_socket(int domain, int type, int protocol);
+int simnet_bind(int fd, const struct sockaddr *addr, socklen_t addrlen);
+int simnet_connect(int fd, const struct sockaddr *addr, socklen_t addrlen);
+int simnet_listen(int fd, int backlog);
+int simnet_accept(int fd, struct sockaddr *addr, socklen_t *addrlen);
+ssize_t simnet_sendmsg(int fd, const struct msghdr *msg, int flags);
+ssize_t simnet_recvmsg(int fd, struct msghdr *msg, int flags);
+int simnet_setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen);
+int simnet_getsockopt(int fd, int level, int optname, void *optval, socklen_t *optlen);
+int simnet_getsockname(int fd, struct sockaddr *addr, socklen_t *addrlen);
+int simnet_getpeername(int fd, struct sockaddr *addr, socklen_t *addrlen);
+int simnet_shutdown(int fd, int how);
+int simnet_close(int fd);
+int simnet_poll(struct pollfd *fds, nfds_t nfds, int timeout);
+int simnet_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
+
+#endif // __CTESTER_SIMNET_H__
@@ -4,35 +4,226 @@
 
 #include "trap.h"
 
-void *trap_buffer(size_t size, int type, int flags, void *data)
+// The arenas are not mappings of the student: bypass the wrappers
+void *__real_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
+int __real_munmap(void *addr, size_t length);
+int __real_mprotect(void *addr, size_t len, int prot);
+
+/**
+ * Bookkeeping of a page of a trap arena. Depending on the role of the page,
+ * only some of the fields are meaningful:
+ * - on the guard page of a slot: npages and, if the slot is free, next_free;
+ * - on the first data page in use of a slot: slot, used, offset and size.
+ */
+struct trap_page_t {
+    uint32_t npages; // Number of data pages of the slot
+    size_t next_free; // Guard page of the next free slot of the same class, plus one
+    uint32_t slot; // Guard page of the slot, plus one; 0 if no buffer starts in this page
+    uint32_t used; // Number of data pages made accessible for the buffer
+    size_t offset; // Offset of the buffer in this page
+    size_t size; // Size requested for the buffer
+};
+
+static int trap_arena_reserve(struct trap_arena_t *arena)
 {
     size_t pagesize = sysconf(_SC_PAGESIZE);
-    int nb_pages = (size / pagesize) + 2;
-    void *ptr = mmap(NULL, pagesize * nb_pages, PROT_READ | PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
-    if (ptr == MAP_FAILED) {
+    size_t npages = TRAP_ARENA_SIZE / pagesize;
+    void *base = __real_mmap(NULL, npages * pagesize, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    // Only the entries of the pages actually used will be backed by memory
+    struct trap_page_t *pages = __real_mmap(NULL, npages * sizeof(struct trap_page_t), PROT_READ | PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (pages == MAP_FAILED) {
+        __real_munmap(base, npages * pagesize);
+        return -1;
+    }
+    memset(arena, 0, sizeof(*arena));
+    arena->base = base;
+    arena->pagesize = pagesize;
+    arena->npages = npages;
+    arena->pages = pages;
+    return 0;
+}
+
+/**
+ * Returns the guard page of a free slot with at least npages data pages,
+ * or -1 if there is none.
+ */
+static ssize_t trap_arena_take_free(struct trap_arena_t *arena, size_t npages)
+{
+    size_t class = (npages < TRAP_ARENA_CLASSES ? npages : 0);
+    size_t *prev = &(arena->free_slots[class]);
+    while (*prev != 0) {
+        size_t guard = *prev - 1;
+        if (arena->pages[guard].npages >= npages) {
+            *prev = arena->pages[guard].next_free;
+            arena->pages[guard].next_free = 0;
+            return guard;
+        }
+        // Only the class of the bigger slots isn't exact
+        prev = &(arena->pages[guard].next_free);
+    }
+    return -1;
+}
+
+void *trap_arena_alloc(struct trap_arena_t *arena, size_t size, int type, size_t align)
+{
+    if (type != TRAP_LEFT && type != TRAP_RIGHT && type != TRAP_BOTH) {
+        return NULL;
+    }
+    if (arena->base == NULL && trap_arena_reserve(arena)) {
         return NULL;
     }
+    size_t pagesize = arena->pagesize;
+    size_t used = (size + pagesize - 1) / pagesize;
+    if (used == 0) {
+        used = 1;
+    }
+    ssize_t guard = trap_arena_take_free(arena, used);
+    if (guard < 0) {
+        // The last page of the region is kept as the guard of the last slot
+        if (used + 1 > arena->npages - 1 - arena->next) {
+            return NULL;
+        }
+        guard = arena->next;
+        arena->pages[guard].npages = used;
+        arena->next += used + 1;
+    }
+    size_t npages = arena->pages[guard].npages;
+    size_t first = guard + 1;
+    if (type != TRAP_LEFT) {
+        first += npages - used;
+    }
+    void *pages_start = arena->base + first * pagesize;
+    if (__real_mprotect(pages_start, used * pagesize, PROT_READ | PROT_WRITE)) {
+        // Put the slot back
+        size_t class = (npages < TRAP_ARENA_CLASSES ? npages : 0);
+        arena->pages[guard].next_free = arena->free_slots[class];
+        arena->free_slots[class] = guard + 1;
+        return NULL;
+    }
+    void *buf_start = pages_start;
+    if (type != TRAP_LEFT) {
+        uintptr_t end = (uintptr_t)pages_start + used * pagesize;
+        // An empty buffer takes the last byte, to start in its own pages
+        uintptr_t start = end - (size == 0 ? 1 : size);
+        if (align > 1) {
+            start &= ~((uintptr_t)align - 1);
+        }
+        buf_start = (void *)start;
+    }
+    arena->pages[first] = (struct trap_page_t) {
+        .npages = arena->pages[first].npages,
+        .next_free = arena->pages[first].next_free,
+        .slot = guard + 1,
+        .used = used,
+        .offset = buf_start - pages_start,
+        .size = size
+    };
+    return buf_start;
+}
+
+bool trap_arena_owns(const struct trap_arena_t *arena, const void *ptr)
+{
+    return (arena->base != NULL && ptr >= arena->base &&
+            ptr < arena->base + arena->npages * arena->pagesize);
+}
 
-    void *buf_start;
-    if (type == TRAP_LEFT) {
-        buf_start = ptr + pagesize;
-        mprotect(ptr, pagesize, PROT_NONE);
-    } else if (type == TRAP_RIGHT) {
-        buf_start = ptr + (nb_pages - 1) * pagesize - size;
-        mprotect(ptr + (nb_pages - 1)*pagesize, pagesize, PROT_NONE);
-    } else {
+/**
+ * Returns the bookkeeping entry of the buffer starting at ptr,
+ * or NULL if ptr is not the start of a buffer of the arena.
+ */
+static struct trap_page_t *trap_arena_lookup(const struct trap_arena_t *arena, const void *ptr)
+{
+    if (!trap_arena_owns(arena, ptr)) {
+        return NULL;
+    }
+    size_t page = (ptr - arena->base) / arena->pagesize;
+    struct trap_page_t *entry = &(arena->pages[page]);
+    if (entry->slot == 0 || (size_t)(ptr - arena->base) != page * arena->pagesize + entry->offset) {
+        return NULL;
+    }
+    return entry;
+}
+
+int trap_arena_free(struct trap_arena_t *arena, void *ptr)
+{
+    struct trap_page_t *entry = trap_arena_lookup(arena, ptr);
+    if (entry == NULL) {
+        return -1;
+    }
+    size_t guard = entry->slot - 1;
+    __real_mprotect(ptr - entry->offset, entry->used * arena->pagesize, PROT_NONE);
+    entry->slot = 0;
+    entry->used = 0;
+    entry->offset = 0;
+    entry->size = 0;
+    size_t npages = arena->pages[guard].npages;
+    size_t class = (npages < TRAP_ARENA_CLASSES ? npages : 0);
+    arena->pages[guard].next_free = arena->free_slots[class];
+    arena->free_slots[class] = guard + 1;
+    return 0;
+}
+
+int trap_arena_protect(struct trap_arena_t *arena, void *ptr, int prot)
+{
+    struct trap_page_t *entry = trap_arena_lookup(arena, ptr);
+    if (entry == NULL) {
+        return -1;
+    }
+    return __real_mprotect(ptr - entry->offset, entry->used * arena->pagesize, prot);
+}
+
+void trap_arena_reset(struct trap_arena_t *arena)
+{
+    if (arena->base == NULL) {
+        return;
+    }
+    size_t len = arena->next * arena->pagesize;
+    __real_mprotect(arena->base, len, PROT_NONE);
+    madvise(arena->base, len, MADV_DONTNEED);
+    // The bookkeeping of the pages is zeroed by MADV_DONTNEED too
+    madvise(arena->pages, arena->next * sizeof(struct trap_page_t), MADV_DONTNEED);
+    memset(arena->free_slots, 0, sizeof(arena->free_slots));
+    arena->next = 0;
+}
+
+size_t trap_arena_size(const struct trap_arena_t *arena, const void *ptr)
+{
+    struct trap_page_t *entry = trap_arena_lookup(arena, ptr);
+    return (entry == NULL ? 0 : entry->size);
+}
+
+
+/**
+ * Arena of the buffers returned by trap_buffer.
+ */
+static struct trap_arena_t trap_buffers;
+
+void *trap_buffer(size_t size, int type, int flags, void *data)
+{
+    void *buf = trap_arena_alloc(&trap_buffers, size, type, 1);
+    if (buf == NULL) {
         return NULL;
     }
 
     if (data != NULL)
-        memcpy(buf_start, data, size);
+        memcpy(buf, data, size);
 
-    mprotect(buf_start, size, flags);
+    if (flags != (PROT_READ | PROT_WRITE))
+        trap_arena_protect(&trap_buffers, buf, flags);
 
-    return buf_start;
+    return buf;
 }
 
 int free_trap(void *ptr, size_t size)
 {
-    return munmap(ptr, size);
+    (void)size;
+    return trap_arena_free(&trap_buffers, ptr);
+}
+
+void free_all_traps(void)
+{
+    trap_arena_reset(&trap_buffers);
 }
@@ -1,14 +1,110 @@
 #ifndef __CTESTER_TRAP_H__
 #define __CTESTER_TRAP_H__
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
 enum {
     TRAP_LEFT,
-    TRAP_RIGHT
+    TRAP_RIGHT,
+    TRAP_BOTH
 };
 
 
+/**
+ * Returns a buffer of size bytes with the permissions flags (PROT_READ,
+ * PROT_WRITE or PROT_NONE, applied to whole pages), filled with a copy of
+ * data if it isn't NULL.
+ * The buffer is surrounded by protected pages: with TRAP_LEFT, it starts
+ * right after one; with TRAP_RIGHT and TRAP_BOTH, it ends right before one.
+ * The buffers come from a trap arena (see below) shared by all the tests.
+ * Returns NULL if the buffer couldn't be allocated.
+ */
 void *trap_buffer(size_t size, int type, int flags, void *data);
+
+/**
+ * Releases a buffer returned by trap_buffer; size is ignored, and only kept
+ * for compatibility. Returns 0 on success, -1 if ptr isn't such a buffer.
+ */
 int free_trap(void *ptr, size_t size);
 
-#endif // __CTESTER_TRAP_H__
+/**
+ * Releases all the buffers returned by trap_buffer at once.
+ * Called by start_test, so that a buffer only lives until the end of its test.
+ */
+void free_all_traps(void);
+
+/**
+ * Arena of guard-bracketed slots, carved out of a single region reserved
+ * once with mmap, instead of one mapping per buffer.
+ *
+ * Each slot is made of a PROT_NONE guard page followed by its data pages.
+ * As the next slot starts with its own guard page (and the unused part of
+ * the region is PROT_NONE too), the data pages of every slot are surrounded
+ * by protected pages. The type given to trap_arena_alloc only decides against
+ * which side the buffer is placed: TRAP_LEFT places it at the start of its
+ * first data page, TRAP_RIGHT (and TRAP_BOTH) at the end of its last one,
+ * so that an overflow of a single byte on this side raises a SIGSEGV.
+ *
+ * Freed slots are protected again and kept in free lists (by number of data
+ * pages), to be recycled by the following allocations.
+ *
+ * A zero-initialized struct trap_arena_t is a valid, empty arena: the region
+ * is only reserved by the first allocation.
+ */
+#define TRAP_ARENA_SIZE (256UL * 1024 * 1024) // Size of the reserved region
+#define TRAP_ARENA_CLASSES 16 // Free lists for 1..15 data pages, index 0 for bigger slots
+
+struct trap_page_t;
+
+struct trap_arena_t {
+    void *base; // Start of the reserved region, NULL if not reserved yet
+    size_t pagesize;
+    size_t npages; // Number of pages of the region
+    size_t next; // First page that has never been part of a slot
+    struct trap_page_t *pages; // Bookkeeping, one entry per page of the region
+    size_t free_slots[TRAP_ARENA_CLASSES]; // Guard page of the first free slot, plus one
+};
 
+/**
+ * Returns a buffer of size bytes, readable and writable, placed against
+ * the guard page indicated by type (TRAP_LEFT or TRAP_RIGHT).
+ * With TRAP_RIGHT, the start of the buffer is rounded down to a multiple
+ * of align (a power of two; 0 or 1 places it exactly against the guard page).
+ * Returns NULL if the arena is full or couldn't be reserved.
+ */
+void *trap_arena_alloc(struct trap_arena_t *arena, size_t size, int type, size_t align);
+
+/**
+ * Protects the slot of ptr (which must have been returned by
+ * trap_arena_alloc) and makes it available for the following allocations.
+ * Returns 0 on success, -1 if ptr is not the start of a buffer of the arena.
+ */
+int trap_arena_free(struct trap_arena_t *arena, void *ptr);
+
+/**
+ * Changes the protection (PROT_NONE, PROT_READ...) of the data pages of
+ * the buffer starting at ptr, which stays allocated.
+ * Returns 0 on success, -1 if ptr is not the start of a buffer of the arena.
+ */
+int trap_arena_protect(struct trap_arena_t *arena, void *ptr, int prot);
+
+/**
+ * Releases all the buffers of the arena at once: the region is protected
+ * again and its memory given back to the system, but stays reserved.
+ */
+void trap_arena_reset(struct trap_arena_t *arena);
+
+/**
+ * Returns true if ptr points inside the region of the arena.
+ */
+bool trap_arena_owns(const struct trap_arena_t *arena, const void *ptr);
+
+/**
+ * Returns the size requested for the buffer starting at ptr,
+ * or 0 if ptr is not the start of a buffer of the arena.
+ */
+size_t trap_arena_size(const struct trap_arena_t *arena, const void *ptr);
+
+#endif // __CTESTER_TRAP_H__
@@ -0,0 +1,54 @@
+#include "util_histogram.h"
+
+unsigned int histogram_bucket(size_t value)
+{
+    if (value == 0) {
+        return 0;
+    }
+    unsigned int bucket = 64 - __builtin_clzll(value);
+    return (bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1);
+}
+
+size_t histogram_bucket_min(unsigned int bucket)
+{
+    if (bucket == 0) {
+        return 0;
+    }
+    return (size_t)1 << (bucket - 1);
+}
+
+void histogram_add(struct histogram_t *h, size_t value)
+{
+    h->count[histogram_bucket(value)]++;
+    h->n++;
+    h->sum += value;
+}
+
+uint32_t histogram_count(const struct histogram_t *h, size_t min, size_t max)
+{
+    uint32_t n = 0;
+    for (unsigned int i = histogram_bucket(min); i <= histogram_bucket(max); i++) {
+        n += h->count[i];
+    }
+    return n;
+}
+
+void io_stats_add(struct stats_io_t *io, size_t count, ssize_t ret)
+{
+    if (ret < 0) {
+        return;
+    }
+    io->bytes += ret;
+    histogram_add(&io->sizes, ret);
+    if ((size_t)ret < count) {
+        io->short_calls++;
+    }
+}
+
+double io_calls_per_kib(const struct stats_io_t *io)
+{
+    if (io->bytes == 0) {
+        return 0;
+    }
+    return io->sizes.n * 1024.0 / io->bytes;
+}
@@ -0,0 +1,78 @@
+/**
+ * Histograms of sizes, bucketed by powers of two
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CTESTER_UTIL_HISTOGRAM_H__
+#define __CTESTER_UTIL_HISTOGRAM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * Bucket 0 counts the values 0, bucket i (i >= 1) the values in
+ * [2^(i-1), 2^i), and the last bucket all the values from 2^31 on.
+ */
+#define HISTOGRAM_BUCKETS 33
+
+struct histogram_t {
+    uint32_t count[HISTOGRAM_BUCKETS]; // Number of values in each bucket
+    uint32_t n; // Total number of values
+    uint64_t sum; // Sum of the values
+};
+
+/**
+ * Returns the index of the bucket of value.
+ */
+unsigned int histogram_bucket(size_t value);
+
+/**
+ * Returns the smallest value of the bucket.
+ */
+size_t histogram_bucket_min(unsigned int bucket);
+
+/**
+ * Adds value to the histogram.
+ */
+void histogram_add(struct histogram_t *h, size_t value);
+
+/**
+ * Returns the number of values of the histogram in [min, max],
+ * counting whole buckets: the buckets of min and max are included.
+ */
+uint32_t histogram_count(const struct histogram_t *h, size_t min, size_t max);
+
+/**
+ * Volume of the data transferred by the successful calls to a read-like
+ * or write-like function, to grade how efficiently the student does I/O.
+ */
+struct stats_io_t {
+    uint64_t bytes; // Total number of bytes transferred
+    struct histogram_t sizes; // Number of bytes transferred by each call
+    int short_calls; // Calls that transferred less than requested (end of file included)
+};
+
+/**
+ * Records a call that requested count bytes and returned ret
+ * (ignored if negative, i.e. if the call failed).
+ */
+void io_stats_add(struct stats_io_t *io, size_t count, ssize_t ret);
+
+/**
+ * Returns the number of successful calls per KiB transferred,
+ * or 0 if nothing has been transferred.
+ */
+double io_calls_per_kib(const struct stats_io_t *io);
+
+#endif // __CTESTER_UTIL_HISTOGRAM_H__
@@ -0,0 +1,31 @@
+#include "util_random.h"
+
+void rng_seed(struct rng_t *rng, uint64_t seed)
+{
+    // splitmix64 spreads the bits of similar seeds, and never gives 0 here
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    rng->state = (z != 0 ? z : 0x9e3779b97f4a7c15ULL);
+}
+
+uint64_t rng_next(struct rng_t *rng)
+{
+    uint64_t x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+uint64_t rng_range(struct rng_t *rng, uint64_t min, uint64_t max)
+{
+    uint64_t span = max - min + 1;
+    if (span == 0) {
+        // [0, UINT64_MAX]
+        return rng_next(rng);
+    }
+    return min + rng_next(rng) % span;
+}
@@ -0,0 +1,41 @@
+/**
+ * Small seeded pseudo-random number generator (xorshift64*), so that the
+ * random choices of a test can be reproduced from its seed.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CTESTER_UTIL_RANDOM_H__
+#define __CTESTER_UTIL_RANDOM_H__
+
+#include <stdint.h>
+
+struct rng_t {
+    uint64_t state; // Never 0
+};
+
+/**
+ * Initializes rng; the same seed always gives the same sequence.
+ */
+void rng_seed(struct rng_t *rng, uint64_t seed);
+
+/**
+ * Returns the next 64 bits of the sequence of rng.
+ */
+uint64_t rng_next(struct rng_t *rng);
+
+/**
+ * Returns a number of the sequence of rng in [min, max] (min <= max).
+ */
+uint64_t rng_range(struct rng_t *rng, uint64_t min, uint64_t max);
+
+#endif // __CTESTER_UTIL_RANDOM_H__
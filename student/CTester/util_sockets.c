@@ -7,10 +7,15 @@
 #include <sys/socket.h>
 #include <poll.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
 
 #include "util_sockets.h"
+#include "util_random.h"
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
 
 const uint8_t _OK = 0;
 const uint8_t _TOO_MUCH = 1;
@@ -462,11 +467,200 @@ int wait_send_udp(int sockfd, int pipe_in, int pipe_out, const struct cs_network
     return 0;
 }
 
+/**
+ * State of the impairments of a transaction.
+ */
+struct impair_state_t {
+    const struct cs_network_impairment *imp;
+    struct rng_t rng;
+    struct timespec start;
+    uint64_t clock; // In ms since the start of the transaction
+    uint64_t link_free; // Time at which the link will have sent everything
+};
+
+/**
+ * A datagram of a burst, and the time at which it is sent.
+ */
+struct impair_datagram_t {
+    const struct cs_network_chunk *chunk;
+    uint64_t time;
+    bool corrupt;
+};
+
+static void impair_init(struct impair_state_t *st, const struct cs_network_impairment *imp)
+{
+    st->imp = imp;
+    rng_seed(&(st->rng), imp->seed);
+    clock_gettime(CLOCK_MONOTONIC, &(st->start));
+    st->clock = 0;
+    st->link_free = 0;
+}
+
+/*
+ * Returns true with probability prob thousandths.
+ */
+static bool impair_draw(struct impair_state_t *st, unsigned prob)
+{
+    return prob > 0 && rng_range(&(st->rng), 0, 999) < prob;
+}
+
+static uint64_t impair_now(struct impair_state_t *st)
+{
+    if (!st->imp->virtual_clock) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        st->clock = (now.tv_sec - st->start.tv_sec) * 1000 + (now.tv_nsec - st->start.tv_nsec) / 1000000;
+    }
+    return st->clock;
+}
+
+static void impair_sleep_until(struct impair_state_t *st, uint64_t t)
+{
+    uint64_t now = impair_now(st);
+    if (t <= now) {
+        return;
+    }
+    if (!st->imp->virtual_clock) {
+        struct timespec ts = { .tv_sec = (t - now) / 1000, .tv_nsec = ((t - now) % 1000) * 1000000 };
+        while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+    }
+    st->clock = t;
+}
+
+static uint64_t impair_delay(struct impair_state_t *st)
+{
+    const struct cs_network_impairment *imp = st->imp;
+    return rng_range(&(st->rng), imp->delay_min, MAX(imp->delay_min, imp->delay_max));
+}
+
+/**
+ * Sends chunk on sockfd with the delay and the rate of st.
+ * Returns as wait_send_tcp.
+ */
+static int impair_send_tcp(int sockfd, int pipe_in, int pipe_out, const struct cs_network_chunk *chunk, struct impair_state_t *st)
+{
+    impair_sleep_until(st, impair_now(st) + impair_delay(st));
+    size_t piece = (st->imp->rate > 0 ? MAX(st->imp->rate / 10, 1) : chunk->data_length);
+    size_t off = 0;
+    do {
+        struct cs_network_chunk part = {
+            .data = (char *)chunk->data + off,
+            .data_length = MIN(piece, chunk->data_length - off),
+            .type = SEND_CHUNK
+        };
+        int s = wait_send_tcp(sockfd, pipe_in, pipe_out, &part);
+        if (s != 0) {
+            return s;
+        }
+        off += part.data_length;
+        if (off < chunk->data_length) {
+            impair_sleep_until(st, impair_now(st) + 100);
+        }
+    } while (off < chunk->data_length);
+    return 0;
+}
+
+/**
+ * Sends the burst of n datagrams chunks through the impaired link.
+ * Returns as wait_send_udp.
+ */
+static int impair_send_udp(int sockfd, int pipe_in, int pipe_out, const struct cs_network_chunk *chunks, size_t n, const struct sockaddr *addr, socklen_t addrlen, struct impair_state_t *st)
+{
+    const struct cs_network_impairment *imp = st->imp;
+    struct impair_datagram_t *dgrams = malloc(2 * n * sizeof(struct impair_datagram_t));
+    if (!dgrams) {
+        perror("malloc");
+        return -3;
+    }
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (impair_draw(st, imp->drop)) {
+            continue;
+        }
+        int copies = (impair_draw(st, imp->duplicate) ? 2 : 1);
+        for (int c = 0; c < copies; c++) {
+            uint64_t begin = MAX(impair_now(st), st->link_free);
+            st->link_free = begin + (imp->rate > 0 ? chunks[i].data_length * 1000 / imp->rate : 0);
+            dgrams[m].chunk = &chunks[i];
+            dgrams[m].time = st->link_free + impair_delay(st);
+            dgrams[m].corrupt = chunks[i].data_length > 0 && impair_draw(st, imp->corrupt);
+            m++;
+        }
+    }
+    for (size_t i = 0; i + 1 < m; i++) {
+        if (impair_draw(st, imp->reorder)) {
+            uint64_t t = dgrams[i].time;
+            dgrams[i].time = dgrams[i + 1].time;
+            dgrams[i + 1].time = t;
+        }
+    }
+    // Stable sort by time, the bursts are short
+    for (size_t i = 1; i < m; i++) {
+        struct impair_datagram_t d = dgrams[i];
+        size_t j = i;
+        for (; j > 0 && dgrams[j - 1].time > d.time; j--) {
+            dgrams[j] = dgrams[j - 1];
+        }
+        dgrams[j] = d;
+    }
+    int ret = 0;
+    for (size_t i = 0; i < m && ret == 0; i++) {
+        impair_sleep_until(st, dgrams[i].time);
+        struct cs_network_chunk chunk = *(dgrams[i].chunk);
+        if (dgrams[i].corrupt) {
+            chunk.data = malloc(chunk.data_length);
+            if (!chunk.data) {
+                perror("malloc");
+                ret = -3;
+                break;
+            }
+            memcpy(chunk.data, dgrams[i].chunk->data, chunk.data_length);
+            size_t pos = rng_range(&(st->rng), 0, chunk.data_length - 1);
+            ((uint8_t *)chunk.data)[pos] ^= (uint8_t)rng_range(&(st->rng), 1, 255);
+        }
+        ret = wait_send_udp(sockfd, pipe_in, pipe_out, &chunk, addr, addrlen);
+        if (dgrams[i].corrupt) {
+            free(chunk.data);
+        }
+    }
+    free(dgrams);
+    return ret;
+}
+
+/**
+ * Receives a datagram on sockfd and ignores it, as lost.
+ * Returns 0 if done, 1 if pipe_in got a message, -1 if recv error,
+ * -2 if pipe_in got a problem, -3 if syscall problem.
+ */
+static int impair_lose_udp(int sockfd, int pipe_in)
+{
+    struct pollfd fds[2] = {
+        { .fd = sockfd, .events = POLLIN | POLLERR, .revents = 0 },
+        { .fd = pipe_in, .events = POLLIN | POLLERR, .revents = 0 }
+    };
+    if (poll(fds, 2, -1) == -1) {
+        perror("poll");
+        return -3;
+    }
+    if (fds[1].revents) {
+        return (fds[1].revents & POLLIN) ? 1 : -2;
+    }
+    char buf[1];
+    if (!(fds[0].revents & POLLIN) || recv(sockfd, buf, sizeof(buf), 0) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * Return 3 if process was asked to stop, 2 if error, 0 on success.
  */
 int handle_tcp_transaction(int sockfd, const struct cs_network_transaction *transaction, int pipe_in, int pipe_out)
 {
+    struct impair_state_t st;
+    if (transaction->impairment) {
+        impair_init(&st, transaction->impairment);
+    }
     for (unsigned j = 0; j < transaction->nchunks; j++) {
         struct cs_network_chunk *curchunk = &(transaction->chunks[j]);
         if (curchunk->type == RECV_CHUNK) {
@@ -501,7 +695,9 @@ int handle_tcp_transaction(int sockfd, const struct cs_network_transaction *tran
             }
         } else if (curchunk->type == SEND_CHUNK) {
             // send
-            int s = wait_send_tcp(sockfd, pipe_in, pipe_out, curchunk);
+            int s = (transaction->impairment
+                    ? impair_send_tcp(sockfd, pipe_in, pipe_out, curchunk, &st)
+                    : wait_send_tcp(sockfd, pipe_in, pipe_out, curchunk));
             if (s < -1) {
                 fprintf(stderr, "Server error\n");
                 return 2;
@@ -521,11 +717,21 @@ int handle_tcp_transaction(int sockfd, const struct cs_network_transaction *tran
 
 int handle_udp_transaction(int sockfd, const struct cs_network_transaction *transaction, int pipe_in, int pipe_out)
 {
+    struct impair_state_t st;
+    if (transaction->impairment) {
+        impair_init(&st, transaction->impairment);
+    }
     for (unsigned int j = 0; j < transaction->nchunks; j++) {
         struct cs_network_chunk *curchunk = &(transaction->chunks[j]);
         if (curchunk->type == RECV_CHUNK) {
             // recvfrom
-            int r = wait_recv_udp(sockfd, pipe_in, pipe_out, curchunk, transaction->addr, transaction->addrlen);
+            int r = 0;
+            while (r == 0 && transaction->impairment && impair_draw(&st, transaction->impairment->drop_recv)) {
+                r = impair_lose_udp(sockfd, pipe_in);
+            }
+            if (r == 0) {
+                r = wait_recv_udp(sockfd, pipe_in, pipe_out, curchunk, transaction->addr, transaction->addrlen);
+            }
             if (r < -1) {
                 fprintf(stderr, "Server error\n");
                 return 2;
@@ -552,7 +758,18 @@ int handle_udp_transaction(int sockfd, const struct cs_network_transaction *tran
             // TODO complete
         } else if (curchunk->type == SEND_CHUNK) {
             // sendto
-            int r = wait_send_udp(sockfd, pipe_in, pipe_out, curchunk, transaction->addr, transaction->addrlen);
+            int r;
+            if (transaction->impairment) {
+                // The burst of datagrams, sent together
+                unsigned int k = j + 1;
+                while (k < transaction->nchunks && transaction->chunks[k].type == SEND_CHUNK) {
+                    k++;
+                }
+                r = impair_send_udp(sockfd, pipe_in, pipe_out, curchunk, k - j, transaction->addr, transaction->addrlen, &st);
+                j = k - 1;
+            } else {
+                r = wait_send_udp(sockfd, pipe_in, pipe_out, curchunk, transaction->addr, transaction->addrlen);
+            }
             if (r < -1) {
                 fprintf(stderr, "Server error\n");
                 return 2;
@@ -719,3 +936,247 @@ int launch_test_udp_client(struct cs_network_transactions *transactions, const c
     PIPE_AND_FORK_END();
 }
 
+/**
+ * A connection of the load client.
+ */
+struct load_conn_t {
+    int fd;
+    const struct cs_network_transaction *trans;
+    size_t chunk; // Current chunk
+    size_t off; // Bytes of the current chunk already exchanged
+    size_t bytes; // Bytes of the transaction
+    struct timespec start;
+    double latency;
+    bool done;
+    bool failed;
+};
+
+static double elapsed(const struct timespec *from, const struct timespec *to)
+{
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+static void load_end(int epfd, struct load_conn_t *c, bool failed)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    c->latency = elapsed(&(c->start), &now);
+    c->done = true;
+    c->failed = failed;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+}
+
+/*
+ * Advances c as far as possible without blocking, then waits for
+ * the event it needs.
+ */
+static void load_step(int epfd, struct load_conn_t *c, uint32_t events, int type)
+{
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0 || !(events & EPOLLIN)) {
+            load_end(epfd, c, true);
+            return;
+        }
+    }
+    while (c->chunk < c->trans->nchunks) {
+        const struct cs_network_chunk *chunk = &(c->trans->chunks[c->chunk]);
+        size_t left = chunk->data_length - c->off;
+        uint32_t wait = 0;
+        if (chunk->type == SEND_CHUNK) {
+            ssize_t n = send(c->fd, (const char *)chunk->data + c->off, left, MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOTCONN)) {
+                wait = EPOLLOUT;
+            } else if (n < 0) {
+                load_end(epfd, c, true);
+                return;
+            } else {
+                c->off += n;
+            }
+        } else {
+            // One more byte, to detect a datagram too long
+            char buf[BUFSIZ];
+            size_t want = (type == SOCK_DGRAM ? sizeof(buf) : MIN(left, sizeof(buf)));
+            ssize_t n = recv(c->fd, buf, want, 0);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                wait = EPOLLIN;
+            } else if (n <= 0
+                    || (type == SOCK_DGRAM && (size_t)n != chunk->data_length)
+                    || memcmp((const char *)chunk->data + c->off, buf, n) != 0) {
+                // Error, end of the connection, or different data
+                load_end(epfd, c, true);
+                return;
+            } else {
+                c->off += n;
+            }
+        }
+        if (wait != 0) {
+            struct epoll_event ev = { .events = wait, .data.ptr = c };
+            epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+            return;
+        }
+        if (c->off >= chunk->data_length) {
+            c->chunk++;
+            c->off = 0;
+        }
+    }
+    load_end(epfd, c, false);
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Returns the percentile p of the n sorted values, by the nearest rank.
+ */
+static double percentile(const double *sorted, size_t n, double p)
+{
+    if (n == 0) {
+        return 0;
+    }
+    size_t rank = (size_t)(p * n + 0.999999);
+    return sorted[(rank == 0 ? 1 : MIN(rank, n)) - 1];
+}
+
+/*
+ * Opens the nconn connections and drives them until they all end.
+ */
+static void load_run(struct cs_network_transactions *transactions, const char *host, const char *serv, int domain, int type, size_t nconn, int pipe_in, struct load_report_t *report)
+{
+    memset(report, 0, sizeof(*report));
+    struct addrinfo hints, *rep;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    hints.ai_family = domain;
+    hints.ai_socktype = type;
+    struct load_conn_t *conns = calloc(nconn, sizeof(struct load_conn_t));
+    int epfd = epoll_create1(0);
+    if (conns == NULL || epfd < 0 || transactions->ntransactions == 0
+            || getaddrinfo(host, serv, &hints, &rep) != 0) {
+        report->errors = nconn;
+        free(conns);
+        return;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, pipe_in, &ev);
+    struct timespec begin, now;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    size_t running = 0;
+    for (size_t i = 0; i < nconn; i++) {
+        struct load_conn_t *c = &conns[i];
+        c->trans = &(transactions->transactions[i % transactions->ntransactions]);
+        for (size_t j = 0; j < c->trans->nchunks; j++) {
+            c->bytes += c->trans->chunks[j].data_length;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &(c->start));
+        c->fd = socket(rep->ai_family, rep->ai_socktype | SOCK_NONBLOCK, rep->ai_protocol);
+        if (c->fd < 0) {
+            c->done = c->failed = true;
+            continue;
+        }
+        report->connections++;
+        if (connect(c->fd, rep->ai_addr, rep->ai_addrlen) < 0 && errno != EINPROGRESS) {
+            close(c->fd);
+            c->done = c->failed = true;
+            continue;
+        }
+        ev = (struct epoll_event) { .events = EPOLLOUT, .data.ptr = c };
+        epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+        running++;
+    }
+    freeaddrinfo(rep);
+    struct epoll_event events[64];
+    bool stop = false;
+    while (running > 0 && !stop) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int timeout = (int)((LOAD_TIMEOUT - elapsed(&begin, &now)) * 1000);
+        if (timeout <= 0) {
+            break;
+        }
+        int n = epoll_wait(epfd, events, 64, timeout);
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            struct load_conn_t *c = events[i].data.ptr;
+            if (c == NULL) {
+                // Asked to stop
+                stop = true;
+            } else if (!c->done) {
+                load_step(epfd, c, events[i].events, type);
+                running -= c->done;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    report->duration = elapsed(&begin, &now);
+    double *latencies = malloc((nconn > 0 ? nconn : 1) * sizeof(double));
+    double sum = 0, sum2 = 0, bytes = 0;
+    for (size_t i = 0; i < nconn; i++) {
+        struct load_conn_t *c = &conns[i];
+        if (!c->done) {
+            // Timed out, or stopped
+            close(c->fd);
+            c->failed = true;
+        }
+        if (c->failed) {
+            report->errors++;
+        } else if (latencies != NULL) {
+            latencies[report->completed++] = c->latency;
+            sum += c->latency;
+            sum2 += c->latency * c->latency;
+            bytes += c->bytes;
+        }
+    }
+    if (report->completed > 0) {
+        qsort(latencies, report->completed, sizeof(double), compare_double);
+        report->latency_p50 = percentile(latencies, report->completed, 0.50);
+        report->latency_p90 = percentile(latencies, report->completed, 0.90);
+        report->latency_p99 = percentile(latencies, report->completed, 0.99);
+        report->latency_max = latencies[report->completed - 1];
+        report->fairness = (sum2 > 0 ? sum * sum / (report->completed * sum2) : 1);
+        report->throughput = (report->duration > 0 ? bytes / report->duration : 0);
+    }
+    free(latencies);
+    free(conns);
+    close(epfd);
+}
+
+int launch_test_load_client(struct cs_network_transactions *transactions, const char *host, const char *serv, int domain, int type, size_t nconn, int *client_in, int *client_out, int *cpid)
+{
+    int c2s[2], s2c[2];
+    PIPE_AND_FORK_BEGIN();
+    struct load_report_t report;
+    load_run(transactions, host, serv, domain, type, nconn, c2s[0], &report);
+    write(s2c[1], &report, sizeof(report));
+    // Without the handlers registered by the tests with atexit
+    _exit(0);
+    PIPE_AND_FORK_MIDDLE();
+    *cpid = pid;
+    *client_in = c2s[1];
+    *client_out = s2c[0];
+    return 0;
+    PIPE_AND_FORK_END();
+}
+
+int read_load_report(int client_out, struct load_report_t *report)
+{
+    size_t done = 0;
+    while (done < sizeof(*report)) {
+        ssize_t r = read(client_out, (char *)report + done, sizeof(*report) - done);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return -1;
+        }
+        done += r;
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 #define __CTESTER_UTIL_SOCKETS_H__
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  * Constants used when reporting the output of the mock server or client.
@@ -96,6 +97,43 @@ struct cs_network_chunk {
     int type;
 };
 
+/**
+ * Impairments of the link between the server/client and the remote end,
+ * during a transaction. The random choices are drawn from a generator
+ * seeded with seed, so that a failing test can be reproduced.
+ * The probabilities are in thousandths.
+ *
+ * With UDP, each SEND_CHUNK is a datagram, which may be dropped, duplicated,
+ * corrupted (one byte changed) or swapped with the next one of its burst
+ * (the SEND_CHUNK chunks following one another); it is then sent after
+ * a delay drawn uniformly in [delay_min, delay_max] ms, once the link
+ * (of rate bytes per second, unlimited if 0) has transmitted the previous
+ * ones, so that the delays may reorder the datagrams too. Before each
+ * RECV_CHUNK, a datagram may be received and ignored, with probability
+ * drop_recv, as if it had been lost: the server/client then waits for
+ * the same chunk again, which tests the retransmissions of the remote end.
+ *
+ * With TCP, which is reliable, only the delay and the rate apply: each
+ * SEND_CHUNK is delayed, then sent in pieces of rate / 10 bytes, one
+ * every 100 ms.
+ *
+ * With virtual_clock, the server/client never sleeps: the delays only
+ * decide the order in which the datagrams are sent, and the test runs
+ * at full speed.
+ */
+struct cs_network_impairment {
+    uint64_t seed;
+    unsigned delay_min; // In ms
+    unsigned delay_max; // In ms
+    unsigned rate; // In bytes per second, 0 for unlimited
+    unsigned drop; // Datagrams sent
+    unsigned drop_recv; // Datagrams received
+    unsigned duplicate;
+    unsigned reorder;
+    unsigned corrupt;
+    bool virtual_clock;
+};
+
 /**
  * A transaction, which is a list of chunks exchanged between the server/client
  * and the remote end.
@@ -107,6 +145,7 @@ struct cs_network_transaction {
     size_t nchunks;
     struct sockaddr *addr;
     socklen_t addrlen;
+    const struct cs_network_impairment *impairment; // NULL for a perfect link
 };
 
 /**
@@ -165,5 +204,45 @@ int launch_test_udp_server(struct cs_network_transactions *transactions, const c
  */
 int launch_test_udp_client(struct cs_network_transactions *transactions, const char *host, const char *serv, int domain, int *client_in, int *client_out, int *cpid);
 
+/**
+ * Results of a load client (see launch_test_load_client). The latencies
+ * are the durations of the transactions, from the connection to the end
+ * of the last chunk, in seconds; their percentiles are computed over
+ * the completed connections only.
+ */
+struct load_report_t {
+    size_t connections; // Connections opened
+    size_t completed; // Connections whose transaction succeeded
+    size_t errors; // Connections that failed (connection, transmission, data, timeout)
+    double duration; // From the first connection to the end of the last one, in seconds
+    double throughput; // Bytes of the completed transactions per second
+    double latency_p50;
+    double latency_p90;
+    double latency_p99;
+    double latency_max;
+    double fairness; // Jain's index of the latencies, 1 if all the connections were served alike
+};
+
+#define LOAD_TIMEOUT 10 // Seconds after which the connections not completed fail
+
+/**
+ * Launches a load client in a separate process, opening nconn connections
+ * at once to host host on port serv, of type SOCK_STREAM or SOCK_DGRAM
+ * (a connected UDP socket, each chunk being a datagram). The connection i
+ * plays the transaction i % ntransactions; they are all driven by a single
+ * epoll loop, so that the server must serve them concurrently.
+ * client_in, client_out and cpid are as with launch_test_tcp_client: writing
+ * to client_in stops the client, and the client writes a load_report_t
+ * to client_out at the end, to be read with read_load_report.
+ * Returns 0 on successful launch of the client, 1 otherwise.
+ */
+int launch_test_load_client(struct cs_network_transactions *transactions, const char *host, const char *serv, int domain, int type, size_t nconn, int *client_in, int *client_out, int *cpid);
+
+/**
+ * Reads the report of a load client from client_out, waiting for its end.
+ * Returns 0 on success, -1 if the client exited without a report.
+ */
+int read_load_report(int client_out, struct load_report_t *report);
+
 #endif // __CTESTER_UTIL_SOCKETS_H__
 
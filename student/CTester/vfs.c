@@ -0,0 +1,460 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "vfs.h"
+#include "fd_table.h"
+
+int __real_open(const char *pathname, int flags, mode_t mode);
+int __real_close(int fd);
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+/**
+ * A file of the VFS. Its contents are allocated with the real malloc,
+ * so that they are not counted in the memory used by the student.
+ * A removed file (linked is false) is freed when its last descriptor is closed.
+ */
+struct vfs_file_t {
+    bool used; // The slot holds a file
+    bool linked; // The file can be found by its path
+    char path[VFS_PATH_MAX];
+    char *data;
+    size_t size;
+    size_t capacity; // Size of data
+    mode_t mode;
+    int open_errno; // errno of open, creat and stat, if not 0
+    size_t max_size; // 0 if there is no limit
+    unsigned int refs; // Number of descriptors opened on the file
+};
+
+struct vfs_fd_t {
+    struct vfs_file_t *file; // NULL if the descriptor isn't used by the VFS
+    int flags;
+    off_t offset;
+};
+
+static bool vfs_on = false;
+static struct vfs_file_t files[VFS_FILES_MAX];
+static struct vfs_file_t snapshot[VFS_FILES_MAX];
+static struct vfs_fd_t fds[VFS_FD_MAX];
+
+void set_vfs(bool enabled)
+{
+    vfs_on = enabled;
+}
+
+bool vfs_enabled(void)
+{
+    return vfs_on;
+}
+
+static struct vfs_file_t *vfs_lookup(const char *path)
+{
+    for (int i = 0; i < VFS_FILES_MAX; i++) {
+        if (files[i].used && files[i].linked && strcmp(files[i].path, path) == 0) {
+            return &files[i];
+        }
+    }
+    return NULL;
+}
+
+static void vfs_free_file(struct vfs_file_t *f)
+{
+    __real_free(f->data);
+    memset(f, 0, sizeof(*f));
+}
+
+/*
+ * Returns a new empty file, or NULL with errno set.
+ */
+static struct vfs_file_t *vfs_new_file(const char *path, mode_t mode)
+{
+    if (strlen(path) >= VFS_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    for (int i = 0; i < VFS_FILES_MAX; i++) {
+        if (!files[i].used) {
+            struct vfs_file_t *f = &files[i];
+            f->used = true;
+            f->linked = true;
+            strcpy(f->path, path);
+            f->mode = mode & 0777;
+            return f;
+        }
+    }
+    errno = ENOSPC;
+    return NULL;
+}
+
+/*
+ * Makes room for size bytes in f. Returns 0 on success, -1 with errno set.
+ */
+static int vfs_reserve(struct vfs_file_t *f, size_t size)
+{
+    if (size <= f->capacity) {
+        return 0;
+    }
+    size_t capacity = (f->capacity < 64 ? 64 : f->capacity);
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    char *data = __real_realloc(f->data, capacity);
+    if (data == NULL) {
+        errno = ENOSPC;
+        return -1;
+    }
+    f->data = data;
+    f->capacity = capacity;
+    return 0;
+}
+
+static int vfs_set_contents(struct vfs_file_t *f, const void *data, size_t len)
+{
+    if (vfs_reserve(f, len) < 0) {
+        return -1;
+    }
+    if (len > 0) {
+        memcpy(f->data, data, len);
+    }
+    f->size = len;
+    return 0;
+}
+
+int vfs_create(const char *path, const void *data, size_t len, mode_t mode)
+{
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f == NULL) {
+        f = vfs_new_file(path, mode);
+        if (f == NULL) {
+            return -1;
+        }
+    }
+    f->mode = mode & 0777;
+    f->open_errno = 0;
+    f->max_size = 0;
+    return vfs_set_contents(f, data, len);
+}
+
+const char *vfs_contents(const char *path, size_t *len)
+{
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f == NULL) {
+        return NULL;
+    }
+    if (len != NULL) {
+        *len = f->size;
+    }
+    // Never NULL for an existing file, even if it is empty
+    return (f->data != NULL ? f->data : "");
+}
+
+int vfs_remove(const char *path)
+{
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (f->refs == 0) {
+        vfs_free_file(f);
+    } else {
+        f->linked = false;
+    }
+    return 0;
+}
+
+int vfs_set_errno(const char *path, int err)
+{
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    f->open_errno = err;
+    return 0;
+}
+
+int vfs_set_max_size(const char *path, size_t max)
+{
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f == NULL) {
+        errno = ENOENT;
+        return -1;
+    }
+    f->max_size = max;
+    return 0;
+}
+
+/*
+ * Copies the files of src into dst, which must be empty.
+ */
+static void vfs_copy(struct vfs_file_t *dst, const struct vfs_file_t *src)
+{
+    for (int i = 0; i < VFS_FILES_MAX; i++) {
+        if (!src[i].used || !src[i].linked) {
+            continue;
+        }
+        dst[i] = src[i];
+        dst[i].data = NULL;
+        dst[i].capacity = 0;
+        dst[i].refs = 0;
+        if (vfs_set_contents(&dst[i], src[i].data, src[i].size) < 0) {
+            memset(&dst[i], 0, sizeof(dst[i]));
+        }
+    }
+}
+
+void vfs_snapshot(void)
+{
+    for (int i = 0; i < VFS_FILES_MAX; i++) {
+        if (snapshot[i].used) {
+            vfs_free_file(&snapshot[i]);
+        }
+    }
+    vfs_copy(snapshot, files);
+}
+
+void vfs_restore(void)
+{
+    for (int fd = 0; fd < VFS_FD_MAX; fd++) {
+        if (fds[fd].file != NULL) {
+            vfs_close(fd);
+            fd_closed(fd);
+        }
+    }
+    for (int i = 0; i < VFS_FILES_MAX; i++) {
+        if (files[i].used) {
+            vfs_free_file(&files[i]);
+        }
+    }
+    vfs_copy(files, snapshot);
+}
+
+void vfs_reset(void)
+{
+    vfs_restore();
+}
+
+bool vfs_owns(int fd)
+{
+    return fd >= 0 && fd < VFS_FD_MAX && fds[fd].file != NULL;
+}
+
+/*
+ * Checks the permissions of the owner of f for the access mode acc.
+ */
+static bool vfs_allowed(const struct vfs_file_t *f, int acc)
+{
+    if ((acc == O_RDONLY || acc == O_RDWR) && !(f->mode & S_IRUSR)) {
+        return false;
+    }
+    if ((acc == O_WRONLY || acc == O_RDWR) && !(f->mode & S_IWUSR)) {
+        return false;
+    }
+    return true;
+}
+
+int vfs_open(const char *path, int flags, mode_t mode)
+{
+    if (path[0] == '\0') {
+        errno = ENOENT;
+        return -1;
+    }
+    if (strlen(path) >= VFS_PATH_MAX) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int acc = flags & O_ACCMODE;
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f != NULL) {
+        if (f->open_errno != 0) {
+            errno = f->open_errno;
+            return -1;
+        }
+        if ((flags & O_CREAT) && (flags & O_EXCL)) {
+            errno = EEXIST;
+            return -1;
+        }
+        if (flags & O_DIRECTORY) {
+            errno = ENOTDIR;
+            return -1;
+        }
+        if (!vfs_allowed(f, acc)) {
+            errno = EACCES;
+            return -1;
+        }
+    } else if (!(flags & O_CREAT)) {
+        errno = ENOENT;
+        return -1;
+    }
+    // Reserve a descriptor number before creating the file
+    int fd = __real_open("/dev/null", O_RDWR, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fd >= VFS_FD_MAX) {
+        __real_close(fd);
+        errno = EMFILE;
+        return -1;
+    }
+    if (f == NULL) {
+        // A new file can be opened for writing, whatever its permissions
+        f = vfs_new_file(path, mode);
+        if (f == NULL) {
+            int err = errno;
+            __real_close(fd);
+            errno = err;
+            return -1;
+        }
+    } else if ((flags & O_TRUNC) && acc != O_RDONLY) {
+        f->size = 0;
+    }
+    f->refs++;
+    fds[fd] = (struct vfs_fd_t) {
+        .file = f,
+        .flags = flags,
+        .offset = 0
+    };
+    return fd;
+}
+
+int vfs_close(int fd)
+{
+    if (!vfs_owns(fd)) {
+        errno = EBADF;
+        return -1;
+    }
+    struct vfs_file_t *f = fds[fd].file;
+    fds[fd].file = NULL;
+    if (--f->refs == 0 && !f->linked) {
+        vfs_free_file(f);
+    }
+    return __real_close(fd);
+}
+
+ssize_t vfs_read(int fd, void *buf, size_t count)
+{
+    if (!vfs_owns(fd) || (fds[fd].flags & O_ACCMODE) == O_WRONLY) {
+        errno = EBADF;
+        return -1;
+    }
+    struct vfs_fd_t *d = &fds[fd];
+    if ((size_t)d->offset >= d->file->size) {
+        return 0;
+    }
+    size_t n = d->file->size - d->offset;
+    if (n > count) {
+        n = count;
+    }
+    memcpy(buf, d->file->data + d->offset, n);
+    d->offset += n;
+    return n;
+}
+
+ssize_t vfs_write(int fd, const void *buf, size_t count)
+{
+    if (!vfs_owns(fd) || (fds[fd].flags & O_ACCMODE) == O_RDONLY) {
+        errno = EBADF;
+        return -1;
+    }
+    struct vfs_fd_t *d = &fds[fd];
+    struct vfs_file_t *f = d->file;
+    if (d->flags & O_APPEND) {
+        d->offset = f->size;
+    }
+    size_t offset = d->offset;
+    if (f->max_size != 0 && offset + count > f->max_size) {
+        if (offset >= f->max_size) {
+            errno = ENOSPC;
+            return -1;
+        }
+        count = f->max_size - offset;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (vfs_reserve(f, offset + count) < 0) {
+        return -1;
+    }
+    if (offset > f->size) {
+        // Writing after the end leaves a hole, read as zeros
+        memset(f->data + f->size, 0, offset - f->size);
+    }
+    memcpy(f->data + offset, buf, count);
+    if (offset + count > f->size) {
+        f->size = offset + count;
+    }
+    d->offset += count;
+    return count;
+}
+
+off_t vfs_lseek(int fd, off_t offset, int whence)
+{
+    if (!vfs_owns(fd)) {
+        errno = EBADF;
+        return -1;
+    }
+    struct vfs_fd_t *d = &fds[fd];
+    off_t base;
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = d->offset;
+            break;
+        case SEEK_END:
+            base = d->file->size;
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    if (base + offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (d->offset = base + offset);
+}
+
+static void vfs_fill_stat(const struct vfs_file_t *f, struct stat *buf)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_ino = f - files + 1;
+    buf->st_mode = S_IFREG | f->mode;
+    buf->st_nlink = (f->linked ? 1 : 0);
+    buf->st_uid = getuid();
+    buf->st_gid = getgid();
+    buf->st_size = f->size;
+    buf->st_blksize = 4096;
+    buf->st_blocks = (f->size + 511) / 512;
+}
+
+int vfs_stat(const char *path, struct stat *buf)
+{
+    struct vfs_file_t *f = vfs_lookup(path);
+    if (f == NULL) {
+        errno = (strlen(path) >= VFS_PATH_MAX ? ENAMETOOLONG : ENOENT);
+        return -1;
+    }
+    if (f->open_errno != 0) {
+        errno = f->open_errno;
+        return -1;
+    }
+    vfs_fill_stat(f, buf);
+    return 0;
+}
+
+int vfs_fstat(int fd, struct stat *buf)
+{
+    if (!vfs_owns(fd)) {
+        errno = EBADF;
+        return -1;
+    }
+    vfs_fill_stat(fds[fd].file, buf);
+    return 0;
+}
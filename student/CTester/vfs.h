@@ -0,0 +1,104 @@
+#ifndef __CTESTER_VFS_H__
+#define __CTESTER_VFS_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/**
+ * In-memory file system, replacing the real one for the code running
+ * in the sandbox when it is enabled with set_vfs.
+ *
+ * The wrappers of open, creat, read, write, lseek, stat, fstat and close
+ * use it whether these calls are monitored or not: open, creat and stat
+ * only see the files of the VFS inside the sandbox, and the descriptors
+ * it returns are served by the VFS until they are closed.
+ * Each of these descriptors is a real descriptor opened on /dev/null,
+ * so that its number cannot be reused by the real file system.
+ *
+ * The tests populate the VFS with vfs_create and read the results back
+ * with vfs_contents, instead of creating files on the disk.
+ * The VFS is flat: a path is only a name, there are no directories.
+ */
+#define VFS_FILES_MAX 64 // Maximum number of files
+#define VFS_PATH_MAX 256 // Maximum length of a path, with the final '\0'
+#define VFS_FD_MAX 1024 // Descriptors above this one cannot be used by the VFS
+
+/**
+ * Enables or disables the VFS; it stays so for the following tests.
+ */
+void set_vfs(bool enabled);
+
+bool vfs_enabled(void);
+
+/**
+ * Creates the file path with the permissions mode (only the bits of the
+ * owner are checked), containing a copy of the len bytes of data
+ * (data may be NULL if len is 0). An existing file is replaced.
+ * Returns 0 on success, -1 with errno set on failure.
+ */
+int vfs_create(const char *path, const void *data, size_t len, mode_t mode);
+
+/**
+ * Returns the contents of the file path, and its size in *len if len isn't
+ * NULL, or NULL if the file doesn't exist. The contents are not terminated
+ * by a '\0', and are only valid until the next change to the file.
+ */
+const char *vfs_contents(const char *path, size_t *len);
+
+/**
+ * Removes the file path. The descriptors opened on it can still be used,
+ * as with unlink. Returns 0 on success, -1 if the file doesn't exist.
+ */
+int vfs_remove(const char *path);
+
+/**
+ * Makes open, creat and stat fail on the existing file path with errno
+ * set to err, or stops it if err is 0.
+ * Returns 0 on success, -1 if the file doesn't exist.
+ */
+int vfs_set_errno(const char *path, int err);
+
+/**
+ * Limits the size of the existing file path to max bytes (0 for no limit):
+ * the writes are short when they reach it, and fail with ENOSPC when
+ * nothing can be written. Returns 0 on success, -1 if the file doesn't exist.
+ */
+int vfs_set_max_size(const char *path, size_t max);
+
+/**
+ * Saves a copy of all the files, replacing the previous snapshot.
+ */
+void vfs_snapshot(void);
+
+/**
+ * Closes all the descriptors of the VFS, and restores the files of
+ * the last snapshot (there are no files if there is no snapshot).
+ */
+void vfs_restore(void);
+
+/**
+ * Same as vfs_restore. Called by start_test, so that each test starts
+ * with the files of the snapshot.
+ */
+void vfs_reset(void);
+
+/**
+ * Returns true if fd has been opened by the VFS.
+ */
+bool vfs_owns(int fd);
+
+/**
+ * Implementations of the system calls, for the wrappers; they behave as
+ * the real ones, with the same errno values.
+ */
+int vfs_open(const char *path, int flags, mode_t mode);
+int vfs_close(int fd);
+ssize_t vfs_read(int fd, void *buf, size_t count);
+ssize_t vfs_write(int fd, const void *buf, size_t count);
+off_t vfs_lseek(int fd, off_t offset, int whence);
+int vfs_stat(const char *path, struct stat *buf);
+int vfs_fstat(int fd, struct stat *buf);
+
+#endif // __CTESTER_VFS_H__
@@ -11,11 +11,17 @@
 #include "wrap_getpid.h"
 #include "wrap_file.h"
 #include "wrap_malloc.h"
+#include "wrap_mmap.h"
 #include "wrap_mutex.h"
 #include "wrap_network_dns.h"
 #include "wrap_network_socket.h"
 #include "wrap_network_inet.h"
 #include "wrap_sleep.h"
+#include "wrap_stdio.h"
+#include "wrap_string.h"
+
+#include "callsite.h"
+#include "fd_table.h"
 
 // Basic structures for system call wrapper
 // verifies whether the system call needs to be monitored. Each
@@ -33,10 +39,20 @@ struct wrap_monitor_t {
   bool stat;
   bool fstat;
   bool lseek;
+  bool pread;
+  bool pwrite;
+  bool readv;
+  bool writev;
+  bool sendfile;
+  bool splice;
   bool free;
   bool malloc;
   bool calloc;
   bool realloc;
+  bool mmap;
+  bool munmap;
+  bool msync;
+  bool mprotect;
   bool pthread_mutex_lock;
   bool pthread_mutex_trylock;
   bool pthread_mutex_unlock;
@@ -68,6 +84,28 @@ struct wrap_monitor_t {
   bool ntohs;
   bool htonl;
   bool ntohl;
+
+  bool fopen;
+  bool fclose;
+  bool fread;
+  bool fwrite;
+  bool fgets;
+  bool fputs;
+  bool fprintf;
+  bool fflush;
+  bool setvbuf;
+  bool printf;
+  bool puts;
+  bool fputc; // Also putc and putchar
+  bool fgetc; // Also getc
+
+  bool strlen;
+  bool strcpy;
+  bool strcat;
+  bool memcpy;
+  bool memmove;
+  bool memset;
+  bool strcmp;
 };
 
 #define MONITOR_ALL_RECV(m, v) do { \
@@ -82,6 +120,17 @@ struct wrap_monitor_t {
   m.ntohs = m.htons = m.ntohl = m.htonl = v; \
 } while (0);
 
+#define MONITOR_ALL_STDIO(m, v) do { \
+  m.fopen = m.fclose = m.fread = m.fwrite = m.fgets = v; \
+  m.fputs = m.fprintf = m.fflush = m.setvbuf = v; \
+  m.printf = m.puts = m.fputc = m.fgetc = v; \
+} while (0);
+
+#define MONITOR_ALL_STRING(m, v) do { \
+  m.strlen = m.strcpy = m.strcat = m.strcmp = v; \
+  m.memcpy = m.memmove = m.memset = v; \
+} while (0);
+
 #define MAX_LOG 1000
 
 // log for specific system calls
@@ -145,6 +194,30 @@ struct wrap_fail_t {
   int lseek_ret;
   int lseek_errno;
 
+  uint32_t pread;
+  int pread_ret;
+  int pread_errno;
+
+  uint32_t pwrite;
+  int pwrite_ret;
+  int pwrite_errno;
+
+  uint32_t readv;
+  int readv_ret;
+  int readv_errno;
+
+  uint32_t writev;
+  int writev_ret;
+  int writev_errno;
+
+  uint32_t sendfile;
+  int sendfile_ret;
+  int sendfile_errno;
+
+  uint32_t splice;
+  int splice_ret;
+  int splice_errno;
+
   uint32_t malloc;
   void *malloc_ret;
 
@@ -156,6 +229,22 @@ struct wrap_fail_t {
 
   uint32_t free;
 
+  uint32_t mmap;
+  void *mmap_ret;
+  int mmap_errno;
+
+  uint32_t munmap;
+  int munmap_ret;
+  int munmap_errno;
+
+  uint32_t msync;
+  int msync_ret;
+  int msync_errno;
+
+  uint32_t mprotect;
+  int mprotect_ret;
+  int mprotect_errno;
+
   uint32_t pthread_mutex_lock;
   int pthread_mutex_lock_ret;
   int pthread_mutex_lock_errno;
@@ -249,6 +338,60 @@ struct wrap_fail_t {
   int socket_errno;
 
   // byte-order functions (htonl...) cannot fail
+
+  uint32_t fopen;
+  FILE *fopen_ret;
+  int fopen_errno;
+
+  uint32_t fclose;
+  int fclose_ret;
+  int fclose_errno;
+
+  uint32_t fread;
+  size_t fread_ret;
+  int fread_errno;
+
+  uint32_t fwrite;
+  size_t fwrite_ret;
+  int fwrite_errno;
+
+  uint32_t fgets;
+  char *fgets_ret;
+  int fgets_errno;
+
+  uint32_t fputs;
+  int fputs_ret;
+  int fputs_errno;
+
+  uint32_t fprintf;
+  int fprintf_ret;
+  int fprintf_errno;
+
+  uint32_t fflush;
+  int fflush_ret;
+  int fflush_errno;
+
+  uint32_t setvbuf;
+  int setvbuf_ret;
+  int setvbuf_errno;
+
+  uint32_t printf;
+  int printf_ret;
+  int printf_errno;
+
+  uint32_t puts;
+  int puts_ret;
+  int puts_errno;
+
+  uint32_t fputc;
+  int fputc_ret;
+  int fputc_errno;
+
+  uint32_t fgetc;
+  int fgetc_ret;
+  int fgetc_errno;
+
+  // string functions (strlen...) cannot fail
 } ;
 
 
@@ -262,11 +405,23 @@ struct wrap_stats_t {
   struct stats_stat_t stat;
   struct stats_fstat_t fstat;
   struct stats_lseek_t lseek;
+  struct stats_pread_t pread;
+  struct stats_pwrite_t pwrite;
+  struct stats_readv_t readv;
+  struct stats_writev_t writev;
+  struct stats_sendfile_t sendfile;
+  struct stats_splice_t splice;
   struct stats_malloc_t malloc;
   struct stats_calloc_t calloc;
   struct stats_memory_t memory;
   struct stats_free_t free;
   struct stats_realloc_t realloc;
+  struct stats_mmap_t mmap;
+  struct stats_munmap_t munmap;
+  struct stats_msync_t msync;
+  struct stats_mprotect_t mprotect;
+  struct stats_mapping_t mapping;
+  struct stats_fd_t fd;
   struct stats_pthread_mutex_lock_t pthread_mutex_lock;
   struct stats_pthread_mutex_trylock_t pthread_mutex_trylock;
   struct stats_pthread_mutex_unlock_t pthread_mutex_unlock;
@@ -300,6 +455,29 @@ struct wrap_stats_t {
   struct stats_ntohs_t ntohs;
   struct stats_htonl_t htonl;
   struct stats_ntohl_t ntohl;
+
+  struct stats_fopen_t fopen;
+  struct stats_fclose_t fclose;
+  struct stats_fread_t fread;
+  struct stats_fwrite_t fwrite;
+  struct stats_fgets_t fgets;
+  struct stats_fputs_t fputs;
+  struct stats_fprintf_t fprintf;
+  struct stats_fflush_t fflush;
+  struct stats_setvbuf_t setvbuf;
+  struct stats_printf_t printf;
+  struct stats_puts_t puts;
+  struct stats_fputc_t fputc;
+  struct stats_fgetc_t fgetc;
+  struct stats_stdio_t stdio;
+
+  struct stats_strlen_t strlen;
+  struct stats_strcpy_t strcpy;
+  struct stats_strcat_t strcat;
+  struct stats_memcpy_t memcpy;
+  struct stats_memmove_t memmove;
+  struct stats_memset_t memset;
+  struct stats_strcmp_t strcmp;
 };
 
 #endif // __WRAP_H_
@@ -8,6 +8,8 @@
 
 #include "wrap.h"
 #include "read_write.h"
+#include "vfs.h"
+#include "simnet.h"
 
 int __real_open(const char *pathname, int flags, mode_t mode);
 int __real_creat(const char *pathname, mode_t mode);
@@ -20,6 +22,10 @@ int __real_lstat(const char* path, struct stat *buf);
 ssize_t __real_pread(int fd, void *buf, size_t count, off_t offset);
 ssize_t __real_pwrite(int fd, const void *buf, size_t count, off_t offset);
 off_t __real_lseek(int fd, off_t offset, int whence);
+ssize_t __real_readv(int fd, const struct iovec *iov, int iovcnt);
+ssize_t __real_writev(int fd, const struct iovec *iov, int iovcnt);
+ssize_t __real_sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+ssize_t __real_splice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags);
 
 extern bool wrap_monitoring;
 extern struct wrap_stats_t stats;
@@ -35,8 +41,263 @@ extern bool fd_is_read_buffered(int fd);
 
 extern ssize_t read_handle_buffer(int fd, void *buf, size_t len, int flags);
 
-extern struct read_fd_table_t read_fd_table;
 
+/**
+ * The system calls, served by the VFS when it is enabled (see vfs.h):
+ * the paths are looked up in the VFS inside the sandbox, and
+ * the descriptors it returned are always served by it.
+ * Likewise, the sockets of the simulated network are served by it (see simnet.h).
+ */
+static bool path_in_vfs() {
+  return wrap_monitoring && vfs_enabled();
+}
+
+static int file_open(const char *pathname, int flags, mode_t mode) {
+  if (path_in_vfs()) {
+    int fd = vfs_open(pathname, flags, mode);
+    fd_opened(fd, FD_TYPE_VFS, "open");
+    return fd;
+  }
+  int fd = __real_open(pathname, flags, mode);
+  fd_opened(fd, FD_TYPE_FILE, "open");
+  return fd;
+}
+
+static int file_creat(const char *pathname, mode_t mode) {
+  if (path_in_vfs()) {
+    int fd = vfs_open(pathname, O_CREAT|O_WRONLY|O_TRUNC, mode);
+    fd_opened(fd, FD_TYPE_VFS, "creat");
+    return fd;
+  }
+  int fd = __real_creat(pathname, mode);
+  fd_opened(fd, FD_TYPE_FILE, "creat");
+  return fd;
+}
+
+static int file_close(int fd) {
+  int ret;
+  if (vfs_owns(fd))
+    ret = vfs_close(fd);
+  else if (simnet_owns(fd))
+    ret = simnet_close(fd);
+  else
+    ret = __real_close(fd);
+  // The descriptor is released by any error other than EBADF
+  if (ret == 0 || errno != EBADF)
+    fd_closed(fd);
+  return ret;
+}
+
+static ssize_t file_read(int fd, void *buf, size_t count) {
+  if (vfs_owns(fd))
+    return vfs_read(fd, buf, count);
+  if (simnet_owns(fd)) {
+    struct iovec iov = { .iov_base = buf, .iov_len = count };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    return simnet_recvmsg(fd, &msg, 0);
+  }
+  return __real_read(fd, buf, count);
+}
+
+static ssize_t file_write(int fd, const void *buf, size_t count) {
+  if (vfs_owns(fd))
+    return vfs_write(fd, buf, count);
+  if (simnet_owns(fd)) {
+    struct iovec iov = { .iov_base = (void *)buf, .iov_len = count };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    return simnet_sendmsg(fd, &msg, 0);
+  }
+  return __real_write(fd, buf, count);
+}
+
+static int file_stat(const char *path, struct stat *buf) {
+  if (path_in_vfs())
+    return vfs_stat(path, buf);
+  return __real_stat(path, buf);
+}
+
+static int file_fstat(int fd, struct stat *buf) {
+  if (vfs_owns(fd))
+    return vfs_fstat(fd, buf);
+  return __real_fstat(fd, buf);
+}
+
+static off_t file_lseek(int fd, off_t offset, int whence) {
+  if (vfs_owns(fd))
+    return vfs_lseek(fd, offset, whence);
+  return __real_lseek(fd, offset, whence);
+}
+
+
+static ssize_t file_pread(int fd, void *buf, size_t count, off_t offset) {
+  if (vfs_owns(fd)) {
+    off_t cur = vfs_lseek(fd, 0, SEEK_CUR);
+    if (offset < 0 || vfs_lseek(fd, offset, SEEK_SET) < 0) {
+      errno = EINVAL;
+      return -1;
+    }
+    ssize_t ret = vfs_read(fd, buf, count);
+    vfs_lseek(fd, cur, SEEK_SET);
+    return ret;
+  }
+  return __real_pread(fd, buf, count, offset);
+}
+
+static ssize_t file_pwrite(int fd, const void *buf, size_t count, off_t offset) {
+  if (vfs_owns(fd)) {
+    off_t cur = vfs_lseek(fd, 0, SEEK_CUR);
+    if (offset < 0 || vfs_lseek(fd, offset, SEEK_SET) < 0) {
+      errno = EINVAL;
+      return -1;
+    }
+    ssize_t ret = vfs_write(fd, buf, count);
+    vfs_lseek(fd, cur, SEEK_SET);
+    return ret;
+  }
+  return __real_pwrite(fd, buf, count, offset);
+}
+
+static size_t iov_length(const struct iovec *iov, int iovcnt) {
+  size_t len = 0;
+  for (int i = 0; i < iovcnt; i++)
+    len += iov[i].iov_len;
+  return len;
+}
+
+static ssize_t file_readv(int fd, const struct iovec *iov, int iovcnt) {
+  if (vfs_owns(fd)) {
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+      ssize_t n = vfs_read(fd, iov[i].iov_base, iov[i].iov_len);
+      if (n < 0)
+        return (total > 0 ? total : -1);
+      total += n;
+      if ((size_t)n < iov[i].iov_len)
+        break;
+    }
+    return total;
+  }
+  if (simnet_owns(fd)) {
+    struct msghdr msg = { .msg_iov = (struct iovec *)iov, .msg_iovlen = iovcnt };
+    return simnet_recvmsg(fd, &msg, 0);
+  }
+  return __real_readv(fd, iov, iovcnt);
+}
+
+static ssize_t file_writev(int fd, const struct iovec *iov, int iovcnt) {
+  if (vfs_owns(fd)) {
+    ssize_t total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+      ssize_t n = vfs_write(fd, iov[i].iov_base, iov[i].iov_len);
+      if (n < 0)
+        return (total > 0 ? total : -1);
+      total += n;
+      if ((size_t)n < iov[i].iov_len)
+        break;
+    }
+    return total;
+  }
+  if (simnet_owns(fd)) {
+    struct msghdr msg = { .msg_iov = (struct iovec *)iov, .msg_iovlen = iovcnt };
+    return simnet_sendmsg(fd, &msg, 0);
+  }
+  return __real_writev(fd, iov, iovcnt);
+}
+
+// Reads up to len bytes of in_fd (at *offset if offset isn't NULL) in buf,
+// for bounce_copy. A read-buffered or simulated in_fd is only peeked if
+// peek is true, the bytes are then consumed by bounce_consume.
+static ssize_t bounce_read(int in_fd, off_t *offset, void *buf, size_t len, bool peek) {
+  int flags = (peek ? MSG_PEEK : 0);
+  if (fd_is_read_buffered(in_fd) || simnet_owns(in_fd)) {
+    if (offset != NULL) {
+      errno = ESPIPE;
+      return -1;
+    }
+    if (fd_is_read_buffered(in_fd))
+      return read_handle_buffer(in_fd, buf, len, flags);
+    struct iovec iov = { .iov_base = buf, .iov_len = len };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    return simnet_recvmsg(in_fd, &msg, flags);
+  }
+  if (offset != NULL)
+    return file_pread(in_fd, buf, len, *offset);
+  return file_read(in_fd, buf, len);
+}
+
+// Consumes the n first bytes peeked by bounce_read
+static void bounce_consume(int in_fd, void *buf, size_t n) {
+  if (fd_is_read_buffered(in_fd)) {
+    read_handle_buffer(in_fd, buf, n, MSG_WAITALL);
+  } else {
+    struct iovec iov = { .iov_base = buf, .iov_len = n };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    simnet_recvmsg(in_fd, &msg, 0);
+  }
+}
+
+// Copies up to count bytes from in_fd (at *offset if offset isn't NULL)
+// to out_fd through a buffer, for sendfile and splice. Only the bytes
+// written to out_fd are consumed from in_fd.
+static ssize_t bounce_copy(int out_fd, int in_fd, off_t *offset, size_t count) {
+  char bounce[FILE_BOUNCE_SIZE];
+  size_t len = (count < sizeof(bounce) ? count : sizeof(bounce));
+  ssize_t n;
+  if (fd_is_write_buffered(out_fd)) {
+    // Nothing is read before the write buffer tells how much it accepts
+    ssize_t room = write_reserve_buffer(out_fd, len, 0);
+    if (room <= 0)
+      return room;
+    n = bounce_read(in_fd, offset, bounce, room, false);
+    if (n <= 0)
+      return n;
+    struct iovec iov = { .iov_base = bounce, .iov_len = n };
+    write_commit_buffer(out_fd, &iov, 1, n);
+    if (offset != NULL)
+      *offset += n;
+    return n;
+  }
+  bool peek = (fd_is_read_buffered(in_fd) || simnet_owns(in_fd));
+  n = bounce_read(in_fd, offset, bounce, len, peek);
+  if (n <= 0)
+    return n;
+  ssize_t w = file_write(out_fd, bounce, n);
+  if (peek && w > 0)
+    bounce_consume(in_fd, bounce, w);
+  if (w < 0)
+    return -1;
+  if (offset != NULL)
+    *offset += w;
+  else if (w < n && !peek)
+    file_lseek(in_fd, w - n, SEEK_CUR); // give back what couldn't be written
+  return w;
+}
+
+static bool needs_bounce(int in_fd, int out_fd) {
+  return fd_is_read_buffered(in_fd) || fd_is_write_buffered(out_fd) || vfs_owns(in_fd) || vfs_owns(out_fd)
+    || simnet_owns(in_fd) || simnet_owns(out_fd);
+}
+
+static ssize_t file_sendfile(int out_fd, int in_fd, off_t *offset, size_t count) {
+  if (needs_bounce(in_fd, out_fd))
+    return bounce_copy(out_fd, in_fd, offset, count);
+  return __real_sendfile(out_fd, in_fd, offset, count);
+}
+
+static ssize_t file_splice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags) {
+  if (needs_bounce(fd_in, fd_out)) {
+    if (off_out != NULL) {
+      errno = EINVAL;
+      return -1;
+    }
+    off_t offset = (off_in != NULL ? *off_in : 0);
+    ssize_t ret = bounce_copy(fd_out, fd_in, (off_in != NULL ? &offset : NULL), len);
+    if (off_in != NULL)
+      *off_in = offset;
+    return ret;
+  }
+  return __real_splice(fd_in, off_in, fd_out, off_out, len, flags);
+}
 
 /**
  * Wrap functions.
@@ -45,14 +306,16 @@ extern struct read_fd_table_t read_fd_table;
 int __wrap_open(char *pathname, int flags, mode_t mode) {
 
   if(!wrap_monitoring || !monitored.open) {
-    return __real_open(pathname,flags,mode); 
+    return file_open(pathname,flags,mode); 
   }
   stats.open.called++;
+  struct callsite_t *callsite = CALLSITE("open");
   stats.open.last_params.pathname=pathname;
   stats.open.last_params.flags=flags;
   stats.open.last_params.mode=mode;
   
   if (FAIL(failures.open)) {
+    callsite_failed(callsite);
     failures.open=NEXT(failures.open);
     errno=failures.open_errno;
     stats.open.last_return=failures.open_ret;
@@ -60,7 +323,7 @@ int __wrap_open(char *pathname, int flags, mode_t mode) {
   }
   failures.open=NEXT(failures.open);
   // did not fail
-  int ret=__real_open(pathname, flags, mode);
+  int ret=file_open(pathname, flags, mode);
   stats.open.last_return=ret;
   return ret;
 
@@ -70,13 +333,15 @@ int __wrap_creat(char *pathname, mode_t mode) {
 
 
   if(!wrap_monitoring || !monitored.creat) {
-    return __real_creat(pathname,mode); 
+    return file_creat(pathname,mode); 
   }
   stats.creat.called++;
+  struct callsite_t *callsite = CALLSITE("creat");
   stats.creat.last_params.pathname=pathname;
   stats.creat.last_params.mode=mode;
   
   if (FAIL(failures.creat)) {
+    callsite_failed(callsite);
     failures.creat=NEXT(failures.creat);
     errno=failures.creat_errno;
     stats.creat.last_return=failures.creat_ret;
@@ -84,7 +349,7 @@ int __wrap_creat(char *pathname, mode_t mode) {
   }
   failures.creat=NEXT(failures.creat);
   // did not fail
-  int ret=__real_creat(pathname, mode);
+  int ret=file_creat(pathname, mode);
   stats.creat.last_return=ret;
   return ret;
 
@@ -93,12 +358,14 @@ int __wrap_creat(char *pathname, mode_t mode) {
 int __wrap_close(int fd){
 
   if(!wrap_monitoring || !monitored.close) {
-    return __real_close(fd); 
+    return file_close(fd); 
   }
   stats.close.called++;
+  struct callsite_t *callsite = CALLSITE("close");
   stats.close.last_params.fd=fd;
   
   if (FAIL(failures.close)) {
+    callsite_failed(callsite);
     failures.close=NEXT(failures.close);
     errno=failures.close_errno;
     stats.close.last_return=failures.close_ret;
@@ -106,7 +373,7 @@ int __wrap_close(int fd){
   }
   failures.close=NEXT(failures.close);
   // did not fail
-  int ret=__real_close(fd);
+  int ret=file_close(fd);
   stats.close.last_return=ret;
   return ret;
 
@@ -115,14 +382,16 @@ int __wrap_close(int fd){
 ssize_t __wrap_read(int fd, void *buf, size_t count){
 
   if(!wrap_monitoring || !monitored.read) {
-    return __real_read(fd,buf,count); 
+    return file_read(fd,buf,count); 
   }
   stats.read.called++;
+  struct callsite_t *callsite = CALLSITE("read");
   stats.read.last_params.fd=fd;
   stats.read.last_params.buf=buf;
   stats.read.last_params.count=count;
   
   if (FAIL(failures.read)) {
+    callsite_failed(callsite);
     failures.read=NEXT(failures.read);
     errno=failures.read_errno;
     stats.read.last_return=failures.read_ret;
@@ -134,9 +403,11 @@ ssize_t __wrap_read(int fd, void *buf, size_t count){
   if (fd_is_read_buffered(fd)) {
     ret = read_handle_buffer(fd, buf, count, 0);
   } else {
-    ret = __real_read(fd, buf, count);
+    ret = file_read(fd, buf, count);
   }
   stats.read.last_return=ret;
+  io_stats_add(&stats.read.io, count, ret);
+  callsite_bytes(callsite, ret);
   return ret;
 
 }
@@ -145,14 +416,16 @@ ssize_t __wrap_read(int fd, void *buf, size_t count){
 ssize_t __wrap_write(int fd, void *buf, size_t count){
 
   if(!wrap_monitoring || !monitored.write) {
-    return __real_write(fd,buf,count); 
+    return file_write(fd,buf,count); 
   }
   stats.write.called++;
+  struct callsite_t *callsite = CALLSITE("write");
   stats.write.last_params.fd=fd;
   stats.write.last_params.buf=buf;
   stats.write.last_params.count=count;
   
   if (FAIL(failures.write)) {
+    callsite_failed(callsite);
     failures.write=NEXT(failures.write);
     errno=failures.write_errno;
     stats.write.last_return=failures.write_ret;
@@ -160,8 +433,16 @@ ssize_t __wrap_write(int fd, void *buf, size_t count){
   }
   failures.write=NEXT(failures.write);
   // did not fail
-  int ret=__real_write(fd,buf,count);
+  int ret = 0;
+  if (fd_is_write_buffered(fd)) {
+    struct iovec iov = { .iov_base = buf, .iov_len = count };
+    ret = write_handle_buffer(fd, &iov, 1, 0);
+  } else {
+    ret = file_write(fd, buf, count);
+  }
   stats.write.last_return=ret;
+  io_stats_add(&stats.write.io, count, ret);
+  callsite_bytes(callsite, ret);
   return ret;
 
 }
@@ -169,13 +450,15 @@ ssize_t __wrap_write(int fd, void *buf, size_t count){
 int __wrap_stat(char *path, struct stat *buf) {
   
   if(!wrap_monitoring || !monitored.stat) {
-return __real_stat(path,buf); 
+return file_stat(path,buf); 
   }
   stats.stat.called++;
+  struct callsite_t *callsite = CALLSITE("stat");
   stats.stat.last_params.path=path;
   stats.stat.last_params.buf=buf;
   
   if (FAIL(failures.stat)) {
+    callsite_failed(callsite);
     failures.stat=NEXT(failures.stat);
     errno=failures.stat_errno;
     stats.stat.last_return=failures.stat_ret;
@@ -183,7 +466,7 @@ return __real_stat(path,buf);
   }
   failures.stat=NEXT(failures.stat);
   // did not fail
-  int ret=__real_stat(path,buf);
+  int ret=file_stat(path,buf);
   stats.stat.returned_stat.st_dev=buf->st_dev;
   stats.stat.returned_stat.st_ino=buf->st_ino;
   stats.stat.returned_stat.st_mode=buf->st_mode;
@@ -205,20 +488,22 @@ return __real_stat(path,buf);
 int __wrap_fstat(int fd, struct stat *buf) {
 
   if(!wrap_monitoring || !monitored.fstat) {
-    return __real_fstat(fd,buf);
+    return file_fstat(fd,buf);
   }
   stats.fstat.called++;
+  struct callsite_t *callsite = CALLSITE("fstat");
   stats.fstat.last_params.fd=fd;
   stats.fstat.last_params.buf=buf;
   
   if (FAIL(failures.fstat)) {
+    callsite_failed(callsite);
     failures.fstat=NEXT(failures.fstat);
     errno=failures.fstat_errno;
     return failures.fstat_ret;
   }
   failures.fstat=NEXT(failures.fstat);
   // did not fail
-  int ret=__real_fstat(fd,buf);
+  int ret=file_fstat(fd,buf);
   stats.fstat.returned_stat.st_dev=buf->st_dev;
   stats.fstat.returned_stat.st_ino=buf->st_ino;
   stats.fstat.returned_stat.st_mode=buf->st_mode;
@@ -241,25 +526,217 @@ int __wrap_fstat(int fd, struct stat *buf) {
 off_t __wrap_lseek(int fd, off_t offset, int whence) {
   
   if(!wrap_monitoring || !monitored.lseek) {
-    return __real_lseek(fd,offset,whence);
+    return file_lseek(fd,offset,whence);
   }
   stats.lseek.called++;
+  struct callsite_t *callsite = CALLSITE("lseek");
   stats.lseek.last_params.fd=fd;
   stats.lseek.last_params.offset=offset;
   stats.lseek.last_params.whence=whence;
 
   if (FAIL(failures.lseek)) {
+    callsite_failed(callsite);
     failures.lseek=NEXT(failures.lseek);
     errno=failures.lseek_errno;
     return failures.lseek_ret;
   }
   failures.lseek=NEXT(failures.lseek);
   // did not fail
-  off_t ret=__real_lseek(fd,offset,whence);
+  off_t ret=file_lseek(fd,offset,whence);
   stats.lseek.last_return=ret;
   return ret;
 }
 
+ssize_t __wrap_pread(int fd, void *buf, size_t count, off_t offset){
+
+  if(!wrap_monitoring || !monitored.pread) {
+    return file_pread(fd,buf,count,offset);
+  }
+  stats.pread.called++;
+  struct callsite_t *callsite = CALLSITE("pread");
+  stats.pread.last_params.fd=fd;
+  stats.pread.last_params.buf=buf;
+  stats.pread.last_params.count=count;
+  stats.pread.last_params.offset=offset;
+
+  if (FAIL(failures.pread)) {
+    callsite_failed(callsite);
+    failures.pread=NEXT(failures.pread);
+    errno=failures.pread_errno;
+    stats.pread.last_return=failures.pread_ret;
+    return failures.pread_ret;
+  }
+  failures.pread=NEXT(failures.pread);
+  // did not fail
+  ssize_t ret;
+  if (fd_is_read_buffered(fd)) {
+    // read buffers stand for pipes and sockets, which cannot seek
+    errno = ESPIPE;
+    ret = -1;
+  } else {
+    ret = file_pread(fd, buf, count, offset);
+  }
+  stats.pread.last_return=ret;
+  io_stats_add(&stats.pread.io, count, ret);
+  callsite_bytes(callsite, ret);
+  return ret;
+
+}
+
+ssize_t __wrap_pwrite(int fd, const void *buf, size_t count, off_t offset){
+
+  if(!wrap_monitoring || !monitored.pwrite) {
+    return file_pwrite(fd,buf,count,offset);
+  }
+  stats.pwrite.called++;
+  struct callsite_t *callsite = CALLSITE("pwrite");
+  stats.pwrite.last_params.fd=fd;
+  stats.pwrite.last_params.buf=buf;
+  stats.pwrite.last_params.count=count;
+  stats.pwrite.last_params.offset=offset;
+
+  if (FAIL(failures.pwrite)) {
+    callsite_failed(callsite);
+    failures.pwrite=NEXT(failures.pwrite);
+    errno=failures.pwrite_errno;
+    stats.pwrite.last_return=failures.pwrite_ret;
+    return failures.pwrite_ret;
+  }
+  failures.pwrite=NEXT(failures.pwrite);
+  // did not fail
+  ssize_t ret=file_pwrite(fd,buf,count,offset);
+  stats.pwrite.last_return=ret;
+  io_stats_add(&stats.pwrite.io, count, ret);
+  callsite_bytes(callsite, ret);
+  return ret;
+
+}
+
+ssize_t __wrap_readv(int fd, const struct iovec *iov, int iovcnt){
+
+  if(!wrap_monitoring || !monitored.readv) {
+    return file_readv(fd,iov,iovcnt);
+  }
+  stats.readv.called++;
+  struct callsite_t *callsite = CALLSITE("readv");
+  stats.readv.last_params.fd=fd;
+  stats.readv.last_params.iov=iov;
+  stats.readv.last_params.iovcnt=iovcnt;
+
+  if (FAIL(failures.readv)) {
+    callsite_failed(callsite);
+    failures.readv=NEXT(failures.readv);
+    errno=failures.readv_errno;
+    stats.readv.last_return=failures.readv_ret;
+    return failures.readv_ret;
+  }
+  failures.readv=NEXT(failures.readv);
+  // did not fail
+  ssize_t ret;
+  if (fd_is_read_buffered(fd)) {
+    ret = read_handle_buffer_iov(fd, iov, iovcnt, 0);
+  } else {
+    ret = file_readv(fd, iov, iovcnt);
+  }
+  stats.readv.last_return=ret;
+  io_stats_add(&stats.readv.io, iov_length(iov, iovcnt), ret);
+  callsite_bytes(callsite, ret);
+  return ret;
+
+}
+
+ssize_t __wrap_writev(int fd, const struct iovec *iov, int iovcnt){
+
+  if(!wrap_monitoring || !monitored.writev) {
+    return file_writev(fd,iov,iovcnt);
+  }
+  stats.writev.called++;
+  struct callsite_t *callsite = CALLSITE("writev");
+  stats.writev.last_params.fd=fd;
+  stats.writev.last_params.iov=iov;
+  stats.writev.last_params.iovcnt=iovcnt;
+
+  if (FAIL(failures.writev)) {
+    callsite_failed(callsite);
+    failures.writev=NEXT(failures.writev);
+    errno=failures.writev_errno;
+    stats.writev.last_return=failures.writev_ret;
+    return failures.writev_ret;
+  }
+  failures.writev=NEXT(failures.writev);
+  // did not fail
+  ssize_t ret;
+  if (fd_is_write_buffered(fd))
+    ret = write_handle_buffer(fd, iov, iovcnt, 0);
+  else
+    ret = file_writev(fd, iov, iovcnt);
+  stats.writev.last_return=ret;
+  io_stats_add(&stats.writev.io, iov_length(iov, iovcnt), ret);
+  callsite_bytes(callsite, ret);
+  return ret;
+
+}
+
+ssize_t __wrap_sendfile(int out_fd, int in_fd, off_t *offset, size_t count){
+
+  if(!wrap_monitoring || !monitored.sendfile) {
+    return file_sendfile(out_fd,in_fd,offset,count);
+  }
+  stats.sendfile.called++;
+  struct callsite_t *callsite = CALLSITE("sendfile");
+  stats.sendfile.last_params.out_fd=out_fd;
+  stats.sendfile.last_params.in_fd=in_fd;
+  stats.sendfile.last_params.offset=offset;
+  stats.sendfile.last_params.count=count;
+
+  if (FAIL(failures.sendfile)) {
+    callsite_failed(callsite);
+    failures.sendfile=NEXT(failures.sendfile);
+    errno=failures.sendfile_errno;
+    stats.sendfile.last_return=failures.sendfile_ret;
+    return failures.sendfile_ret;
+  }
+  failures.sendfile=NEXT(failures.sendfile);
+  // did not fail
+  ssize_t ret=file_sendfile(out_fd,in_fd,offset,count);
+  stats.sendfile.last_return=ret;
+  io_stats_add(&stats.sendfile.io, count, ret);
+  callsite_bytes(callsite, ret);
+  return ret;
+
+}
+
+ssize_t __wrap_splice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t len, unsigned int flags){
+
+  if(!wrap_monitoring || !monitored.splice) {
+    return file_splice(fd_in,off_in,fd_out,off_out,len,flags);
+  }
+  stats.splice.called++;
+  struct callsite_t *callsite = CALLSITE("splice");
+  stats.splice.last_params.fd_in=fd_in;
+  stats.splice.last_params.off_in=off_in;
+  stats.splice.last_params.fd_out=fd_out;
+  stats.splice.last_params.off_out=off_out;
+  stats.splice.last_params.len=len;
+  stats.splice.last_params.flags=flags;
+
+  if (FAIL(failures.splice)) {
+    callsite_failed(callsite);
+    failures.splice=NEXT(failures.splice);
+    errno=failures.splice_errno;
+    stats.splice.last_return=failures.splice_ret;
+    return failures.splice_ret;
+  }
+  failures.splice=NEXT(failures.splice);
+  // did not fail
+  ssize_t ret=file_splice(fd_in,off_in,fd_out,off_out,len,flags);
+  stats.splice.last_return=ret;
+  io_stats_add(&stats.splice.io, len, ret);
+  callsite_bytes(callsite, ret);
+  return ret;
+
+}
+
 void reinit_file_stats()
 {
   memset(&(stats.open), 0, sizeof(stats.open));
@@ -270,5 +747,11 @@ void reinit_file_stats()
   memset(&(stats.stat), 0, sizeof(stats.stat));
   memset(&(stats.fstat), 0, sizeof(stats.fstat));
   memset(&(stats.lseek), 0, sizeof(stats.lseek));
+  memset(&(stats.pread), 0, sizeof(stats.pread));
+  memset(&(stats.pwrite), 0, sizeof(stats.pwrite));
+  memset(&(stats.readv), 0, sizeof(stats.readv));
+  memset(&(stats.writev), 0, sizeof(stats.writev));
+  memset(&(stats.sendfile), 0, sizeof(stats.sendfile));
+  memset(&(stats.splice), 0, sizeof(stats.splice));
 }
 
@@ -5,6 +5,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/uio.h>
+
+#include "util_histogram.h"
 
 // TODO fcntl
 // basic structure to record the parameters of the last open call
@@ -63,6 +66,7 @@ struct stats_read_t {
   int called;  // number of times the read system call has been issued
   struct params_read_t last_params; // parameters for the last call issued
   ssize_t last_return;   // return value of the last read call issued
+  struct stats_io_t io;  // bytes read by the successful calls
 };
 
 struct params_write_t {
@@ -77,6 +81,7 @@ struct stats_write_t {
   int called;  // number of times the write system call has been issued
   struct params_read_t last_params; // parameters for the last call issued
   ssize_t last_return;   // return value of the last write call issued
+  struct stats_io_t io;  // bytes written by the successful calls
 };
 
 struct params_stat_t {
@@ -123,6 +128,113 @@ struct stats_lseek_t {
   int last_return;   // return value of the last lseek call issued
 };
 
+struct params_pread_t {
+  int fd;
+  void *buf;
+  size_t count;
+  off_t offset;
+};
+
+// basic statistics for the utilisation of the pread system call
+
+struct stats_pread_t {
+  int called;  // number of times the pread system call has been issued
+  struct params_pread_t last_params; // parameters for the last call issued
+  ssize_t last_return;   // return value of the last pread call issued
+  struct stats_io_t io;  // bytes read by the successful calls
+};
+
+
+struct params_pwrite_t {
+  int fd;
+  const void *buf;
+  size_t count;
+  off_t offset;
+};
+
+// basic statistics for the utilisation of the pwrite system call
+
+struct stats_pwrite_t {
+  int called;  // number of times the pwrite system call has been issued
+  struct params_pwrite_t last_params; // parameters for the last call issued
+  ssize_t last_return;   // return value of the last pwrite call issued
+  struct stats_io_t io;  // bytes written by the successful calls
+};
+
+
+struct params_readv_t {
+  int fd;
+  const struct iovec *iov;
+  int iovcnt;
+};
+
+// basic statistics for the utilisation of the readv system call
+
+struct stats_readv_t {
+  int called;  // number of times the readv system call has been issued
+  struct params_readv_t last_params; // parameters for the last call issued
+  ssize_t last_return;   // return value of the last readv call issued
+  struct stats_io_t io;  // bytes read by the successful calls
+};
+
+
+struct params_writev_t {
+  int fd;
+  const struct iovec *iov;
+  int iovcnt;
+};
+
+// basic statistics for the utilisation of the writev system call
+
+struct stats_writev_t {
+  int called;  // number of times the writev system call has been issued
+  struct params_writev_t last_params; // parameters for the last call issued
+  ssize_t last_return;   // return value of the last writev call issued
+  struct stats_io_t io;  // bytes written by the successful calls
+};
+
+
+struct params_sendfile_t {
+  int out_fd;
+  int in_fd;
+  off_t *offset;
+  size_t count;
+};
+
+// basic statistics for the utilisation of the sendfile system call
+
+struct stats_sendfile_t {
+  int called;  // number of times the sendfile system call has been issued
+  struct params_sendfile_t last_params; // parameters for the last call issued
+  ssize_t last_return;   // return value of the last sendfile call issued
+  struct stats_io_t io;  // bytes copied by the successful calls
+};
+
+
+struct params_splice_t {
+  int fd_in;
+  loff_t *off_in;
+  int fd_out;
+  loff_t *off_out;
+  size_t len;
+  unsigned int flags;
+};
+
+// basic statistics for the utilisation of the splice system call
+
+struct stats_splice_t {
+  int called;  // number of times the splice system call has been issued
+  struct params_splice_t last_params; // parameters for the last call issued
+  ssize_t last_return;   // return value of the last splice call issued
+  struct stats_io_t io;  // bytes moved by the successful calls
+};
+
+// sendfile and splice move data between two descriptors without copying it
+// in user space. When one of them is served by a read buffer (see
+// read_write.h) or by the VFS (see vfs.h), the data is copied through
+// a buffer of FILE_BOUNCE_SIZE bytes instead, so that a call may be short.
+#define FILE_BOUNCE_SIZE 16384
+
 void reinit_file_stats();
 
 #endif // __WRAP_FILE_H_
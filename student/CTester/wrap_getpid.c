@@ -33,6 +33,7 @@ pid_t __wrap_getpid(void) {
   // being monitored
 
   stats.getpid.called++;
+  CALLSITE("getpid");
   pid_t ret=__real_getpid();
   stats.getpid.last_return=ret;
   return ret;
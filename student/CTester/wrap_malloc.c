@@ -13,11 +13,23 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
 
 #include  "wrap.h"
+#include  "trap.h"
 
 #include <libintl.h> 
 #include <locale.h> 
@@ -26,11 +38,15 @@
 #define MSG_SIZE 1000
 char msg[MSG_SIZE];
 
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
 
 void * __real_malloc(size_t s);
 void * __real_calloc(size_t nmemb, size_t s);
 void __real_free(void *);
 void * __real_realloc(void *ptr, size_t size);
+int __real_pthread_mutex_lock(pthread_mutex_t *mutex);
+int __real_pthread_mutex_unlock(pthread_mutex_t *mutex);
 
 
 extern bool wrap_monitoring;
@@ -39,72 +55,767 @@ extern struct wrap_monitor_t monitored;
 extern struct wrap_fail_t failures;
 extern struct wrap_log_t logs;
 
+void push_info_msg(char *msg);
+
+//
+// Call stacks of the allocations, hash-consed: identical stacks are stored
+// only once, and the log entries refer to them by id (index + 1).
+// MALLOC_STACK_MAX must be a power of two.
+//
+struct malloc_stack_t {
+  uint32_t hash;
+  unsigned int depth; // 0 if the slot is empty
+  void *frames[MALLOC_STACK_DEPTH];
+};
+
+static bool malloc_backtrace = false;
+static struct malloc_stack_t malloc_stacks[MALLOC_STACK_MAX];
+static unsigned int malloc_stacks_n = 0;
+
+void set_malloc_backtrace(bool enable) {
+  if (enable) {
+    // The first call to backtrace loads libgcc, do it outside of the sandbox
+    void *tmp[1];
+    backtrace(tmp, 1);
+  }
+  malloc_backtrace = enable;
+}
+
+//
+// Returns the id of the call stack of the allocation wrapper calling it,
+// or 0 if the stack table is full. Must be called directly by the wrapper,
+// as the first two frames (this function and the wrapper) are skipped.
+//
+static unsigned int __attribute__((noinline)) capture_malloc_stack() {
+  void *frames[MALLOC_STACK_DEPTH + 2];
+  int n = backtrace(frames, MALLOC_STACK_DEPTH + 2);
+  if (n <= 2)
+    return 0;
+  unsigned int depth = n - 2;
+  uint32_t hash = 2166136261u; // FNV-1a over the return addresses
+  for (unsigned int i = 0; i < depth; i++) {
+    uint64_t v = (uintptr_t) frames[i + 2];
+    hash = (hash ^ (uint32_t) v) * 16777619u;
+    hash = (hash ^ (uint32_t) (v >> 32)) * 16777619u;
+  }
+  unsigned int slot = hash & (MALLOC_STACK_MAX - 1);
+  for (unsigned int probe = 0; probe < MALLOC_STACK_MAX; probe++) {
+    struct malloc_stack_t *s = &malloc_stacks[slot];
+    if (s->depth == 0) {
+      // keep the table sparse enough for the probes to remain short
+      if (malloc_stacks_n >= MALLOC_STACK_MAX / 4 * 3)
+        return 0;
+      s->hash = hash;
+      s->depth = depth;
+      memcpy(s->frames, frames + 2, depth * sizeof(void *));
+      malloc_stacks_n++;
+      return slot + 1;
+    }
+    if (s->hash == hash && s->depth == depth &&
+        memcmp(s->frames, frames + 2, depth * sizeof(void *)) == 0)
+      return slot + 1;
+    slot = (slot + 1) & (MALLOC_STACK_MAX - 1);
+  }
+  return 0;
+}
+
+//
+// Guard-page mode: blocks allocated in the sandbox come from malloc_arena.
+//
+static bool malloc_guard = false;
+static int malloc_guard_type = TRAP_RIGHT;
+static size_t malloc_guard_align = 1;
+static struct trap_arena_t malloc_arena;
+
+void set_malloc_guard(bool enable, int type, size_t align) {
+  malloc_guard = enable;
+  malloc_guard_type = type;
+  malloc_guard_align = align;
+}
+
+//
+// Blocks known to the allocator wrappers, in an open-addressing table indexed
+// by their address (linear probing, filled up to 3/4, doubled when full).
+// It holds all the blocks allocated by the wrappers, in the sandbox or not,
+// the blocks freed in the sandbox as long as they are in quarantine, and
+// the last MALLOC_RELEASED_MAX ones freed in the sandbox without quarantine,
+// so that frees and reallocs are checked and accounted in constant time.
+// The tables are shared by all the threads, and only used under heap_lock
+// (see heap_enter).
+//
+struct malloc_block_t {
+  void *ptr; // NULL if the slot is empty
+  size_t size;
+  unsigned int test; // test in which the block was allocated in the sandbox, 0 if out of it
+  bool freed; // freed in the sandbox, and still in quarantine or released
+  bool released; // given back to the allocator, only its address is kept
+};
+
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t heap_owner;
+static bool heap_owned = false; // heap_lock is held by heap_owner
+
+//
+// Takes heap_lock with SIGALRM blocked, so that the timeout of the sandbox
+// can't leave the lock held by jumping out of a critical section. heap_leave
+// restores the signal mask saved in *mask.
+//
+static void heap_enter(sigset_t *mask) {
+  sigset_t block;
+  sigemptyset(&block);
+  sigaddset(&block, SIGALRM);
+  pthread_sigmask(SIG_BLOCK, &block, mask);
+  __real_pthread_mutex_lock(&heap_lock);
+  heap_owner = pthread_self();
+  heap_owned = true;
+}
+
+static void heap_leave(const sigset_t *mask) {
+  heap_owned = false;
+  __real_pthread_mutex_unlock(&heap_lock);
+  pthread_sigmask(SIG_SETMASK, mask, NULL);
+}
+
+void malloc_sandbox_abort() {
+  if (heap_owned && pthread_equal(heap_owner, pthread_self())) {
+    heap_owned = false;
+    __real_pthread_mutex_unlock(&heap_lock);
+  }
+}
+
+#define MALLOC_LIVE_MIN (64 * 1024) // Initial number of slots, a power of two
+
+static struct malloc_block_t *live_blocks = NULL;
+static size_t live_cap = 0;
+static size_t live_n = 0;
+static unsigned int current_test = 1;
+
+static size_t live_slot(const void *ptr) {
+  uint64_t h = ((uintptr_t) ptr >> 4) * 0x9e3779b97f4a7c15ull;
+  return (size_t) (h >> 32) & (live_cap - 1);
+}
+
+// Returns the slot of ptr, or the empty slot where it would be inserted
+static size_t live_find(const void *ptr) {
+  size_t slot = live_slot(ptr);
+  while (live_blocks[slot].ptr != NULL && live_blocks[slot].ptr != ptr)
+    slot = (slot + 1) & (live_cap - 1);
+  return slot;
+}
+
+//
+// Returns the entry of ptr, or NULL if it is unknown. The entry is only valid
+// until the next insertion or removal, which can move the entries.
+//
+static struct malloc_block_t *live_lookup(const void *ptr) {
+  if (ptr == NULL || live_n == 0)
+    return NULL;
+  struct malloc_block_t *b = &live_blocks[live_find(ptr)];
+  return (b->ptr == NULL ? NULL : b);
+}
+
+static bool live_grow() {
+  size_t old_cap = live_cap;
+  struct malloc_block_t *old = live_blocks;
+  size_t cap = (old_cap == 0 ? MALLOC_LIVE_MIN : old_cap * 2);
+  struct malloc_block_t *blocks = __real_calloc(cap, sizeof(struct malloc_block_t));
+  if (blocks == NULL)
+    return false;
+  live_blocks = blocks;
+  live_cap = cap;
+  for (size_t i = 0; i < old_cap; i++) {
+    if (old[i].ptr != NULL)
+      live_blocks[live_find(old[i].ptr)] = old[i];
+  }
+  __real_free(old);
+  return true;
+}
+
+// The block stays unknown if the table can't grow
+static void live_insert(void *ptr, size_t size, unsigned int test) {
+  if (live_n + 1 > live_cap / 4 * 3 && !live_grow())
+    return;
+  size_t slot = live_find(ptr);
+  if (live_blocks[slot].ptr == NULL)
+    live_n++;
+  live_blocks[slot] = (struct malloc_block_t) {
+    .ptr = ptr,
+    .size = size,
+    .test = test,
+    .freed = false,
+    .released = false
+  };
+}
+
+static void live_remove(struct malloc_block_t *b) {
+  size_t slot = b - live_blocks;
+  // Backward-shift deletion: move up the following entries of the cluster
+  // that can't be reached anymore once the slot is empty
+  size_t next = slot;
+  for (;;) {
+    next = (next + 1) & (live_cap - 1);
+    if (live_blocks[next].ptr == NULL)
+      break;
+    size_t home = live_slot(live_blocks[next].ptr);
+    if (((next - home) & (live_cap - 1)) >= ((next - slot) & (live_cap - 1))) {
+      live_blocks[slot] = live_blocks[next];
+      slot = next;
+    }
+  }
+  live_blocks[slot].ptr = NULL;
+  live_n--;
+}
+
+//
+// Gives a block back to the arena or to the real allocator.
+//
+static void free_block(void *ptr) {
+  if (trap_arena_owns(&malloc_arena, ptr))
+    trap_arena_free(&malloc_arena, ptr);
+  else
+    __real_free(ptr);
+}
+
+//
+// Addresses of the blocks freed in the sandbox that are too big for
+// the quarantine, oldest first. Their entries stay in the table, marked as
+// released, until they leave the ring. The blocks of the arena are given
+// back to it right away, as it only hands them out again through the wrappers
+// (which replaces their entry); the other blocks keep their address until
+// they leave the ring, so that the C library can't reuse it for a block
+// unknown to the wrappers, but their pages are given back to the system.
+//
+static void *released[MALLOC_RELEASED_MAX];
+static size_t released_first = 0;
+static size_t released_n = 0;
+
+static void released_forget_oldest() {
+  void *ptr = released[released_first];
+  struct malloc_block_t *b = live_lookup(ptr);
+  if (b != NULL && b->released) {
+    live_remove(b);
+    if (!trap_arena_owns(&malloc_arena, ptr))
+      __real_free(ptr);
+  }
+  released_first = (released_first + 1) % MALLOC_RELEASED_MAX;
+  released_n--;
+}
+
+//
+// Releases the known block ptr, whose entry is b, keeping its address
+// to detect a later double free.
+//
+static void released_add(void *ptr, struct malloc_block_t *b) {
+  if (released_n == MALLOC_RELEASED_MAX) {
+    released_forget_oldest();
+    b = live_lookup(ptr); // the removal may have moved the entry
+  }
+  if (trap_arena_owns(&malloc_arena, ptr)) {
+    trap_arena_free(&malloc_arena, ptr);
+  } else {
+    // Only the pages entirely inside the block, the allocator keeps
+    // its own data around it
+    uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t) ptr + pagesize - 1) & ~(pagesize - 1);
+    uintptr_t end = ((uintptr_t) ptr + malloc_usable_size(ptr)) & ~(pagesize - 1);
+    if (end > start)
+      madvise((void *) start, end - start, MADV_DONTNEED);
+  }
+  b->freed = true;
+  b->released = true;
+  released[(released_first + released_n) % MALLOC_RELEASED_MAX] = ptr;
+  released_n++;
+}
+
+//
+// Quarantine of the freed blocks: a circular FIFO bounded in bytes and blocks.
+// In the sandbox, the blocks freed by the student always go through it, so that
+// their address can't be reused while they are checked for double frees;
+// they are only poisoned (or protected) if set_malloc_quarantine enabled it.
+//
+struct quarantine_elem_t {
+  void *ptr;
+  size_t size; // bytes poisoned (or protected) in the block
+  bool guarded; // true if the block comes from malloc_arena
+  bool poisoned; // true if the block has been poisoned (or protected)
+};
+
+static bool malloc_quarantine = false;
+static size_t quarantine_budget = MALLOC_QUARANTINE_BUDGET;
+static struct quarantine_elem_t quarantine[MALLOC_QUARANTINE_MAX];
+static size_t quarantine_first = 0;
+static size_t quarantine_n = 0;
+static size_t quarantine_bytes = 0;
+static int quarantine_corrupted = 0; // blocks written after free, since the last flush
+
+void set_malloc_quarantine(bool enable, size_t budget) {
+  malloc_quarantine = enable;
+  quarantine_budget = (budget == 0 ? MALLOC_QUARANTINE_BUDGET : budget);
+}
+
+static bool poison_intact(const unsigned char *ptr, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (ptr[i] != MALLOC_POISON)
+      return false;
+  }
+  return true;
+}
+
+static void quarantine_release_oldest() {
+  struct quarantine_elem_t *elem = &quarantine[quarantine_first];
+  if (elem->poisoned && !elem->guarded && !poison_intact(elem->ptr, elem->size))
+    quarantine_corrupted++;
+  free_block(elem->ptr);
+  struct malloc_block_t *b = live_lookup(elem->ptr);
+  if (b != NULL && b->freed)
+    live_remove(b);
+  quarantine_bytes -= elem->size;
+  elem->ptr = NULL;
+  quarantine_first = (quarantine_first + 1) % MALLOC_QUARANTINE_MAX;
+  quarantine_n--;
+}
+
+//
+// Puts a known block in quarantine and marks it as freed.
+// Returns false if the block is too big, in which case it is left as it is.
+//
+static bool quarantine_block(void *ptr) {
+  bool guarded = trap_arena_owns(&malloc_arena, ptr);
+  size_t size;
+  if (guarded) {
+    size_t pagesize = malloc_arena.pagesize;
+    size = (trap_arena_size(&malloc_arena, ptr) + pagesize - 1) / pagesize * pagesize;
+  } else {
+    size = malloc_usable_size(ptr);
+  }
+  if (size > quarantine_budget) {
+    // Would flush the whole quarantine for a single block
+    return false;
+  }
+  while (quarantine_n == MALLOC_QUARANTINE_MAX || quarantine_bytes + size > quarantine_budget)
+    quarantine_release_oldest();
+  if (malloc_quarantine) {
+    if (guarded)
+      trap_arena_protect(&malloc_arena, ptr, PROT_NONE);
+    else
+      memset(ptr, MALLOC_POISON, size);
+  }
+  quarantine[(quarantine_first + quarantine_n) % MALLOC_QUARANTINE_MAX] = (struct quarantine_elem_t) {
+    .ptr = ptr,
+    .size = size,
+    .guarded = guarded,
+    .poisoned = malloc_quarantine
+  };
+  quarantine_n++;
+  quarantine_bytes += size;
+  // the releases above may have moved the entry
+  live_lookup(ptr)->freed = true;
+  return true;
+}
+
+int malloc_quarantine_flush() {
+  sigset_t mask;
+  heap_enter(&mask);
+  while (quarantine_n > 0)
+    quarantine_release_oldest();
+  int corrupted = quarantine_corrupted;
+  quarantine_corrupted = 0;
+  heap_leave(&mask);
+  return corrupted;
+}
+
+// Called by the segfault handler: must not take heap_lock
+bool malloc_quarantined(const void *addr) {
+  for (size_t i = 0; i < quarantine_n; i++) {
+    struct quarantine_elem_t *elem = &quarantine[(quarantine_first + i) % MALLOC_QUARANTINE_MAX];
+    const void *start = elem->ptr;
+    if (elem->guarded) {
+      // The whole pages of the block are protected
+      uintptr_t mask = ~((uintptr_t) malloc_arena.pagesize - 1);
+      start = (const void *) ((uintptr_t) start & mask);
+    }
+    if (addr >= start && addr < start + elem->size)
+      return true;
+  }
+  return false;
+}
+
+//
+// Checks of the pointers given to free and realloc in the sandbox.
+//
+static struct malloc_free_errors_t free_errors;
+
+void malloc_free_errors(struct malloc_free_errors_t *errors) {
+  *errors = free_errors;
+  memset(&free_errors, 0, sizeof(free_errors));
+}
+
+static bool on_stack(const void *ptr) {
+  static pthread_t stack_thread;
+  static const void *stack_start = NULL;
+  static size_t stack_size = 0;
+  if (stack_start == NULL || !pthread_equal(stack_thread, pthread_self())) {
+    pthread_attr_t attr;
+    void *start;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+      return false;
+    pthread_attr_getstack(&attr, &start, &stack_size);
+    pthread_attr_destroy(&attr);
+    stack_start = start;
+    stack_thread = pthread_self();
+  }
+  return ptr >= stack_start && ptr < stack_start + stack_size;
+}
+
+//
+// Returns the error made by freeing ptr, which isn't the start of a known
+// block, or MALLOC_FREE_OK if it may have been allocated by the C library
+// (strdup, getline...) without going through the wrappers.
+//
+static int check_unknown_free(const void *ptr) {
+  if (trap_arena_owns(&malloc_arena, ptr))
+    return MALLOC_FREE_INTERIOR;
+  // Looks for the closest block starting before ptr (blocks are aligned)
+  uintptr_t start = (uintptr_t) ptr & ~((uintptr_t) MALLOC_ALIGN - 1);
+  for (uintptr_t d = 0; d <= MALLOC_INTERIOR_SCAN && d <= start; d += MALLOC_ALIGN) {
+    struct malloc_block_t *b = live_lookup((void *) (start - d));
+    if (b != NULL && !b->released) {
+      if ((uintptr_t) ptr < start - d + b->size)
+        return MALLOC_FREE_INTERIOR;
+      break;
+    }
+  }
+  Dl_info info;
+  if (on_stack(ptr) || dladdr(ptr, &info) != 0)
+    return MALLOC_FREE_INVALID; // local or global variable
+  if ((uintptr_t) ptr % MALLOC_ALIGN != 0)
+    return MALLOC_FREE_INVALID;
+  return MALLOC_FREE_OK;
+}
+
+//
+// Checks a non-NULL pointer given to free or realloc in the sandbox, whose
+// entry is b (NULL if unknown), and counts the error if any.
+// Returns true if the pointer can be freed.
+//
+static bool check_free(const void *ptr, const struct malloc_block_t *b) {
+  int error = (b == NULL ? check_unknown_free(ptr) : (b->freed ? MALLOC_FREE_DOUBLE : MALLOC_FREE_OK));
+  switch (error) {
+    case MALLOC_FREE_DOUBLE:
+      free_errors.double_free++;
+      break;
+    case MALLOC_FREE_INVALID:
+      free_errors.invalid++;
+      break;
+    case MALLOC_FREE_INTERIOR:
+      free_errors.interior++;
+      break;
+  }
+  return error == MALLOC_FREE_OK;
+}
+
+//
+// Allocation primitives used by the wrappers: they take the blocks from
+// the arena in guard mode (falling back on the real allocator if it is full),
+// and give the blocks of the arena back to it whatever the current mode.
+//
+static void *alloc_block(size_t size, bool zero) {
+  if (wrap_monitoring && malloc_guard) {
+    void *ptr = trap_arena_alloc(&malloc_arena, size, malloc_guard_type, malloc_guard_align);
+    if (ptr != NULL) {
+      // Recycled slots keep their old content: fill them like malloc does
+      // after mallopt(M_PERTURB, 142) in run_tests
+      memset(ptr, (zero ? 0 : 142 ^ 0xff), size);
+      return ptr;
+    }
+  }
+  return (zero ? __real_calloc(1, size) : __real_malloc(size));
+}
+
+// Usable size of a block, for the blocks unknown to the heap accounting
+static size_t block_size(void *ptr) {
+  if (ptr == NULL)
+    return 0;
+  if (trap_arena_owns(&malloc_arena, ptr))
+    return trap_arena_size(&malloc_arena, ptr);
+  return malloc_usable_size(ptr);
+}
+
+//
+// Heap accounting: stats.memory.used counts the blocks allocated in
+// the sandbox during the current test.
+//
+static size_t malloc_budget = 0; // 0 if no limit
+static int budget_refused = 0; // allocations refused since the last check
+
+void set_malloc_budget(size_t budget) {
+  malloc_budget = budget;
+}
+
+int malloc_budget_refused() {
+  int refused = budget_refused;
+  budget_refused = 0;
+  return refused;
+}
+
+void malloc_reset_accounting() {
+  sigset_t mask;
+  heap_enter(&mask);
+  current_test++;
+  budget_refused = 0;
+  memset(&free_errors, 0, sizeof(free_errors));
+  while (released_n > 0)
+    released_forget_oldest();
+  heap_leave(&mask);
+}
+
+//
+// true if size more bytes can be allocated without exceeding the budget.
+//
+static bool heap_reserve(size_t size) {
+  if (!wrap_monitoring || malloc_budget == 0 || stats.memory.used + size <= malloc_budget)
+    return true;
+  budget_refused++;
+  errno = ENOMEM;
+  return false;
+}
+
+static void heap_track(void *ptr, size_t size) {
+  if (ptr == NULL)
+    return;
+  live_insert(ptr, size, (wrap_monitoring ? current_test : 0));
+  if (wrap_monitoring) {
+    stats.memory.used += size;
+    if (stats.memory.used > stats.memory.peak)
+      stats.memory.peak = stats.memory.used;
+  }
+}
+
+// Size of the block b counted in stats.memory.used
+static size_t heap_counted(const struct malloc_block_t *b) {
+  return (b != NULL && b->test == current_test ? b->size : 0);
+}
+
+//
+// Releases the known block ptr, whose entry is b: in the sandbox,
+// it goes in quarantine; out of it, it is freed right away.
+//
+static void heap_release(void *ptr, struct malloc_block_t *b) {
+  if (wrap_monitoring) {
+    stats.memory.used -= MIN(heap_counted(b), stats.memory.used);
+    if (quarantine_block(ptr))
+      return;
+    // Too big for the quarantine
+    released_add(ptr, live_lookup(ptr));
+    return;
+  }
+  live_remove(b);
+  free_block(ptr);
+}
+
+static void *heap_alloc(size_t size, bool zero) {
+  sigset_t mask;
+  heap_enter(&mask);
+  if (wrap_monitoring)
+    histogram_add(zero ? &stats.memory.calloc_sizes : &stats.memory.malloc_sizes, size);
+  void *ptr = NULL;
+  if (heap_reserve(size)) {
+    ptr = alloc_block(size, zero);
+    heap_track(ptr, size);
+  }
+  heap_leave(&mask);
+  return ptr;
+}
+
+// Called with heap_lock held
+static void heap_free_locked(void *ptr) {
+  if (ptr == NULL)
+    return;
+  struct malloc_block_t *b = live_lookup(ptr);
+  if (wrap_monitoring && !check_free(ptr, b))
+    return; // freeing it would corrupt the heap
+  if (b != NULL && b->released)
+    return; // out of the sandbox, freed twice: it is freed when it leaves the ring
+  if (b != NULL)
+    heap_release(ptr, b);
+  else
+    free_block(ptr);
+}
+
+static void heap_free(void *ptr) {
+  sigset_t mask;
+  heap_enter(&mask);
+  heap_free_locked(ptr);
+  heap_leave(&mask);
+}
+
+//
+// Classifies the growth of a block from old_size to size (size > old_size).
+//
+static void realloc_grown(size_t old_size, size_t size) {
+  struct stats_memory_t *m = &stats.memory;
+  m->realloc_grown++;
+  if (size - old_size >= old_size / MALLOC_GROWTH_DIV)
+    m->realloc_geometric++;
+  m->realloc_growth = (m->realloc_geometric * 2 >= m->realloc_grown ? GROWTH_GEOMETRIC : GROWTH_ADDITIVE);
+}
+
+// Called with heap_lock held
+static void *heap_realloc_locked(void *ptr, size_t size) {
+  if (wrap_monitoring)
+    histogram_add(&stats.memory.realloc_sizes, size);
+  if (ptr == NULL) {
+    if (!heap_reserve(size))
+      return NULL;
+    void *r_ptr = alloc_block(size, false);
+    heap_track(r_ptr, size);
+    return r_ptr;
+  }
+  struct malloc_block_t *b = live_lookup(ptr);
+  if (wrap_monitoring && !check_free(ptr, b)) {
+    errno = EINVAL;
+    return NULL;
+  }
+  if (size == 0) {
+    heap_free_locked(ptr);
+    return NULL;
+  }
+  if (b != NULL && b->released) {
+    // Out of the sandbox, freed twice
+    errno = EINVAL;
+    return NULL;
+  }
+  size_t old_size = (b != NULL ? b->size : block_size(ptr));
+  size_t counted = heap_counted(b);
+  if (size > counted && !heap_reserve(size - counted))
+    return NULL;
+  void *r_ptr;
+  // In the sandbox, a known block that has to grow is moved by hand, so that
+  // the old one goes in quarantine instead of going back to the C library
+  bool by_hand = (wrap_monitoring && (malloc_guard || malloc_quarantine ||
+                                      (b != NULL && size > malloc_usable_size(ptr))));
+  if (!by_hand && !trap_arena_owns(&malloc_arena, ptr)) {
+    r_ptr = __real_realloc(ptr, size);
+    if (r_ptr == NULL)
+      return NULL;
+    if (wrap_monitoring)
+      stats.memory.used -= MIN(counted, stats.memory.used);
+    b = live_lookup(ptr);
+    if (b != NULL)
+      live_remove(b);
+  } else {
+    // The block moves to or from the arena, or goes in quarantine: do it by hand
+    r_ptr = alloc_block(size, false);
+    if (r_ptr == NULL)
+      return NULL;
+    memcpy(r_ptr, ptr, MIN(old_size, size));
+    if (b != NULL)
+      heap_release(ptr, b);
+    else
+      free_block(ptr);
+  }
+  heap_track(r_ptr, size);
+  if (wrap_monitoring) {
+    if (r_ptr != ptr)
+      stats.memory.realloc_moved += MIN(old_size, size);
+    if (size > old_size)
+      realloc_grown(old_size, size);
+  }
+  return r_ptr;
+}
+
+static void *heap_realloc(void *ptr, size_t size) {
+  sigset_t mask;
+  heap_enter(&mask);
+  void *r_ptr = heap_realloc_locked(ptr, size);
+  heap_leave(&mask);
+  return r_ptr;
+}
+
 //
 // keeps only MAX_LOG in memory
 //
-void log_malloc(void *ptr, size_t size) {
+void log_malloc(void *ptr, size_t size, unsigned int stack) {
   
   if(ptr!=NULL && logs.malloc.n < MAX_LOG) {
     logs.malloc.log[logs.malloc.n].size=size;
     logs.malloc.log[logs.malloc.n].ptr=ptr;
+    logs.malloc.log[logs.malloc.n].stack=stack;
     logs.malloc.n++;
   }
 }
 
-void update_realloc_block(void *ptr, size_t newsize) {
-   for(int i=0;i<MAX_LOG;i++) {
-     if(logs.malloc.log[i].ptr==ptr) {
+void update_realloc_block(void *ptr, void *newptr, size_t newsize, unsigned int stack) {
+  for(int i=0;i<logs.malloc.n;i++) {
+    if(logs.malloc.log[i].ptr==ptr) {
+      logs.malloc.log[i].ptr=newptr;
       logs.malloc.log[i].size=newsize;
+      if (stack != 0)
+        logs.malloc.log[i].stack=stack;
       return;
-     } 
+    }
   }
-   return ;
 }
 
-size_t find_size_malloc(void *ptr) {
-  for(int i=0;i<MAX_LOG;i++) {
-    if(logs.malloc.log[i].ptr==ptr) 
-      return logs.malloc.log[i].size;
+int malloc_free_ptr(void *ptr) {
+
+  for(int i=0;i<logs.malloc.n;i++) {
+    if(logs.malloc.log[i].ptr==ptr) {
+      int size=logs.malloc.log[i].size;
+      logs.malloc.log[i].size=-1;
+      logs.malloc.log[i].ptr=NULL;
+      return size;
+    }
   }
-  return -1;
+  return 0;
 }
 
 
 void * __wrap_malloc(size_t size) {
   if(!wrap_monitoring || !monitored.malloc) {
-    return __real_malloc(size);
+    return heap_alloc(size, false);
   }
   stats.malloc.called++;
+  struct callsite_t *callsite = CALLSITE("malloc");
   stats.malloc.last_params.size=size;
   if(FAIL(failures.malloc)) {
+    callsite_failed(callsite);
     failures.malloc=NEXT(failures.malloc);
     return failures.malloc_ret;
   }
-  stats.memory.used+=size;
   failures.malloc=NEXT(failures.malloc);    
-  void *ptr=__real_malloc(size);
+  void *ptr=heap_alloc(size, false);
   stats.malloc.last_return=ptr;
-  log_malloc(ptr,size);
+  if(ptr!=NULL)
+    callsite_bytes(callsite, size);
+  log_malloc(ptr,size,malloc_backtrace ? capture_malloc_stack() : 0);
   return ptr;
 }
 
 void * __wrap_realloc(void *ptr, size_t size) {
   if(!wrap_monitoring || !monitored.realloc) {
-    return __real_realloc(ptr, size);
+    return heap_realloc(ptr, size);
   }
   stats.realloc.called++;
+  struct callsite_t *callsite = CALLSITE("realloc");
+  stats.realloc.last_params.ptr=ptr;
   stats.realloc.last_params.size=size;
   if(FAIL(failures.realloc)) {
+    callsite_failed(callsite);
     failures.realloc=NEXT(failures.realloc);
     return failures.realloc_ret;
   }
   failures.realloc=NEXT(failures.realloc);    
-  int old_size=find_size_malloc(ptr);
-  void *r_ptr=__real_realloc(ptr,size);
+  void *r_ptr=heap_realloc(ptr,size);
   stats.realloc.last_return=r_ptr;
-  if(ptr!=NULL) {
-      stats.memory.used+=size-old_size;
-      update_realloc_block(ptr,size);
+  if(r_ptr!=NULL)
+    callsite_bytes(callsite, size);
+  if(ptr==NULL) {
+    log_malloc(r_ptr,size,malloc_backtrace ? capture_malloc_stack() : 0);
+  } else if(r_ptr!=NULL) {
+    update_realloc_block(ptr,r_ptr,size,malloc_backtrace ? capture_malloc_stack() : 0);
+  } else if(size==0) {
+    malloc_free_ptr(ptr);
   }
   return r_ptr;
 }
@@ -112,51 +823,46 @@ void * __wrap_realloc(void *ptr, size_t size) {
 
 void * __wrap_calloc(size_t nmemb, size_t size) {
   if(!wrap_monitoring || !monitored.calloc) {
-    return __real_calloc(nmemb, size);
+    if (nmemb != 0 && size > SIZE_MAX / nmemb)
+      return __real_calloc(nmemb, size); // overflow: let calloc fail
+    return heap_alloc(nmemb * size, true);
   }
   stats.calloc.called++;
+  struct callsite_t *callsite = CALLSITE("calloc");
   stats.calloc.last_params.size=size;
   stats.calloc.last_params.nmemb=nmemb;
 
   if(FAIL(failures.calloc)) {
+    callsite_failed(callsite);
     failures.calloc=NEXT(failures.calloc);
     return failures.calloc_ret;
   }
-  stats.memory.used+=nmemb*size;
   failures.calloc=NEXT(failures.calloc);
     
-  void *ptr=__real_calloc(nmemb,size);
+  void *ptr=(nmemb != 0 && size > SIZE_MAX / nmemb ?
+      __real_calloc(nmemb,size) : heap_alloc(nmemb*size, true));
   stats.calloc.last_return=ptr;
-  log_malloc(ptr,nmemb*size);
+  if(ptr!=NULL)
+    callsite_bytes(callsite, nmemb*size);
+  log_malloc(ptr,nmemb*size,malloc_backtrace ? capture_malloc_stack() : 0);
   return ptr;
 }
 
-int malloc_free_ptr(void *ptr) {
-
-  for(int i=0;i<MAX_LOG;i++) {
-    if(logs.malloc.log[i].ptr==ptr) {
-      int size=logs.malloc.log[i].size;
-      logs.malloc.log[i].size=-1;
-      logs.malloc.log[i].ptr=NULL;
-      return size;
-    }
-  }
-  return 0;
-}
-
 void __wrap_free(void *ptr) {
   if(!wrap_monitoring || !monitored.free) {
-    return __real_free(ptr);
+    return heap_free(ptr);
   }
   stats.free.called++;
+  struct callsite_t *callsite = CALLSITE("free");
   stats.free.last_params.ptr=ptr;
   if(ptr!=NULL) {
-    stats.memory.used-=malloc_free_ptr(ptr);
-
-    if (FAIL(failures.free))
+    if (FAIL(failures.free)) {
+      callsite_failed(callsite);
       failures.free=NEXT(failures.free);
-    else
-      __real_free(ptr);
+    } else {
+      malloc_free_ptr(ptr);
+      heap_free(ptr);
+    }
   }
 }
 
@@ -204,3 +910,62 @@ int malloced(void *addr) {
   return false;
 
 }
+
+//
+// Writes in buf the student functions of the call stack id, innermost first,
+// stopping at the test function test_fn. Only the frames of the executable
+// (whose base address is exe_base) are kept, libraries are skipped.
+//
+static void describe_malloc_stack(unsigned int id, void *test_fn, void *exe_base, char *buf, size_t len) {
+  size_t used = 0;
+  buf[0] = '\0';
+  if (id != 0) {
+    struct malloc_stack_t *s = &malloc_stacks[id - 1];
+    for (unsigned int i = 0; i < s->depth && used < len; i++) {
+      Dl_info info;
+      if (dladdr(s->frames[i], &info) == 0 || info.dli_fbase != exe_base)
+        continue;
+      if (info.dli_saddr != NULL && info.dli_saddr == test_fn)
+        break;
+      used += snprintf(buf + used, len - used, "%s%s", (used == 0 ? "" : " <- "),
+          (info.dli_sname != NULL ? info.dli_sname : "??"));
+    }
+  }
+  if (buf[0] == '\0')
+    snprintf(buf, len, "%s", _("an unknown location"));
+}
+
+int report_malloc_leaks() {
+  Dl_info test_info, exe_info;
+  // report_malloc_leaks is called by the test function itself
+  void *test_fn = NULL;
+  if (dladdr(__builtin_return_address(0), &test_info) != 0)
+    test_fn = test_info.dli_saddr;
+  void *exe_base = NULL;
+  if (dladdr((void *) &report_malloc_leaks, &exe_info) != 0)
+    exe_base = exe_info.dli_fbase;
+
+  bool done[MAX_LOG];
+  memset(done, 0, sizeof(done));
+  int leaked = 0;
+  for (int i = 0; i < logs.malloc.n; i++) {
+    if (done[i] || logs.malloc.log[i].ptr == NULL)
+      continue;
+    unsigned int stack = logs.malloc.log[i].stack;
+    int blocks = 0;
+    size_t bytes = 0;
+    for (int j = i; j < logs.malloc.n; j++) {
+      if (!done[j] && logs.malloc.log[j].ptr != NULL && logs.malloc.log[j].stack == stack) {
+        done[j] = true;
+        blocks++;
+        bytes += logs.malloc.log[j].size;
+      }
+    }
+    leaked += blocks;
+    char site[MSG_SIZE / 2];
+    describe_malloc_stack(stack, test_fn, exe_base, site, sizeof(site));
+    snprintf(msg, MSG_SIZE, _("Your code leaks %zu byte(s) in %d block(s) allocated by %s."), bytes, blocks, site);
+    push_info_msg(msg);
+  }
+  return leaked;
+}
@@ -18,12 +18,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util_histogram.h"
 // log for malloc operations
 
 
 struct malloc_elem_t {
   size_t size;
   void *ptr;
+  unsigned int stack; // id of the allocation call stack, 0 if not captured
 };
 
 
@@ -41,8 +46,30 @@ struct stats_malloc_t {
   void *last_return;   // return value of the last malloc call issued
 };
 
+// heap accounting of the sandbox: all the blocks allocated inside the sandbox
+// are counted, whether malloc, calloc and realloc are monitored or not
+
+// growth pattern of the blocks enlarged by realloc
+
+enum {
+  GROWTH_NONE,       // no block has been enlarged
+  GROWTH_GEOMETRIC,  // blocks mostly enlarged by a factor
+  GROWTH_ADDITIVE    // blocks mostly enlarged by a constant amount: quadratic copying
+};
+
+// a growth is geometric if it adds at least 1/MALLOC_GROWTH_DIV of the old size
+#define MALLOC_GROWTH_DIV 8
+
 struct stats_memory_t {
-  int used;  // Total number of bytes allocated
+  uint64_t used;  // Number of bytes currently allocated
+  uint64_t peak;  // Maximal value of used since the beginning of the last sandbox
+  struct histogram_t malloc_sizes;  // sizes requested to malloc
+  struct histogram_t calloc_sizes;  // total sizes (nmemb * size) requested to calloc
+  struct histogram_t realloc_sizes; // new sizes requested to realloc
+  uint64_t realloc_moved;  // bytes copied by realloc to move blocks (old size when the pointer changed)
+  int realloc_grown;       // number of reallocs that enlarged a block
+  int realloc_geometric;   // among them, number of geometric growths
+  int realloc_growth;      // GROWTH_NONE, GROWTH_GEOMETRIC or GROWTH_ADDITIVE
 };
 
 // basic structure to record the parameters of the last malloc call
@@ -101,4 +128,128 @@ int malloced(void *addr);
 // total amount of memory allocated by malloc
 int  malloc_allocated();
 
+/*
+ * Maximal number of frames kept for each allocation call stack,
+ * and maximal number of distinct call stacks that can be recorded.
+ */
+#define MALLOC_STACK_DEPTH 8
+#define MALLOC_STACK_MAX 4096
+
+/*
+ * When enable is true, the monitored malloc, calloc and realloc calls
+ * record the call stack of the allocation, so that memory leaks can be
+ * reported by call site with report_malloc_leaks.
+ */
+void set_malloc_backtrace(bool enable);
+
+/*
+ * Groups the blocks that are still allocated by their allocation call stack,
+ * and reports each group with push_info_msg, naming the student functions
+ * that allocated it. Should be called after SANDBOX_END, once the test has
+ * freed the memory the student was expected to return.
+ * Returns the number of leaked blocks.
+ */
+int report_malloc_leaks();
+
+/*
+ * When enable is true, the blocks allocated by malloc, calloc and realloc
+ * inside the sandbox (monitored or not) are each placed against a protected
+ * page, on the side given by type (TRAP_LEFT or TRAP_RIGHT, see trap.h),
+ * so that an overflow of the block on this side produces a segfault.
+ * With TRAP_RIGHT, the start of the blocks is aligned on align bytes:
+ * 1 detects an overflow of a single byte, but gives unaligned blocks.
+ * The blocks come from a pooled trap arena, where freed blocks are recycled;
+ * they can still be freed or reallocated once out of the sandbox.
+ */
+void set_malloc_guard(bool enable, int type, size_t align);
+
+/*
+ * The blocks freed inside the sandbox are not released immediately but kept
+ * in a FIFO quarantine, until the blocks freed after them exceed budget bytes
+ * (0 for the default of MALLOC_QUARANTINE_BUDGET).
+ * When enable is true, the blocks in quarantine are also checked for uses
+ * after free: blocks of the guard-page mode are protected, so that any later
+ * access produces a segfault; the other ones are filled with MALLOC_POISON, and
+ * a write after the free is detected when the block leaves the quarantine.
+ */
+#define MALLOC_QUARANTINE_BUDGET (1024 * 1024)
+#define MALLOC_QUARANTINE_MAX 4096 // Maximal number of blocks in quarantine
+// Maximal number of blocks freed in the sandbox that are too big for the
+// quarantine: their address is kept to detect double frees, but their pages
+// are given back to the system
+#define MALLOC_RELEASED_MAX 4096
+#define MALLOC_POISON 0xdb
+void set_malloc_quarantine(bool enable, size_t budget);
+
+/*
+ * Releases all the blocks in quarantine, and returns the number of blocks
+ * that have been written to after being freed since the previous call.
+ * Called by sandbox_end.
+ */
+int malloc_quarantine_flush();
+
+/*
+ * true if addr is inside a block in quarantine (i.e. freed by the student).
+ */
+bool malloc_quarantined(const void *addr);
+
+/*
+ * Releases the heap lock if the calling thread left it held by jumping out
+ * of the allocator wrappers (segfault in a realloc, for instance).
+ * Called by sandbox_fail, before anything is allocated.
+ */
+void malloc_sandbox_abort();
+
+/*
+ * Limits the heap memory used by the code in the sandbox to budget bytes
+ * (0 for no limit): an allocation that would bring stats.memory.used above
+ * the budget returns NULL with errno set to ENOMEM, and the test fails
+ * at SANDBOX_END. The budget applies to all the following sandboxes.
+ */
+void set_malloc_budget(size_t budget);
+
+/*
+ * Returns the number of allocations refused because of the heap budget
+ * since the previous call. Called by sandbox_end.
+ */
+int malloc_budget_refused();
+
+/*
+ * Forgets the blocks allocated by the previous tests, so that freeing them
+ * does not change the heap accounting of the current one. Called by start_test.
+ */
+void malloc_reset_accounting();
+
+/*
+ * Errors detected when the code in the sandbox frees (or reallocates)
+ * a pointer, which is then left untouched.
+ */
+enum {
+  MALLOC_FREE_OK,
+  MALLOC_FREE_DOUBLE,   // block already freed
+  MALLOC_FREE_INVALID,  // pointer to a local or global variable, or misaligned
+  MALLOC_FREE_INTERIOR  // pointer inside an allocated block, but not at its start
+};
+
+// Alignment of the blocks returned by the C library's malloc
+#define MALLOC_ALIGN (2 * sizeof(size_t))
+// Maximal distance to the start of its block for an interior pointer to be detected
+#define MALLOC_INTERIOR_SCAN 4096
+
+struct malloc_free_errors_t {
+  int double_free;
+  int invalid;
+  int interior;
+};
+
+/*
+ * Copies in errors the number of each kind of error detected by free and
+ * realloc since the previous call, and resets them. Called by sandbox_end.
+ * A double free is detected as long as the block is in quarantine (see
+ * set_malloc_quarantine), where all the blocks freed in the sandbox go.
+ * Pointers that are unknown but may come from the C library (strdup, getline...)
+ * are freed normally.
+ */
+void malloc_free_errors(struct malloc_free_errors_t *errors);
+
 #endif // __WRAP_MALLOC_H_
@@ -0,0 +1,271 @@
+/*
+ * Wrapper for mmap, munmap, msync, mprotect.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "wrap.h"
+
+void   *__real_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset);
+int     __real_munmap(void *addr, size_t length);
+int     __real_msync(void *addr, size_t length, int flags);
+int     __real_mprotect(void *addr, size_t len, int prot);
+
+
+extern bool wrap_monitoring;
+extern struct wrap_stats_t stats;
+extern struct wrap_monitor_t monitored;
+extern struct wrap_fail_t failures;
+
+
+/**
+ * Registry of the mappings created by the monitored calls to mmap,
+ * as ranges of whole pages [start, end).
+ */
+struct mapping_t {
+    uintptr_t start; // 0 if the slot is empty
+    uintptr_t end;
+};
+
+static struct mapping_t mappings[MMAP_MAX];
+
+static size_t page_size()
+{
+    static size_t size = 0;
+    if (size == 0) {
+        size = sysconf(_SC_PAGESIZE);
+    }
+    return size;
+}
+
+static uintptr_t page_up(uintptr_t a)
+{
+    return (a + page_size() - 1) & ~(page_size() - 1);
+}
+
+static void mapping_add(void *addr, size_t length)
+{
+    for (int i = 0; i < MMAP_MAX; i++) {
+        if (mappings[i].start == 0) {
+            mappings[i].start = (uintptr_t) addr;
+            mappings[i].end = page_up((uintptr_t) addr + length);
+            stats.mapping.live++;
+            stats.mapping.live_bytes += mappings[i].end - mappings[i].start;
+            return;
+        }
+    }
+    // The registry is full: the mapping is not followed
+}
+
+/*
+ * Returns the number of resident pages in [start, end).
+ */
+static uint64_t resident_pages(uintptr_t start, uintptr_t end)
+{
+    unsigned char vec[1024];
+    uint64_t n = 0;
+    while (start < end) {
+        size_t len = end - start;
+        if (len > sizeof(vec) * page_size()) {
+            len = sizeof(vec) * page_size();
+        }
+        if (mincore((void *) start, len, vec) < 0) {
+            break;
+        }
+        for (size_t i = 0; i < len / page_size(); i++) {
+            n += vec[i] & 1;
+        }
+        start += len;
+    }
+    return n;
+}
+
+/*
+ * Returns the number of resident pages of the recorded mappings in
+ * [start, end), and removes this range from the registry if forget is true.
+ */
+static uint64_t mapping_range(uintptr_t start, uintptr_t end, bool forget)
+{
+    uint64_t touched = 0;
+    for (int i = 0; i < MMAP_MAX; i++) {
+        struct mapping_t *m = &mappings[i];
+        if (m->start == 0 || m->end <= start || end <= m->start) {
+            continue;
+        }
+        uintptr_t lo = (start > m->start ? start : m->start);
+        uintptr_t hi = (end < m->end ? end : m->end);
+        touched += resident_pages(lo, hi);
+        if (!forget) {
+            continue;
+        }
+        stats.mapping.live_bytes -= hi - lo;
+        if (lo == m->start && hi == m->end) {
+            m->start = m->end = 0;
+            stats.mapping.live--;
+        } else if (lo == m->start) {
+            m->start = hi;
+        } else if (hi == m->end) {
+            m->end = lo;
+        } else {
+            // A hole in the middle: the right part becomes a new mapping
+            uintptr_t right = m->end;
+            m->end = lo;
+            stats.mapping.live_bytes -= right - hi;
+            mapping_add((void *) hi, right - hi);
+        }
+    }
+    return touched;
+}
+
+/*
+ * munmap, updating the registry if it succeeds.
+ */
+static int mapping_unmap(void *addr, size_t length)
+{
+    uintptr_t start = (uintptr_t) addr;
+    uintptr_t end = page_up(start + length);
+    uint64_t touched = mapping_range(start, end, false);
+    int ret = __real_munmap(addr, length);
+    if (ret == 0) {
+        mapping_range(start, end, true);
+        stats.mapping.touched_pages += touched;
+    }
+    return ret;
+}
+
+void mmap_sandbox_end(void)
+{
+    stats.mapping.leaked = 0;
+    stats.mapping.leaked_bytes = 0;
+    for (int i = 0; i < MMAP_MAX; i++) {
+        struct mapping_t *m = &mappings[i];
+        if (m->start != 0) {
+            stats.mapping.touched_pages += resident_pages(m->start, m->end);
+            stats.mapping.leaked++;
+            stats.mapping.leaked_bytes += m->end - m->start;
+        }
+    }
+}
+
+void mmap_reset(void)
+{
+    memset(mappings, 0, sizeof(mappings));
+}
+
+
+/**
+ * Wrap functions.
+ */
+
+void *__wrap_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    if (!(wrap_monitoring && monitored.mmap)) {
+        return __real_mmap(addr, length, prot, flags, fd, offset);
+    }
+    stats.mmap.called++;
+    struct callsite_t *callsite = CALLSITE("mmap");
+    stats.mmap.last_params = (struct params_mmap_t) {
+        .addr = addr,
+        .length = length,
+        .prot = prot,
+        .flags = flags,
+        .fd = fd,
+        .offset = offset
+    };
+    if (FAIL(failures.mmap)) {
+        callsite_failed(callsite);
+        failures.mmap = NEXT(failures.mmap);
+        errno = failures.mmap_errno;
+        return (stats.mmap.last_return = failures.mmap_ret);
+    }
+    failures.mmap = NEXT(failures.mmap);
+    void *ret = __real_mmap(addr, length, prot, flags, fd, offset);
+    if (ret != MAP_FAILED) {
+        if (flags & MAP_FIXED) {
+            // The new mapping replaces the recorded ones in its range
+            mapping_range((uintptr_t) ret, page_up((uintptr_t) ret + length), true);
+        }
+        mapping_add(ret, length);
+        stats.mmap.bytes += length;
+        callsite_bytes(callsite, length);
+    }
+    return (stats.mmap.last_return = ret);
+}
+
+int __wrap_munmap(void *addr, size_t length)
+{
+    if (!(wrap_monitoring && monitored.munmap)) {
+        return mapping_unmap(addr, length);
+    }
+    stats.munmap.called++;
+    struct callsite_t *callsite = CALLSITE("munmap");
+    stats.munmap.last_params = (struct params_munmap_t) {
+        .addr = addr,
+        .length = length
+    };
+    if (FAIL(failures.munmap)) {
+        callsite_failed(callsite);
+        failures.munmap = NEXT(failures.munmap);
+        errno = failures.munmap_errno;
+        return (stats.munmap.last_return = failures.munmap_ret);
+    }
+    failures.munmap = NEXT(failures.munmap);
+    return (stats.munmap.last_return = mapping_unmap(addr, length));
+}
+
+int __wrap_msync(void *addr, size_t length, int flags)
+{
+    if (!(wrap_monitoring && monitored.msync)) {
+        return __real_msync(addr, length, flags);
+    }
+    stats.msync.called++;
+    struct callsite_t *callsite = CALLSITE("msync");
+    stats.msync.last_params = (struct params_msync_t) {
+        .addr = addr,
+        .length = length,
+        .flags = flags
+    };
+    if (FAIL(failures.msync)) {
+        callsite_failed(callsite);
+        failures.msync = NEXT(failures.msync);
+        errno = failures.msync_errno;
+        return (stats.msync.last_return = failures.msync_ret);
+    }
+    failures.msync = NEXT(failures.msync);
+    return (stats.msync.last_return = __real_msync(addr, length, flags));
+}
+
+int __wrap_mprotect(void *addr, size_t len, int prot)
+{
+    if (!(wrap_monitoring && monitored.mprotect)) {
+        return __real_mprotect(addr, len, prot);
+    }
+    stats.mprotect.called++;
+    struct callsite_t *callsite = CALLSITE("mprotect");
+    stats.mprotect.last_params = (struct params_mprotect_t) {
+        .addr = addr,
+        .len = len,
+        .prot = prot
+    };
+    if (FAIL(failures.mprotect)) {
+        callsite_failed(callsite);
+        failures.mprotect = NEXT(failures.mprotect);
+        errno = failures.mprotect_errno;
+        return (stats.mprotect.last_return = failures.mprotect_ret);
+    }
+    failures.mprotect = NEXT(failures.mprotect);
+    return (stats.mprotect.last_return = __real_mprotect(addr, len, prot));
+}
@@ -0,0 +1,105 @@
+/*
+ * Wrapper for mmap, munmap, msync, mprotect.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WRAP_MMAP_H_
+#define __WRAP_MMAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * Structures for mmap, munmap, msync and mprotect,
+ * with the usual stats fields.
+ */
+struct params_mmap_t {
+    void *addr;
+    size_t length;
+    int prot;
+    int flags;
+    int fd;
+    off_t offset;
+};
+struct stats_mmap_t {
+    int called;
+    struct params_mmap_t last_params;
+    void *last_return;
+    uint64_t bytes; // Bytes mapped by the successful calls
+};
+
+struct params_munmap_t {
+    void *addr;
+    size_t length;
+};
+struct stats_munmap_t {
+    int called;
+    struct params_munmap_t last_params;
+    int last_return;
+};
+
+struct params_msync_t {
+    void *addr;
+    size_t length;
+    int flags;
+};
+struct stats_msync_t {
+    int called;
+    struct params_msync_t last_params;
+    int last_return;
+};
+
+struct params_mprotect_t {
+    void *addr;
+    size_t len;
+    int prot;
+};
+struct stats_mprotect_t {
+    int called;
+    struct params_mprotect_t last_params;
+    int last_return;
+};
+
+/**
+ * The mappings created by the monitored calls to mmap are recorded
+ * until they are unmapped (with munmap, monitored or not).
+ * The pages of a mapping that are resident in memory, according
+ * to mincore, are counted as touched when it is unmapped, or at the end
+ * of the sandbox for the mappings that are left: those are leaked.
+ * Note that the pages of a file that are in the page cache are resident
+ * in a shared mapping of this file, even if the student didn't touch them.
+ */
+#define MMAP_MAX 256 // Maximum number of recorded mappings
+
+struct stats_mapping_t {
+    int live; // Recorded mappings that are not unmapped yet
+    uint64_t live_bytes; // Size of the live mappings, in whole pages
+    uint64_t touched_pages; // Resident pages of the recorded mappings
+    int leaked; // Mappings left at the end of the last sandbox
+    uint64_t leaked_bytes; // In whole pages
+};
+
+/**
+ * Counts the touched pages of the mappings that are left, and records
+ * them as leaked. Called by sandbox_end.
+ */
+void mmap_sandbox_end(void);
+
+/**
+ * Forgets the recorded mappings, without unmapping them.
+ * Called by start_test.
+ */
+void mmap_reset(void);
+
+#endif // __WRAP_MMAP_H_
@@ -51,6 +51,7 @@ int __wrap_pthread_mutex_destroy(pthread_mutex_t *mutex) {
   // being monitored
 
   stats.pthread_mutex_destroy.called++;
+  CALLSITE("pthread_mutex_destroy");
   int ret=__real_pthread_mutex_destroy(mutex);
   stats.pthread_mutex_destroy.last_arg=mutex;
   stats.pthread_mutex_destroy.last_return=ret;
@@ -66,6 +67,7 @@ int __wrap_pthread_mutex_init(pthread_mutex_t *restrict mutex,
   // being monitored
 
   stats.pthread_mutex_init.called++;
+  CALLSITE("pthread_mutex_init");
   int ret=__real_pthread_mutex_init(mutex,attr);
   stats.pthread_mutex_init.last_arg=mutex;
   stats.pthread_mutex_init.last_return=ret;
@@ -81,6 +83,7 @@ pid_t __wrap_pthread_mutex_lock(pthread_mutex_t *mutex) {
   // being monitored
 
   stats.pthread_mutex_lock.called++;
+  CALLSITE("pthread_mutex_lock");
   int ret=__real_pthread_mutex_lock(mutex);
   stats.pthread_mutex_lock.last_arg=mutex;
   stats.pthread_mutex_lock.last_return=ret;
@@ -95,6 +98,7 @@ pid_t __wrap_pthread_mutex_trylock(pthread_mutex_t *mutex) {
   // being monitored
 
   stats.pthread_mutex_trylock.called++;
+  CALLSITE("pthread_mutex_trylock");
   int ret=__real_pthread_mutex_trylock(mutex);
   stats.pthread_mutex_trylock.last_arg=mutex;
   stats.pthread_mutex_trylock.last_return=ret;
@@ -109,6 +113,7 @@ pid_t __wrap_pthread_mutex_unlock(pthread_mutex_t *mutex) {
   // being monitored
 
   stats.pthread_mutex_unlock.called++;
+  CALLSITE("pthread_mutex_unlock");
   int ret=__real_pthread_mutex_unlock(mutex);
   stats.pthread_mutex_unlock.last_arg=mutex;
   stats.pthread_mutex_unlock.last_return=ret;
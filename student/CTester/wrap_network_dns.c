@@ -91,6 +91,7 @@ int __wrap_getaddrinfo(const char *node, const char *service, const struct addri
         return __real_getaddrinfo(node, service, hints, res);
     }
     stats.getaddrinfo.called++;
+    struct callsite_t *callsite = CALLSITE("getaddrinfo");
     stats.getaddrinfo.last_params = (struct params_getaddrinfo_t) {
         .node = node,
         .service = service,
@@ -98,6 +99,7 @@ int __wrap_getaddrinfo(const char *node, const char *service, const struct addri
         .res = res
     };
     if (FAIL(failures.getaddrinfo)) {
+        callsite_failed(callsite);
         failures.getaddrinfo = NEXT(failures.getaddrinfo);
         errno = failures.getaddrinfo_errno;
         stats.getaddrinfo.last_return = failures.getaddrinfo_ret;
@@ -128,6 +130,7 @@ int __wrap_getnameinfo(const struct sockaddr *addr, socklen_t addrlen,
         return __real_getnameinfo(addr, addrlen, host, hostlen, serv, servlen, flags);
     }
     stats.getnameinfo.called++;
+    struct callsite_t *callsite = CALLSITE("getnameinfo");
     stats.getnameinfo.last_params = (struct params_getnameinfo_t) {
         .addr = addr,
         .addrlen = addrlen,
@@ -138,6 +141,7 @@ int __wrap_getnameinfo(const struct sockaddr *addr, socklen_t addrlen,
         .flags = flags
     };
     if (FAIL(failures.getnameinfo)) {
+        callsite_failed(callsite);
         failures.getnameinfo = NEXT(failures.getnameinfo);
         errno = failures.getnameinfo_errno;
         stats.getnameinfo.last_return = failures.getnameinfo_ret;
@@ -164,6 +168,7 @@ void __wrap_freeaddrinfo(struct addrinfo *res)
         return;
     }
     stats.freeaddrinfo.called++;
+    CALLSITE("freeaddrinfo");
     stats.freeaddrinfo.last_param = res;
     if (check_freeaddrinfo) {
         if (remove_result(res) == 0) {
@@ -193,6 +198,7 @@ const char * __wrap_gai_strerror(int ecode)
         return __real_gai_strerror(ecode);
     }
     stats.gai_strerror.called++;
+    CALLSITE("gai_strerror");
     stats.gai_strerror.last_params = ecode;
     gai_strerror_method_t met = (gai_strerror_method == NULL ? &__real_gai_strerror : gai_strerror_method);
     const char *ret = (*met)(ecode);
@@ -31,6 +31,7 @@ uint16_t __wrap_htons(uint16_t hostshort)
     uint16_t ret = __real_htons(hostshort);
     if (wrap_monitoring && monitored.htons) {
         stats.htons.called++;
+        CALLSITE("htons");
         stats.htons.last_params.hostshort = hostshort;
         stats.htons.last_return = ret;
     }
@@ -42,6 +43,7 @@ uint16_t __wrap_ntohs(uint16_t netshort)
     uint16_t ret = __real_ntohs(netshort);
     if (wrap_monitoring && monitored.ntohs) {
         stats.ntohs.called++;
+        CALLSITE("ntohs");
         stats.ntohs.last_params.netshort = netshort;
         stats.ntohs.last_return = ret;
     }
@@ -53,6 +55,7 @@ uint32_t __wrap_htonl(uint32_t hostlong)
     uint32_t ret = __real_htonl(hostlong);
     if (wrap_monitoring && monitored.htonl) {
         stats.htonl.called++;
+        CALLSITE("htonl");
         stats.htonl.last_params.hostlong = hostlong;
         stats.htonl.last_return = ret;
     }
@@ -64,6 +67,7 @@ uint32_t __wrap_ntohl(uint32_t netlong)
     uint32_t ret = __real_ntohl(netlong);
     if (wrap_monitoring && monitored.ntohl) {
         stats.ntohl.called++;
+        CALLSITE("ntohl");
         stats.ntohl.last_params.netlong = netlong;
         stats.ntohl.last_return = ret;
     }
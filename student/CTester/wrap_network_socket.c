@@ -1,6 +1,7 @@
 /*
  * Wrapper for accept, bind, connect, listen, poll, select,
- * recv, recvfrom, recvmsg, send, sendto, sendmsg, socket.
+ * recv, recvfrom, recvmsg, send, sendto, sendmsg, socket,
+ * and setsockopt, getsockopt, getsockname, getpeername for the simulated network.
  *
  * This program is free software: you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -20,6 +21,7 @@
 #include <poll.h>
 
 #include "read_write.h"
+#include "simnet.h"
 #include "wrap.h"
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
@@ -38,6 +40,10 @@ ssize_t __real_send(int sockfd, const void *buf, size_t len, int flags);
 ssize_t __real_sendmsg(int sockfd, const struct msghdr *msg, int flags);
 ssize_t __real_sendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
 int     __real_shutdown(int sockfd, int how);
+int     __real_setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen);
+int     __real_getsockopt(int sockfd, int level, int optname, void *optval, socklen_t *optlen);
+int     __real_getsockname(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
+int     __real_getpeername(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
 int     __real_socket(int domain, int type, int protocol);
 
 
@@ -53,8 +59,6 @@ extern bool fd_is_read_buffered(int fd);
 
 extern ssize_t read_handle_buffer(int fd, void *buf, size_t len, int flags);
 
-extern struct read_fd_table_t read_fd_table;
-
 
 /**
  * Wrap functions.
@@ -69,13 +73,135 @@ extern struct read_fd_table_t read_fd_table;
  * if the provided sockaddr is too small, and this sockaddr will be truncated.
  * If addr in NULL, addrlen should also be NULL.
  */
+/*
+ * The system calls, served by the simulated network when it is enabled
+ * (see simnet.h): the sockets are created in it inside the sandbox, and
+ * the sockets it returned are always served by it. socket and accept
+ * record the new descriptor in the registry.
+ */
+static int socket_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    int fd = (simnet_owns(sockfd) ? simnet_accept(sockfd, addr, addrlen) : __real_accept(sockfd, addr, addrlen));
+    fd_opened(fd, FD_TYPE_SOCKET, "accept");
+    return fd;
+}
+
+static int socket_create(int domain, int type, int protocol)
+{
+    int fd;
+    if (wrap_monitoring && simnet_enabled() && (domain == AF_INET || domain == AF_INET6)) {
+        fd = simnet_socket(domain, type, protocol);
+    } else {
+        fd = __real_socket(domain, type, protocol);
+    }
+    fd_opened(fd, FD_TYPE_SOCKET, "socket");
+    return fd;
+}
+
+static int socket_bind(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
+{
+    if (simnet_owns(sockfd))
+        return simnet_bind(sockfd, addr, addrlen);
+    return __real_bind(sockfd, addr, addrlen);
+}
+
+static int socket_connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
+{
+    if (simnet_owns(sockfd))
+        return simnet_connect(sockfd, addr, addrlen);
+    return __real_connect(sockfd, addr, addrlen);
+}
+
+static int socket_listen(int sockfd, int backlog)
+{
+    if (simnet_owns(sockfd))
+        return simnet_listen(sockfd, backlog);
+    return __real_listen(sockfd, backlog);
+}
+
+static ssize_t socket_recv(int sockfd, void *buf, size_t len, int flags)
+{
+    if (simnet_owns(sockfd)) {
+        struct iovec iov = { .iov_base = buf, .iov_len = len };
+        struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+        return simnet_recvmsg(sockfd, &msg, flags);
+    }
+    return __real_recv(sockfd, buf, len, flags);
+}
+
+static ssize_t socket_recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen)
+{
+    if (simnet_owns(sockfd)) {
+        struct iovec iov = { .iov_base = buf, .iov_len = len };
+        struct msghdr msg = {
+            .msg_name = src_addr,
+            .msg_namelen = (addrlen == NULL ? 0 : *addrlen),
+            .msg_iov = &iov,
+            .msg_iovlen = 1
+        };
+        ssize_t ret = simnet_recvmsg(sockfd, &msg, flags);
+        if (ret >= 0 && addrlen != NULL) {
+            *addrlen = msg.msg_namelen;
+        }
+        return ret;
+    }
+    return __real_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
+}
+
+static ssize_t socket_recvmsg(int sockfd, struct msghdr *msg, int flags)
+{
+    if (simnet_owns(sockfd))
+        return simnet_recvmsg(sockfd, msg, flags);
+    return __real_recvmsg(sockfd, msg, flags);
+}
+
+static ssize_t socket_send(int sockfd, const void *buf, size_t len, int flags)
+{
+    if (simnet_owns(sockfd)) {
+        struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+        struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+        return simnet_sendmsg(sockfd, &msg, flags);
+    }
+    return __real_send(sockfd, buf, len, flags);
+}
+
+static ssize_t socket_sendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+    if (simnet_owns(sockfd)) {
+        struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+        struct msghdr msg = {
+            .msg_name = (void *)dest_addr,
+            .msg_namelen = addrlen,
+            .msg_iov = &iov,
+            .msg_iovlen = 1
+        };
+        return simnet_sendmsg(sockfd, &msg, flags);
+    }
+    return __real_sendto(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+static ssize_t socket_sendmsg(int sockfd, const struct msghdr *msg, int flags)
+{
+    if (simnet_owns(sockfd))
+        return simnet_sendmsg(sockfd, msg, flags);
+    return __real_sendmsg(sockfd, msg, flags);
+}
+
+static int socket_shutdown(int sockfd, int how)
+{
+    if (simnet_owns(sockfd))
+        return simnet_shutdown(sockfd, how);
+    return __real_shutdown(sockfd, how);
+}
+
 int __wrap_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
 {
     if (!(wrap_monitoring && monitored.accept)) {
-        return __real_accept(sockfd, addr, addrlen);
+        return socket_accept(sockfd, addr, addrlen);
     }
     socklen_t old_addrlen = (addrlen == NULL ? 0 : *addrlen); // May crash if addrlen doesn't point to a valid address.
     stats.accept.called++;
+    struct callsite_t *callsite = CALLSITE("accept");
     stats.accept.last_params = (struct params_accept_t) {
         .sockfd = sockfd,
         .addr = addr,
@@ -85,13 +211,14 @@ int __wrap_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
     stats.accept.last_returns.addrlen = 0;
     memset(&(stats.accept.last_returns.addr), 0, sizeof(struct sockaddr_storage));
     if (FAIL(failures.accept)) {
+        callsite_failed(callsite);
         failures.accept = NEXT(failures.accept);
         errno = failures.accept_errno;
         return (stats.accept.last_return = failures.accept_ret);
     }
     failures.accept = NEXT(failures.accept);
     int ret = -2;
-    ret = __real_accept(sockfd, addr, addrlen);
+    ret = socket_accept(sockfd, addr, addrlen);
     if (ret == 0 && addr != NULL) {
         /*
          * We should only copy the returned address
@@ -114,74 +241,81 @@ int __wrap_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
 int __wrap_bind(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
 {
     if (!(wrap_monitoring && monitored.bind)) {
-        return __real_bind(sockfd, addr, addrlen);
+        return socket_bind(sockfd, addr, addrlen);
     }
     stats.bind.called++;
+    struct callsite_t *callsite = CALLSITE("bind");
     stats.bind.last_params = (struct params_bind_t) {
         .sockfd = sockfd,
         .addr = addr,
         .addrlen = addrlen
     };
     if (FAIL(failures.bind)) {
+        callsite_failed(callsite);
         failures.bind = NEXT(failures.bind);
         errno = failures.bind_errno;
         return (stats.bind.last_return = failures.bind_ret);
     }
     failures.bind = NEXT(failures.bind);
     int ret = -2;
-    ret = __real_bind(sockfd, addr, addrlen);
+    ret = socket_bind(sockfd, addr, addrlen);
     return (stats.bind.last_return = ret);
 }
 
 int __wrap_connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
 {
     if (!(wrap_monitoring && monitored.connect)) {
-        return __real_connect(sockfd, addr, addrlen);
+        return socket_connect(sockfd, addr, addrlen);
     }
     stats.connect.called++;
+    struct callsite_t *callsite = CALLSITE("connect");
     stats.connect.last_params = (struct params_connect_t) {
         .sockfd = sockfd,
         .addr = addr,
         .addrlen = addrlen
     };
     if (FAIL(failures.connect)) {
+        callsite_failed(callsite);
         failures.connect = NEXT(failures.connect);
         errno = failures.connect_errno;
         return (stats.connect.last_return = failures.connect_ret);
     }
     failures.connect = NEXT(failures.connect);
     int ret = -2;
-    ret = __real_connect(sockfd, addr, addrlen);
+    ret = socket_connect(sockfd, addr, addrlen);
     return (stats.connect.last_return = ret);
 }
 
 int __wrap_listen(int sockfd, int backlog)
 {
     if (!(wrap_monitoring && monitored.listen)) {
-        return __real_listen(sockfd, backlog);
+        return socket_listen(sockfd, backlog);
     }
     stats.listen.called++;
+    struct callsite_t *callsite = CALLSITE("listen");
     stats.listen.last_params = (struct params_listen_t) {
         .sockfd = sockfd,
         .backlog = backlog
     };
     if (FAIL(failures.listen)) {
+        callsite_failed(callsite);
         failures.listen = NEXT(failures.listen);
         errno = failures.listen_errno;
         return (stats.listen.last_return = failures.listen_ret);
     }
     failures.listen = NEXT(failures.listen);
     int ret = -2;
-    ret = __real_listen(sockfd, backlog);
+    ret = socket_listen(sockfd, backlog);
     return (stats.listen.last_return = ret);
 }
 
 int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout)
 {
     if (!(wrap_monitoring && monitored.poll)) {
-        return __real_poll(fds, nfds, timeout);
+        return simnet_poll(fds, nfds, timeout);
     }
     stats.poll.called++;
+    struct callsite_t *callsite = CALLSITE("poll");
     stats.poll.last_params = (struct params_poll_t) {
         .fds_ptr = fds,
         .nfds = nfds,
@@ -189,13 +323,14 @@ int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout)
         .fds_copy = NULL
     };
     if (FAIL(failures.poll)) {
+        callsite_failed(callsite);
         failures.poll = NEXT(failures.poll);
         errno = failures.poll_errno;
         return (stats.poll.last_return = failures.poll_ret);
     }
     failures.poll = NEXT(failures.poll);
     int ret = -2;
-    ret = __real_poll(fds, nfds, timeout);
+    ret = simnet_poll(fds, nfds, timeout);
     if (! (ret == -1 && errno == EFAULT)) {
         struct pollfd *tmp = malloc(nfds * sizeof(struct pollfd));
         if (tmp) {
@@ -209,9 +344,10 @@ int __wrap_poll(struct pollfd *fds, nfds_t nfds, int timeout)
 ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags)
 {
     if (!(wrap_monitoring && monitored.recv)) {
-        return __real_recv(sockfd, buf, len, flags);
+        return socket_recv(sockfd, buf, len, flags);
     }
     stats.recv.called++;
+    struct callsite_t *callsite = CALLSITE("recv");
     stats.recv_all.called++;
     stats.recv.last_params = (struct params_recv_t) {
         .sockfd = sockfd,
@@ -220,6 +356,7 @@ ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags)
         .flags = flags
     };
     if (FAIL(failures.recv)) {
+        callsite_failed(callsite);
         failures.recv = NEXT(failures.recv);
         errno = failures.recv_errno;
         return (stats.recv.last_return = failures.recv_ret);
@@ -229,18 +366,21 @@ ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags)
     if (fd_is_read_buffered(sockfd)) {
         ret = read_handle_buffer(sockfd, buf, len, flags);
     } else {
-        ret = __real_recv(sockfd, buf, len, flags);
+        ret = socket_recv(sockfd, buf, len, flags);
     }
+    io_stats_add(&stats.recv.io, len, ret);
+    callsite_bytes(callsite, ret);
     return (stats.recv.last_return = ret);
 }
 
 ssize_t __wrap_recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen)
 {
     if (!(wrap_monitoring && monitored.recvfrom)) {
-        return __real_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
+        return socket_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
     }
     socklen_t old_addrlen = (addrlen == NULL ? 0 : *addrlen); // May crash
     stats.recvfrom.called++;
+    struct callsite_t *callsite = CALLSITE("recvfrom");
     stats.recv_all.called++;
     stats.recvfrom.last_params = (struct params_recvfrom_t) {
         .sockfd = sockfd,
@@ -253,31 +393,44 @@ ssize_t __wrap_recvfrom(int sockfd, void *buf, size_t len, int flags, struct soc
     stats.recvfrom.last_returned_addr.addrlen = 0;
     memset(&(stats.recvfrom.last_returned_addr.src_addr), 0, sizeof(struct sockaddr_storage));
     if (FAIL(failures.recvfrom)) {
+        callsite_failed(callsite);
         failures.recvfrom = NEXT(failures.recvfrom);
         errno = failures.recvfrom_errno;
         return (stats.recv.last_return = failures.recvfrom_ret);
     }
     failures.recvfrom = NEXT(failures.recvfrom);
     ssize_t ret = -1;
-    if (fd_is_read_buffered(sockfd) && src_addr == NULL && addrlen == NULL) {
-        ret = read_handle_buffer(sockfd, buf, len, flags);
+    if (fd_is_read_buffered(sockfd)) {
+        struct iovec iov = { .iov_base = buf, .iov_len = len };
+        struct msghdr msg = {
+            .msg_name = src_addr,
+            .msg_namelen = (addrlen == NULL ? 0 : *addrlen),
+            .msg_iov = &iov,
+            .msg_iovlen = 1
+        };
+        ret = read_handle_buffer_msg(sockfd, &msg, flags);
+        if (ret >= 0 && addrlen != NULL) {
+            *addrlen = msg.msg_namelen;
+        }
     } else {
-        ret = __real_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
+        ret = socket_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
     }
     if (ret >= 0 && src_addr != NULL) {
         // Same justification as in accept
         stats.recvfrom.last_returned_addr.addrlen = *addrlen;
         memcpy(&(stats.recvfrom.last_returned_addr.src_addr), src_addr, MIN(old_addrlen, *addrlen));
     }
+    callsite_bytes(callsite, ret);
     return (stats.recvfrom.last_return = ret);
 }
 
 ssize_t __wrap_recvmsg(int sockfd, struct msghdr *msg, int flags)
 {
     if (!(wrap_monitoring && monitored.recvmsg)) {
-        return __real_recvmsg(sockfd, msg, flags);
+        return socket_recvmsg(sockfd, msg, flags);
     }
     stats.recvmsg.called++;
+    struct callsite_t *callsite = CALLSITE("recvmsg");
     stats.recv_all.called++;
     stats.recvmsg.last_params = (struct params_recvmsg_t) {
         .sockfd = sockfd,
@@ -287,26 +440,34 @@ ssize_t __wrap_recvmsg(int sockfd, struct msghdr *msg, int flags)
     // Reinit struct
     memset(&(stats.recvmsg.last_returned_msg), 0, sizeof(struct msghdr));
     if (FAIL(failures.recvmsg)) {
+        callsite_failed(callsite);
         failures.recvmsg = NEXT(failures.recvmsg);
         errno = failures.recvmsg_errno;
         return (stats.recvmsg.last_return = failures.recvmsg_ret);
     }
     failures.recvmsg = NEXT(failures.recvmsg);
     ssize_t ret = -1;
-    ret = __real_recvmsg(sockfd, msg, flags);
+    if (fd_is_read_buffered(sockfd)) {
+        // Scattered directly into msg_iov
+        ret = read_handle_buffer_msg(sockfd, msg, flags);
+    } else {
+        ret = socket_recvmsg(sockfd, msg, flags);
+    }
     if (ret == 0) {
         // Assume that msg doesn't point to an invalid location
         memcpy(&(stats.recvmsg.last_returned_msg), msg, sizeof(struct msghdr));
     }
+    callsite_bytes(callsite, ret);
     return ret;
 }
 
 int __wrap_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout)
 {
     if (!(wrap_monitoring && monitored.select)) {
-        return __real_select(nfds, readfds, writefds, exceptfds, timeout);
+        return simnet_select(nfds, readfds, writefds, exceptfds, timeout);
     }
     stats.select.called++;
+    struct callsite_t *callsite = CALLSITE("select");
     stats.select.last_params = (struct params_select_t) {
         .nfds = nfds,
         .readfds_ptr = readfds,
@@ -319,22 +480,24 @@ int __wrap_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds
         .timeout = *timeout
     };
     if (FAIL(failures.select)) {
+        callsite_failed(callsite);
         failures.select = NEXT(failures.select);
         errno = failures.select_errno;
         return (stats.select.last_return = failures.select_ret);
     }
     failures.select = NEXT(failures.select);
     int ret = -1;
-    ret = __real_select(nfds, readfds, writefds, exceptfds, timeout);
+    ret = simnet_select(nfds, readfds, writefds, exceptfds, timeout);
     return ret;
 }
 
 ssize_t __wrap_send(int sockfd, const void *buf, size_t len, int flags)
 {
     if (!(wrap_monitoring && monitored.send)) {
-        return __real_send(sockfd, buf, len, flags);
+        return socket_send(sockfd, buf, len, flags);
     }
     stats.send.called++;
+    struct callsite_t *callsite = CALLSITE("send");
     stats.send_all.called++;
     stats.send.last_params = (struct params_send_t) {
         .sockfd = sockfd,
@@ -343,22 +506,31 @@ ssize_t __wrap_send(int sockfd, const void *buf, size_t len, int flags)
         .flags = flags
     };
     if (FAIL(failures.send)) {
+        callsite_failed(callsite);
         failures.send = NEXT(failures.send);
         errno = failures.send_errno;
         return (stats.send.last_return = failures.send_ret);
     }
     failures.send = NEXT(failures.send);
     ssize_t ret = -1;
-    ret = __real_send(sockfd, buf, len, flags);
+    if (fd_is_write_buffered(sockfd)) {
+        struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+        ret = write_handle_buffer(sockfd, &iov, 1, flags);
+    } else {
+        ret = socket_send(sockfd, buf, len, flags);
+    }
+    io_stats_add(&stats.send.io, len, ret);
+    callsite_bytes(callsite, ret);
     return (stats.send.last_return = ret);
 }
 
 ssize_t __wrap_sendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen)
 {
     if (!(wrap_monitoring && monitored.sendto)) {
-        return __real_sendto(sockfd, buf, len, flags, dest_addr, addrlen);
+        return socket_sendto(sockfd, buf, len, flags, dest_addr, addrlen);
     }
     stats.sendto.called++;
+    struct callsite_t *callsite = CALLSITE("sendto");
     stats.send_all.called++;
     stats.sendto.last_params = (struct params_sendto_t) {
         .sockfd = sockfd,
@@ -373,22 +545,30 @@ ssize_t __wrap_sendto(int sockfd, const void *buf, size_t len, int flags, const
         memcpy(&(stats.sendto.last_params.dest_addr), dest_addr, MIN(addrlen, sizeof(struct sockaddr_storage))); // May segfault if dest_addr is badly defined.
     }*/
     if (FAIL(failures.sendto)) {
+        callsite_failed(callsite);
         failures.sendto = NEXT(failures.sendto);
         errno = failures.sendto_errno;
         return (stats.sendto.last_return = failures.sendto_ret);
     }
     failures.sendto = NEXT(failures.sendto);
     ssize_t ret = -1;
-    ret = __real_sendto(sockfd, buf, len, flags, dest_addr, addrlen);
+    if (fd_is_write_buffered(sockfd) && dest_addr == NULL) {
+        struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+        ret = write_handle_buffer(sockfd, &iov, 1, flags);
+    } else {
+        ret = socket_sendto(sockfd, buf, len, flags, dest_addr, addrlen);
+    }
+    callsite_bytes(callsite, ret);
     return (stats.sendto.last_return = ret);
 }
 
 ssize_t __wrap_sendmsg(int sockfd, const struct msghdr *msg, int flags)
 {
     if (!(wrap_monitoring && monitored.sendmsg)) {
-        return __real_sendmsg(sockfd, msg, flags);
+        return socket_sendmsg(sockfd, msg, flags);
     }
     stats.sendmsg.called++;
+    struct callsite_t *callsite = CALLSITE("sendmsg");
     stats.send_all.called++;
     stats.sendmsg.last_params = (struct params_sendmsg_t) {
         .sockfd = sockfd,
@@ -400,59 +580,101 @@ ssize_t __wrap_sendmsg(int sockfd, const struct msghdr *msg, int flags)
         memcpy(&(stats.sendmsg.last_params.msg), msg, sizeof(struct msghdr));
     }*/
     if (FAIL(failures.sendmsg)) {
+        callsite_failed(callsite);
         failures.sendmsg = NEXT(failures.sendmsg);
         errno = failures.sendmsg_errno;
         return (stats.sendmsg.last_return = failures.sendmsg_ret);
     }
     failures.sendmsg = NEXT(failures.sendmsg);
     ssize_t ret = -1;
-    ret = __real_sendmsg(sockfd, msg, flags);
+    if (fd_is_write_buffered(sockfd) && msg->msg_name == NULL) {
+        ret = write_handle_buffer(sockfd, msg->msg_iov, msg->msg_iovlen, flags);
+    } else {
+        ret = socket_sendmsg(sockfd, msg, flags);
+    }
+    callsite_bytes(callsite, ret);
     return ret;
 }
 
 int __wrap_shutdown(int sockfd, int how)
 {
     if (!(wrap_monitoring && monitored.shutdown)) {
-        return __real_shutdown(sockfd, how);
+        return socket_shutdown(sockfd, how);
     }
     stats.shutdown.called++;
+    struct callsite_t *callsite = CALLSITE("shutdown");
     stats.shutdown.last_params = (struct params_shutdown_t) {
         .sockfd = sockfd,
         .how = how
     };
     if (FAIL(failures.shutdown)) {
+        callsite_failed(callsite);
         failures.shutdown = NEXT(failures.shutdown);
         errno = failures.shutdown_errno;
         return (stats.shutdown.last_return = failures.shutdown_ret);
     }
     failures.shutdown = NEXT(failures.shutdown);
     int ret = -1;
-    ret = __real_shutdown(sockfd, how);
+    ret = socket_shutdown(sockfd, how);
     return ret;
 }
 
 int __wrap_socket(int domain, int type, int protocol)
 {
     if (!(wrap_monitoring && monitored.socket)) {
-        return __real_socket(domain, type, protocol);
+        return socket_create(domain, type, protocol);
     }
     stats.socket.called++;
+    struct callsite_t *callsite = CALLSITE("socket");
     stats.socket.last_params = (struct params_socket_t) {
         .domain = domain,
         .type = type,
         .protocol = protocol
     };
     if (FAIL(failures.socket)) {
+        callsite_failed(callsite);
         failures.socket = NEXT(failures.socket);
         errno = failures.socket_errno;
         return (stats.socket.last_return = failures.socket_ret);
     }
     failures.socket = NEXT(failures.socket);
     int ret = -2;
-    ret = __real_socket(domain, type, protocol);
+    ret = socket_create(domain, type, protocol);
     return (stats.socket.last_return = ret);
 }
 
+/**
+ * setsockopt, getsockopt, getsockname and getpeername are not monitored:
+ * they are only wrapped to serve the sockets of the simulated network.
+ */
+int __wrap_setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen)
+{
+    if (simnet_owns(sockfd))
+        return simnet_setsockopt(sockfd, level, optname, optval, optlen);
+    return __real_setsockopt(sockfd, level, optname, optval, optlen);
+}
+
+int __wrap_getsockopt(int sockfd, int level, int optname, void *optval, socklen_t *optlen)
+{
+    if (simnet_owns(sockfd))
+        return simnet_getsockopt(sockfd, level, optname, optval, optlen);
+    return __real_getsockopt(sockfd, level, optname, optval, optlen);
+}
+
+int __wrap_getsockname(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    if (simnet_owns(sockfd))
+        return simnet_getsockname(sockfd, addr, addrlen);
+    return __real_getsockname(sockfd, addr, addrlen);
+}
+
+int __wrap_getpeername(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    if (simnet_owns(sockfd))
+        return simnet_getpeername(sockfd, addr, addrlen);
+    return __real_getpeername(sockfd, addr, addrlen);
+}
+
 // Additionnal functions
 
 void reinit_network_socket_stats()
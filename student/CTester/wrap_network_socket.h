@@ -145,6 +145,7 @@ struct stats_recv_t {
     int called;
     struct params_recv_t last_params;
     ssize_t last_return;
+    struct stats_io_t io; // bytes received by the successful calls
 };
 struct stats_recvfrom_t {
     int called;
@@ -215,6 +216,7 @@ struct stats_send_t {
     int called;
     struct params_send_t last_params;
     ssize_t last_return;
+    struct stats_io_t io; // bytes sent by the successful calls
 };
 struct stats_sendto_t {
     int called;
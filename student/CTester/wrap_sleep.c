@@ -33,9 +33,11 @@ unsigned int __wrap_sleep(unsigned int time) {
   }
 
   stats.sleep.called++;
+  struct callsite_t *callsite = CALLSITE("sleep");
   stats.sleep.last_arg = time;
   // being monitored
   if (FAIL(failures.sleep)) {
+    callsite_failed(callsite);
     failures.sleep=NEXT(failures.sleep);
     stats.sleep.last_return=failures.sleep_ret;
     return failures.sleep_ret;
@@ -0,0 +1,476 @@
+/*
+ * Wrapper for fopen, fclose, fread, fwrite, fgets, fputs, fprintf,
+ * fflush, setvbuf, printf, puts, putchar, fputc, putc, fgetc, getc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdio_ext.h>
+#include <string.h>
+
+#include "wrap.h"
+
+FILE   *__real_fopen(const char *pathname, const char *mode);
+int     __real_fclose(FILE *stream);
+size_t  __real_fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
+size_t  __real_fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream);
+char   *__real_fgets(char *s, int size, FILE *stream);
+int     __real_fputs(const char *s, FILE *stream);
+int     __real_fflush(FILE *stream);
+int     __real_setvbuf(FILE *stream, char *buf, int mode, size_t size);
+int     __real_puts(const char *s);
+int     __real_putchar(int c);
+int     __real_fputc(int c, FILE *stream);
+int     __real_putc(int c, FILE *stream);
+int     __real_fgetc(FILE *stream);
+int     __real_getc(FILE *stream);
+
+
+extern bool wrap_monitoring;
+extern struct wrap_stats_t stats;
+extern struct wrap_monitor_t monitored;
+extern struct wrap_fail_t failures;
+
+
+/**
+ * Sets the error indicator of the stream, as a failed write
+ * to its file descriptor would have done.
+ * glibc has no function for this, but ferror only tests this flag.
+ */
+static void stream_set_error(FILE *stream)
+{
+    stream->_flags |= _IO_ERR_SEEN;
+}
+
+/**
+ * Records an output call that added len bytes to the stream,
+ * which had pending bytes in its buffer before the call.
+ * If less than pending + len bytes are left in the buffer,
+ * some of them have been written to the file descriptor.
+ */
+static void stdio_account_write(FILE *stream, size_t pending, size_t len)
+{
+    stats.stdio.write_calls++;
+    if (__fpending(stream) < pending + len) {
+        stats.stdio.flushes++;
+    }
+}
+
+double stdio_calls_per_flush()
+{
+    if (stats.stdio.flushes == 0) {
+        return 0;
+    }
+    return (double) stats.stdio.write_calls / stats.stdio.flushes;
+}
+
+
+/**
+ * Wrap functions.
+ */
+
+FILE *__wrap_fopen(const char *pathname, const char *mode)
+{
+    if (!(wrap_monitoring && monitored.fopen)) {
+        return __real_fopen(pathname, mode);
+    }
+    stats.fopen.called++;
+    struct callsite_t *callsite = CALLSITE("fopen");
+    stats.fopen.last_params = (struct params_fopen_t) {
+        .pathname = pathname,
+        .mode = mode
+    };
+    if (FAIL(failures.fopen)) {
+        callsite_failed(callsite);
+        failures.fopen = NEXT(failures.fopen);
+        errno = failures.fopen_errno;
+        return (stats.fopen.last_return = failures.fopen_ret);
+    }
+    failures.fopen = NEXT(failures.fopen);
+    return (stats.fopen.last_return = __real_fopen(pathname, mode));
+}
+
+/*
+ * Even when it fails, fclose dissociates the stream from its file,
+ * so the stream is always closed, and only the return value and errno
+ * are changed by an injected failure.
+ */
+int __wrap_fclose(FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fclose)) {
+        return __real_fclose(stream);
+    }
+    stats.fclose.called++;
+    struct callsite_t *callsite = CALLSITE("fclose");
+    stats.fclose.last_params = (struct params_fclose_t) {
+        .stream = stream
+    };
+    if (__fpending(stream) > 0) {
+        stats.stdio.flushes++;
+    }
+    int ret = __real_fclose(stream);
+    if (FAIL(failures.fclose)) {
+        callsite_failed(callsite);
+        failures.fclose = NEXT(failures.fclose);
+        errno = failures.fclose_errno;
+        return (stats.fclose.last_return = failures.fclose_ret);
+    }
+    failures.fclose = NEXT(failures.fclose);
+    return (stats.fclose.last_return = ret);
+}
+
+size_t __wrap_fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fread)) {
+        return __real_fread(ptr, size, nmemb, stream);
+    }
+    stats.fread.called++;
+    struct callsite_t *callsite = CALLSITE("fread");
+    stats.fread.last_params = (struct params_fread_t) {
+        .ptr = ptr,
+        .size = size,
+        .nmemb = nmemb,
+        .stream = stream
+    };
+    if (FAIL(failures.fread)) {
+        callsite_failed(callsite);
+        failures.fread = NEXT(failures.fread);
+        errno = failures.fread_errno;
+        stream_set_error(stream);
+        return (stats.fread.last_return = failures.fread_ret);
+    }
+    failures.fread = NEXT(failures.fread);
+    size_t ret = __real_fread(ptr, size, nmemb, stream);
+    callsite_bytes(callsite, ret * size);
+    return (stats.fread.last_return = ret);
+}
+
+size_t __wrap_fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fwrite)) {
+        return __real_fwrite(ptr, size, nmemb, stream);
+    }
+    stats.fwrite.called++;
+    struct callsite_t *callsite = CALLSITE("fwrite");
+    stats.fwrite.last_params = (struct params_fwrite_t) {
+        .ptr = ptr,
+        .size = size,
+        .nmemb = nmemb,
+        .stream = stream
+    };
+    if (FAIL(failures.fwrite)) {
+        callsite_failed(callsite);
+        failures.fwrite = NEXT(failures.fwrite);
+        errno = failures.fwrite_errno;
+        stream_set_error(stream);
+        return (stats.fwrite.last_return = failures.fwrite_ret);
+    }
+    failures.fwrite = NEXT(failures.fwrite);
+    size_t pending = __fpending(stream);
+    size_t ret = __real_fwrite(ptr, size, nmemb, stream);
+    stdio_account_write(stream, pending, ret * size);
+    callsite_bytes(callsite, ret * size);
+    return (stats.fwrite.last_return = ret);
+}
+
+char *__wrap_fgets(char *s, int size, FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fgets)) {
+        return __real_fgets(s, size, stream);
+    }
+    stats.fgets.called++;
+    struct callsite_t *callsite = CALLSITE("fgets");
+    stats.fgets.last_params = (struct params_fgets_t) {
+        .s = s,
+        .size = size,
+        .stream = stream
+    };
+    if (FAIL(failures.fgets)) {
+        callsite_failed(callsite);
+        failures.fgets = NEXT(failures.fgets);
+        errno = failures.fgets_errno;
+        stream_set_error(stream);
+        return (stats.fgets.last_return = failures.fgets_ret);
+    }
+    failures.fgets = NEXT(failures.fgets);
+    char *ret = __real_fgets(s, size, stream);
+    if (ret != NULL)
+        callsite_bytes(callsite, strlen(s));
+    return (stats.fgets.last_return = ret);
+}
+
+int __wrap_fputs(const char *s, FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fputs)) {
+        return __real_fputs(s, stream);
+    }
+    stats.fputs.called++;
+    struct callsite_t *callsite = CALLSITE("fputs");
+    stats.fputs.last_params = (struct params_fputs_t) {
+        .s = s,
+        .stream = stream
+    };
+    if (FAIL(failures.fputs)) {
+        callsite_failed(callsite);
+        failures.fputs = NEXT(failures.fputs);
+        errno = failures.fputs_errno;
+        stream_set_error(stream);
+        return (stats.fputs.last_return = failures.fputs_ret);
+    }
+    failures.fputs = NEXT(failures.fputs);
+    size_t pending = __fpending(stream);
+    int ret = __real_fputs(s, stream);
+    if (ret >= 0) {
+        stdio_account_write(stream, pending, strlen(s));
+        callsite_bytes(callsite, strlen(s));
+    }
+    return (stats.fputs.last_return = ret);
+}
+
+int __wrap_fprintf(FILE *stream, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    if (!(wrap_monitoring && monitored.fprintf)) {
+        int ret = vfprintf(stream, format, ap);
+        va_end(ap);
+        return ret;
+    }
+    stats.fprintf.called++;
+    struct callsite_t *callsite = CALLSITE("fprintf");
+    stats.fprintf.last_params = (struct params_fprintf_t) {
+        .stream = stream,
+        .format = format
+    };
+    if (FAIL(failures.fprintf)) {
+        va_end(ap);
+        callsite_failed(callsite);
+        failures.fprintf = NEXT(failures.fprintf);
+        errno = failures.fprintf_errno;
+        stream_set_error(stream);
+        return (stats.fprintf.last_return = failures.fprintf_ret);
+    }
+    failures.fprintf = NEXT(failures.fprintf);
+    size_t pending = __fpending(stream);
+    int ret = vfprintf(stream, format, ap);
+    va_end(ap);
+    if (ret >= 0) {
+        stdio_account_write(stream, pending, ret);
+        callsite_bytes(callsite, ret);
+    }
+    return (stats.fprintf.last_return = ret);
+}
+
+/*
+ * fflush(NULL) flushes all the streams, and is counted as one flush.
+ */
+int __wrap_fflush(FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fflush)) {
+        return __real_fflush(stream);
+    }
+    stats.fflush.called++;
+    struct callsite_t *callsite = CALLSITE("fflush");
+    stats.fflush.last_params = (struct params_fflush_t) {
+        .stream = stream
+    };
+    if (FAIL(failures.fflush)) {
+        callsite_failed(callsite);
+        failures.fflush = NEXT(failures.fflush);
+        errno = failures.fflush_errno;
+        if (stream != NULL) {
+            stream_set_error(stream);
+        }
+        return (stats.fflush.last_return = failures.fflush_ret);
+    }
+    failures.fflush = NEXT(failures.fflush);
+    if (stream == NULL || __fpending(stream) > 0) {
+        stats.stdio.flushes++;
+    }
+    return (stats.fflush.last_return = __real_fflush(stream));
+}
+
+int __wrap_setvbuf(FILE *stream, char *buf, int mode, size_t size)
+{
+    if (!(wrap_monitoring && monitored.setvbuf)) {
+        return __real_setvbuf(stream, buf, mode, size);
+    }
+    stats.setvbuf.called++;
+    struct callsite_t *callsite = CALLSITE("setvbuf");
+    stats.setvbuf.last_params = (struct params_setvbuf_t) {
+        .stream = stream,
+        .buf = buf,
+        .mode = mode,
+        .size = size
+    };
+    if (FAIL(failures.setvbuf)) {
+        callsite_failed(callsite);
+        failures.setvbuf = NEXT(failures.setvbuf);
+        errno = failures.setvbuf_errno;
+        return (stats.setvbuf.last_return = failures.setvbuf_ret);
+    }
+    failures.setvbuf = NEXT(failures.setvbuf);
+    return (stats.setvbuf.last_return = __real_setvbuf(stream, buf, mode, size));
+}
+
+int __wrap_printf(const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    if (!(wrap_monitoring && monitored.printf)) {
+        int ret = vprintf(format, ap);
+        va_end(ap);
+        return ret;
+    }
+    stats.printf.called++;
+    struct callsite_t *callsite = CALLSITE("printf");
+    stats.printf.last_params = (struct params_printf_t) {
+        .format = format
+    };
+    if (FAIL(failures.printf)) {
+        va_end(ap);
+        callsite_failed(callsite);
+        failures.printf = NEXT(failures.printf);
+        errno = failures.printf_errno;
+        stream_set_error(stdout);
+        return (stats.printf.last_return = failures.printf_ret);
+    }
+    failures.printf = NEXT(failures.printf);
+    size_t pending = __fpending(stdout);
+    int ret = vprintf(format, ap);
+    va_end(ap);
+    if (ret >= 0) {
+        stdio_account_write(stdout, pending, ret);
+        callsite_bytes(callsite, ret);
+    }
+    return (stats.printf.last_return = ret);
+}
+
+int __wrap_puts(const char *s)
+{
+    if (!(wrap_monitoring && monitored.puts)) {
+        return __real_puts(s);
+    }
+    stats.puts.called++;
+    struct callsite_t *callsite = CALLSITE("puts");
+    stats.puts.last_params = (struct params_puts_t) {
+        .s = s
+    };
+    if (FAIL(failures.puts)) {
+        callsite_failed(callsite);
+        failures.puts = NEXT(failures.puts);
+        errno = failures.puts_errno;
+        stream_set_error(stdout);
+        return (stats.puts.last_return = failures.puts_ret);
+    }
+    failures.puts = NEXT(failures.puts);
+    size_t pending = __fpending(stdout);
+    int ret = __real_puts(s);
+    if (ret >= 0) {
+        stdio_account_write(stdout, pending, strlen(s) + 1);
+        callsite_bytes(callsite, strlen(s) + 1);
+    }
+    return (stats.puts.last_return = ret);
+}
+
+/**
+ * Common part of the wrappers of fputc, putc and putchar, whose call site
+ * is callsite; real is the function called when the call doesn't fail.
+ */
+static int stdio_fputc(struct callsite_t *callsite, int c, FILE *stream, int (*real)(int, FILE *))
+{
+    stats.fputc.last_params = (struct params_fputc_t) {
+        .c = c,
+        .stream = stream
+    };
+    if (FAIL(failures.fputc)) {
+        callsite_failed(callsite);
+        failures.fputc = NEXT(failures.fputc);
+        errno = failures.fputc_errno;
+        stream_set_error(stream);
+        return (stats.fputc.last_return = failures.fputc_ret);
+    }
+    failures.fputc = NEXT(failures.fputc);
+    size_t pending = __fpending(stream);
+    int ret = real(c, stream);
+    if (ret != EOF) {
+        stdio_account_write(stream, pending, 1);
+        callsite_bytes(callsite, 1);
+    }
+    return (stats.fputc.last_return = ret);
+}
+
+int __wrap_fputc(int c, FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fputc)) {
+        return __real_fputc(c, stream);
+    }
+    stats.fputc.called++;
+    return stdio_fputc(CALLSITE("fputc"), c, stream, __real_fputc);
+}
+
+int __wrap_putc(int c, FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fputc)) {
+        return __real_putc(c, stream);
+    }
+    stats.fputc.called++;
+    return stdio_fputc(CALLSITE("fputc"), c, stream, __real_putc);
+}
+
+int __wrap_putchar(int c)
+{
+    if (!(wrap_monitoring && monitored.fputc)) {
+        return __real_putchar(c);
+    }
+    stats.fputc.called++;
+    return stdio_fputc(CALLSITE("fputc"), c, stdout, __real_fputc);
+}
+
+/**
+ * Common part of the wrappers of fgetc and getc, whose call site is callsite.
+ */
+static int stdio_fgetc(struct callsite_t *callsite, FILE *stream, int (*real)(FILE *))
+{
+    stats.fgetc.last_params = (struct params_fgetc_t) {
+        .stream = stream
+    };
+    if (FAIL(failures.fgetc)) {
+        callsite_failed(callsite);
+        failures.fgetc = NEXT(failures.fgetc);
+        errno = failures.fgetc_errno;
+        stream_set_error(stream);
+        return (stats.fgetc.last_return = failures.fgetc_ret);
+    }
+    failures.fgetc = NEXT(failures.fgetc);
+    return (stats.fgetc.last_return = real(stream));
+}
+
+int __wrap_fgetc(FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fgetc)) {
+        return __real_fgetc(stream);
+    }
+    stats.fgetc.called++;
+    return stdio_fgetc(CALLSITE("fgetc"), stream, __real_fgetc);
+}
+
+int __wrap_getc(FILE *stream)
+{
+    if (!(wrap_monitoring && monitored.fgetc)) {
+        return __real_getc(stream);
+    }
+    stats.fgetc.called++;
+    return stdio_fgetc(CALLSITE("fgetc"), stream, __real_getc);
+}
@@ -0,0 +1,190 @@
+/*
+ * Wrapper for fopen, fclose, fread, fwrite, fgets, fputs, fprintf,
+ * fflush, setvbuf, printf, puts, fputc, fgetc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WRAP_STDIO_H_
+#define __WRAP_STDIO_H_
+
+#include <stdio.h>
+
+/**
+ * Structures for fopen, fclose, fread, fwrite, fgets, fputs, fprintf,
+ * fflush, setvbuf, printf, puts, fputc and fgetc, with the usual stats fields.
+ * The failures of the functions working on a stream also set the error
+ * indicator of this stream, so that ferror returns true afterwards.
+ */
+struct params_fopen_t {
+    const char *pathname;
+    const char *mode;
+};
+struct stats_fopen_t {
+    int called;
+    struct params_fopen_t last_params;
+    FILE *last_return;
+};
+
+struct params_fclose_t {
+    FILE *stream;
+};
+struct stats_fclose_t {
+    int called;
+    struct params_fclose_t last_params;
+    int last_return;
+};
+
+struct params_fread_t {
+    void *ptr;
+    size_t size;
+    size_t nmemb;
+    FILE *stream;
+};
+struct stats_fread_t {
+    int called;
+    struct params_fread_t last_params;
+    size_t last_return;
+};
+
+struct params_fwrite_t {
+    const void *ptr;
+    size_t size;
+    size_t nmemb;
+    FILE *stream;
+};
+struct stats_fwrite_t {
+    int called;
+    struct params_fwrite_t last_params;
+    size_t last_return;
+};
+
+struct params_fgets_t {
+    char *s;
+    int size;
+    FILE *stream;
+};
+struct stats_fgets_t {
+    int called;
+    struct params_fgets_t last_params;
+    char *last_return;
+};
+
+/**
+ * The compiler replaces fprintf(f, "%s", s) by fputs(s, f),
+ * so fputs is wrapped too.
+ */
+struct params_fputs_t {
+    const char *s;
+    FILE *stream;
+};
+struct stats_fputs_t {
+    int called;
+    struct params_fputs_t last_params;
+    int last_return;
+};
+
+struct params_fprintf_t {
+    FILE *stream;
+    const char *format;
+};
+struct stats_fprintf_t {
+    int called;
+    struct params_fprintf_t last_params;
+    int last_return;
+};
+
+/**
+ * The compiler replaces printf("%s\n", s) by puts(s), and printf("x")
+ * or fprintf(f, "x") by putchar('x') or fputc('x', f), so these are
+ * wrapped too. putc and putchar are the same function as fputc in
+ * the C library, and are counted in stats.fputc (with stream stdout
+ * for putchar); getc is counted in stats.fgetc.
+ */
+struct params_printf_t {
+    const char *format;
+};
+struct stats_printf_t {
+    int called;
+    struct params_printf_t last_params;
+    int last_return;
+};
+
+struct params_puts_t {
+    const char *s;
+};
+struct stats_puts_t {
+    int called;
+    struct params_puts_t last_params;
+    int last_return;
+};
+
+struct params_fputc_t {
+    int c;
+    FILE *stream;
+};
+struct stats_fputc_t {
+    int called;
+    struct params_fputc_t last_params;
+    int last_return;
+};
+
+struct params_fgetc_t {
+    FILE *stream;
+};
+struct stats_fgetc_t {
+    int called;
+    struct params_fgetc_t last_params;
+    int last_return;
+};
+
+struct params_fflush_t {
+    FILE *stream;
+};
+struct stats_fflush_t {
+    int called;
+    struct params_fflush_t last_params;
+    int last_return;
+};
+
+struct params_setvbuf_t {
+    FILE *stream;
+    char *buf;
+    int mode; // _IONBF, _IOLBF or _IOFBF
+    size_t size;
+};
+struct stats_setvbuf_t {
+    int called;
+    struct params_setvbuf_t last_params;
+    int last_return;
+};
+
+/**
+ * Buffering behaviour of the monitored stdio output functions
+ * (fwrite, fputs, fprintf, printf, puts, fputc, fflush and fclose).
+ * A flush is counted each time one of these calls moved data
+ * from the buffer of the stream to the kernel, whether it was asked
+ * explicitly or not: with an unbuffered stream, every write call flushes.
+ */
+struct stats_stdio_t {
+    int write_calls; // Calls to fwrite, fputs, fprintf, printf, puts and fputc
+    int flushes; // Calls that wrote to the underlying file descriptor
+};
+
+/**
+ * Returns the number of stdio output calls per write to the underlying
+ * file descriptor, or 0 if nothing has been flushed.
+ * Buffered output should be well above 1.
+ */
+double stdio_calls_per_flush();
+
+#endif // __WRAP_STDIO_H_
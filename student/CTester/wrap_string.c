@@ -0,0 +1,164 @@
+/*
+ * Wrapper for strlen, strcpy, strcat, memcpy, memmove, memset, strcmp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "wrap.h"
+
+extern bool wrap_monitoring;
+extern struct wrap_stats_t stats;
+extern struct wrap_monitor_t monitored;
+
+
+double string_bytes_ratio(size_t input_size)
+{
+    uint64_t bytes = stats.strlen.bytes + stats.strcpy.bytes
+        + stats.strcat.bytes + stats.memcpy.bytes + stats.memmove.bytes
+        + stats.memset.bytes + stats.strcmp.bytes;
+    if (input_size == 0) {
+        return bytes;
+    }
+    return (double) bytes / input_size;
+}
+
+
+/**
+ * Wrap functions.
+ * They are only called by the code of the student, and call the functions
+ * of the libc directly when they are not monitored.
+ */
+
+size_t __wrap_strlen(const char *s)
+{
+    if (!(wrap_monitoring && monitored.strlen)) {
+        return strlen(s);
+    }
+    stats.strlen.called++;
+    struct callsite_t *callsite = CALLSITE("strlen");
+    stats.strlen.last_params.s = s;
+    size_t ret = strlen(s);
+    stats.strlen.bytes += ret + 1;
+    callsite_bytes(callsite, ret + 1);
+    return (stats.strlen.last_return = ret);
+}
+
+char *__wrap_strcpy(char *dest, const char *src)
+{
+    if (!(wrap_monitoring && monitored.strcpy)) {
+        return strcpy(dest, src);
+    }
+    stats.strcpy.called++;
+    struct callsite_t *callsite = CALLSITE("strcpy");
+    stats.strcpy.last_params = (struct params_strcpy_t) {
+        .dest = dest,
+        .src = src
+    };
+    size_t len = strlen(src) + 1;
+    memcpy(dest, src, len);
+    stats.strcpy.bytes += 2 * len;
+    callsite_bytes(callsite, 2 * len);
+    return (stats.strcpy.last_return = dest);
+}
+
+char *__wrap_strcat(char *dest, const char *src)
+{
+    if (!(wrap_monitoring && monitored.strcat)) {
+        return strcat(dest, src);
+    }
+    stats.strcat.called++;
+    struct callsite_t *callsite = CALLSITE("strcat");
+    stats.strcat.last_params = (struct params_strcat_t) {
+        .dest = dest,
+        .src = src
+    };
+    size_t start = strlen(dest);
+    size_t len = strlen(src) + 1;
+    memcpy(dest + start, src, len);
+    stats.strcat.bytes += start + 2 * len;
+    callsite_bytes(callsite, start + 2 * len);
+    return (stats.strcat.last_return = dest);
+}
+
+void *__wrap_memcpy(void *dest, const void *src, size_t n)
+{
+    if (!(wrap_monitoring && monitored.memcpy)) {
+        return memcpy(dest, src, n);
+    }
+    stats.memcpy.called++;
+    struct callsite_t *callsite = CALLSITE("memcpy");
+    stats.memcpy.last_params = (struct params_memcpy_t) {
+        .dest = dest,
+        .src = src,
+        .n = n
+    };
+    stats.memcpy.bytes += 2 * n;
+    callsite_bytes(callsite, 2 * n);
+    return (stats.memcpy.last_return = memcpy(dest, src, n));
+}
+
+void *__wrap_memmove(void *dest, const void *src, size_t n)
+{
+    if (!(wrap_monitoring && monitored.memmove)) {
+        return memmove(dest, src, n);
+    }
+    stats.memmove.called++;
+    struct callsite_t *callsite = CALLSITE("memmove");
+    stats.memmove.last_params = (struct params_memmove_t) {
+        .dest = dest,
+        .src = src,
+        .n = n
+    };
+    stats.memmove.bytes += 2 * n;
+    callsite_bytes(callsite, 2 * n);
+    return (stats.memmove.last_return = memmove(dest, src, n));
+}
+
+void *__wrap_memset(void *s, int c, size_t n)
+{
+    if (!(wrap_monitoring && monitored.memset)) {
+        return memset(s, c, n);
+    }
+    stats.memset.called++;
+    struct callsite_t *callsite = CALLSITE("memset");
+    stats.memset.last_params = (struct params_memset_t) {
+        .s = s,
+        .c = c,
+        .n = n
+    };
+    stats.memset.bytes += n;
+    callsite_bytes(callsite, n);
+    return (stats.memset.last_return = memset(s, c, n));
+}
+
+int __wrap_strcmp(const char *s1, const char *s2)
+{
+    if (!(wrap_monitoring && monitored.strcmp)) {
+        return strcmp(s1, s2);
+    }
+    stats.strcmp.called++;
+    struct callsite_t *callsite = CALLSITE("strcmp");
+    stats.strcmp.last_params = (struct params_strcmp_t) {
+        .s1 = s1,
+        .s2 = s2
+    };
+    // Same loop as strcmp, to know where it stops
+    size_t i = 0;
+    while (s1[i] != '\0' && s1[i] == s2[i]) {
+        i++;
+    }
+    stats.strcmp.bytes += 2 * (i + 1);
+    callsite_bytes(callsite, 2 * (i + 1));
+    return (stats.strcmp.last_return = (unsigned char) s1[i] - (unsigned char) s2[i]);
+}
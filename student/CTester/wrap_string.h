@@ -0,0 +1,122 @@
+/*
+ * Wrapper for strlen, strcpy, strcat, memcpy, memmove, memset, strcmp.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WRAP_STRING_H_
+#define __WRAP_STRING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * These functions are used everywhere, by CTester and by the tests too,
+ * so they are not wrapped with -Wl,-wrap: the Makefile renames them to
+ * __wrap_FUNC in student_code.o only, and only the calls made by the code
+ * of the student reach the wrappers.
+ * They cannot fail. Besides the usual fields, bytes counts the bytes
+ * that the calls have gone through, in the source and the destination:
+ * strcat goes through the whole destination string before appending to it,
+ * and strcmp stops at the first difference.
+ * Note that the compiler replaces some calls with constant arguments by
+ * other functions or by inline code, e.g. strlen("abc") by 3.
+ */
+struct params_strlen_t {
+    const char *s;
+};
+struct stats_strlen_t {
+    int called;
+    struct params_strlen_t last_params;
+    size_t last_return;
+    uint64_t bytes;
+};
+
+struct params_strcpy_t {
+    char *dest;
+    const char *src;
+};
+struct stats_strcpy_t {
+    int called;
+    struct params_strcpy_t last_params;
+    char *last_return;
+    uint64_t bytes;
+};
+
+struct params_strcat_t {
+    char *dest;
+    const char *src;
+};
+struct stats_strcat_t {
+    int called;
+    struct params_strcat_t last_params;
+    char *last_return;
+    uint64_t bytes;
+};
+
+struct params_memcpy_t {
+    void *dest;
+    const void *src;
+    size_t n;
+};
+struct stats_memcpy_t {
+    int called;
+    struct params_memcpy_t last_params;
+    void *last_return;
+    uint64_t bytes;
+};
+
+struct params_memmove_t {
+    void *dest;
+    const void *src;
+    size_t n;
+};
+struct stats_memmove_t {
+    int called;
+    struct params_memmove_t last_params;
+    void *last_return;
+    uint64_t bytes;
+};
+
+struct params_memset_t {
+    void *s;
+    int c;
+    size_t n;
+};
+struct stats_memset_t {
+    int called;
+    struct params_memset_t last_params;
+    void *last_return;
+    uint64_t bytes;
+};
+
+struct params_strcmp_t {
+    const char *s1;
+    const char *s2;
+};
+struct stats_strcmp_t {
+    int called;
+    struct params_strcmp_t last_params;
+    int last_return;
+    uint64_t bytes;
+};
+
+/**
+ * Returns the bytes gone through by all the monitored string functions,
+ * divided by input_size, the size of the input of the code of the student.
+ * A linear algorithm gives a ratio bounded by a small constant, while
+ * calling strlen in the condition of a loop over the input gives a ratio
+ * that grows with input_size.
+ */
+double string_bytes_ratio(size_t input_size);
+
+#endif // __WRAP_STRING_H_